@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ILIVE_TRACE_H
+#define ILIVE_TRACE_H
+
+#include <iostream>
+
+/**
+ * \ingroup sixlowpan
+ * \brief Trace points of the 6LoWPAN and RPL modules, chosen at compile time
+ *
+ * A trace point prints its message to std::clog if its level is at most
+ * ILIVE_TRACE_LEVEL. Otherwise it expands to nothing: the message is neither
+ * formatted nor even evaluated. The level defaults to ILIVE_TRACE_LEVEL_NONE
+ * and is raised when configuring, e.g.
+ *
+ * CXXFLAGS="-DILIVE_TRACE_LEVEL=3" ./waf configure
+ *
+ * Unlike NS_LOG, which tests the enabled components at run time, a disabled
+ * trace point costs nothing, so trace points may stay on the per-packet paths.
+ */
+
+#define ILIVE_TRACE_LEVEL_NONE   0
+#define ILIVE_TRACE_LEVEL_ERROR  1      // !< packets or states that should not happen
+#define ILIVE_TRACE_LEVEL_INFO   2      // !< rare protocol events
+#define ILIVE_TRACE_LEVEL_DEBUG  3      // !< per-packet processing steps
+#define ILIVE_TRACE_LEVEL_PACKET 4      // !< whole packet contents
+
+#ifndef ILIVE_TRACE_LEVEL
+#define ILIVE_TRACE_LEVEL ILIVE_TRACE_LEVEL_NONE
+#endif
+
+#define ILIVE_TRACE_PRINT(msg)                  \
+  do                                            \
+    {                                           \
+      std::clog << msg << std::endl;            \
+    }                                           \
+  while (false)
+
+#define ILIVE_TRACE_NOTHING()                   \
+  do                                            \
+    {                                           \
+    }                                           \
+  while (false)
+
+#if ILIVE_TRACE_LEVEL >= ILIVE_TRACE_LEVEL_ERROR
+#define ILIVE_TRACE_ERROR(msg) ILIVE_TRACE_PRINT (msg)
+#else
+#define ILIVE_TRACE_ERROR(msg) ILIVE_TRACE_NOTHING ()
+#endif
+
+#if ILIVE_TRACE_LEVEL >= ILIVE_TRACE_LEVEL_INFO
+#define ILIVE_TRACE_INFO(msg) ILIVE_TRACE_PRINT (msg)
+#else
+#define ILIVE_TRACE_INFO(msg) ILIVE_TRACE_NOTHING ()
+#endif
+
+#if ILIVE_TRACE_LEVEL >= ILIVE_TRACE_LEVEL_DEBUG
+#define ILIVE_TRACE_DEBUG(msg) ILIVE_TRACE_PRINT (msg)
+#else
+#define ILIVE_TRACE_DEBUG(msg) ILIVE_TRACE_NOTHING ()
+#endif
+
+#if ILIVE_TRACE_LEVEL >= ILIVE_TRACE_LEVEL_PACKET
+#define ILIVE_TRACE_PACKET(msg) ILIVE_TRACE_PRINT (msg)
+#else
+#define ILIVE_TRACE_PACKET(msg) ILIVE_TRACE_NOTHING ()
+#endif
+
+#endif /* ILIVE_TRACE_H */
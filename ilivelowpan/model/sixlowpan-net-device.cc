@@ -30,8 +30,7 @@
 #include "ns3/ipv6-header.h"
 #include "ns3/random-variable.h"
 #include "sixlowpan-header.h"
-
-#define YIBO
+#include "ilive-trace.h"
 
 NS_LOG_COMPONENT_DEFINE("SixLowPanNetDevice");
 
@@ -158,10 +157,7 @@ void SixLowPanNetDevice::ReceiveFromDevice(Ptr<NetDevice> incomingPort,
 	SixLowPanDispatch::Dispatch_e dispatchVal;
 	Ptr<Packet> copyPkt = packet->Copy();
 	Ptr<HeaderStorage> ipHeaders = Create<HeaderStorage>();
-#ifdef YIBO
-	std::cout << "***>>>>>>>>>>YIBO::Start of ReceiveFromDevice<<<<<<<<<<***"
-			<< std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("***>>>>>>>>>>YIBO::Start of ReceiveFromDevice<<<<<<<<<<***");
 	NS_LOG_DEBUG("Received a packet::" << *copyPkt);
 
 	copyPkt->CopyData(&dispatchRawVal, sizeof(dispatchRawVal));
@@ -214,18 +210,14 @@ void SixLowPanNetDevice::ReceiveFromDevice(Ptr<NetDevice> incomingPort,
 		case SixLowPanDispatch::LOWPAN_HC1:
 			NS_LOG_DEBUG ( "YIBO::Packet with HC1 compression:" << *copyPkt );
 			DecompressLowPanHc1(copyPkt, src, dst, ipHeaders);
-#ifdef YIBO
-			std::cout << "*****YIBO:" << src << std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("*****YIBO:" << src);
 			isPktDecompressed = true;
 			break;
 		case SixLowPanDispatch::LOWPAN_IPHC:
 			NS_LOG_DEBUG ( "Unsupported");
 			break;
 		default:
-#ifdef YIBO
-			std::cout << "YIBO::problem Pkt:" << *copyPkt << std::endl;
-#endif
+			ILIVE_TRACE_ERROR ("YIBO::problem Pkt:" << *copyPkt);
 			NS_FATAL_ERROR("Unsupported 6LoWPAN encoding, exit due to error.");
 			break;
 		}
@@ -233,28 +225,19 @@ void SixLowPanNetDevice::ReceiveFromDevice(Ptr<NetDevice> incomingPort,
 	}
 
 	if (!isPktDecompressed) {
-#ifdef YIBO
-		std::cout << "Pkt is not Decompressed!" << std::endl;
-#endif
+		ILIVE_TRACE_ERROR ("Pkt is not Decompressed!");
 		return;
 	}
-#ifdef YIBO
-	std::cout << "Pkt is Decompressed well!" << std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("Pkt is Decompressed well!");
 
 	FinalizePacketIp(copyPkt, ipHeaders);
-#ifdef YIBO
-	std::cout << "Let us see what we got =" << *copyPkt
-			<< std::endl;
-#endif
+	ILIVE_TRACE_PACKET ("Let us see what we got =" << *copyPkt);
 
 
 	//YIBO: Test the header storage of 6LoWPAN
 	Address address = m_port->GetAddress();
-#ifdef YIBO
-	std::cout << "###***" << address << std::endl;
-	std::cout << "###***" << dst << std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("###***" << address);
+	ILIVE_TRACE_DEBUG ("###***" << dst);
 
 	Ipv6Header* hdr; // = (*dynamic_cast<Ipv6Header *> ipHeaders->GetHeader(Ipv6Header::GetTypeId()) );
 	//YIBO: Force Header type to Ipv6Header type, so the IPv6 can process it.
@@ -266,50 +249,35 @@ void SixLowPanNetDevice::ReceiveFromDevice(Ptr<NetDevice> incomingPort,
 //	}
 
 	if (packetType == 0) {
-#ifdef YIBO
-		std::cout << "YIBO::packetType == 0" << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("YIBO::packetType == 0");
 		if (hdr->GetDestinationAddress().IsMulticast()) {
 			packetType = PACKET_MULTICAST;
-#ifdef YIBO
-			std::cout << "YIBO::Get a PACKET_MULTICAST." << std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("YIBO::Get a PACKET_MULTICAST.");
 		} else if (dst == address) {
 			packetType = PACKET_HOST;
-#ifdef YIBO
-			std::cout << "YIBO::Get a PACKET_HOST." << std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("YIBO::Get a PACKET_HOST.");
 		} else {
 			packetType = PACKET_OTHERHOST;
-#ifdef YIBO
-			std::cout << "YIBO::Get a PACKET_OTHERHOST." << std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("YIBO::Get a PACKET_OTHERHOST.");
 		}
 	}
 
 	//YIBO: After the process functions above, the processed package need to be delivered to Ipv6L3Protocol.
 	//YIBO: Notice these two Callbacks.
 	if (!m_promiscRxCallback.IsNull()) {
-#ifdef YIBO
 		//YIBO: If m_promiscRxCallback of this net-device is not NULL.
-		std::cout << "###YIBO::Throw this packet to Ipv6L3Protocol."
-				<< std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("###YIBO::Throw this packet to Ipv6L3Protocol.");
 		m_promiscRxCallback(this, copyPkt, Ipv6L3Protocol::PROT_NUMBER, src,
 				dst, packetType);
 	}
-#ifdef YIBO
-	std::cout << "YIBO::Throw this packet to Ipv6L3Protocol." << std::endl;
-	std::cout << "###" << *copyPkt << std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("YIBO::Throw this packet to Ipv6L3Protocol.");
+	ILIVE_TRACE_PACKET ("###" << *copyPkt);
 
 	//YIBO: Check the packetType
 	switch (packetType) {
 	case PACKET_HOST:
 		if (dst == address) {
-#ifdef YIBO
-			std::cout << "YIBO::Go to the PACKET_HOST case." << std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("YIBO::Go to the PACKET_HOST case.");
 //			m_promiscRxCallback(this, copyPkt, Ipv6L3Protocol::PROT_NUMBER, hdr->GetSourceAddress(), hdr->GetDestinationAddress(), packetType);
 
 			m_rxCallback(this, copyPkt, Ipv6L3Protocol::PROT_NUMBER, src);
@@ -328,10 +296,7 @@ void SixLowPanNetDevice::ReceiveFromDevice(Ptr<NetDevice> incomingPort,
 		}
 		break;
 	}
-#ifdef YIBO
-	std::cout << "***>>>>>>>>>>YIBO::END of ReceiveFromDevice<<<<<<<<<<***"
-			<< std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("***>>>>>>>>>>YIBO::END of ReceiveFromDevice<<<<<<<<<<***");
 	return;
 }
 
@@ -480,11 +445,7 @@ bool SixLowPanNetDevice::Send(Ptr<Packet> packet, const Address& dest,
 	if (origPacketSize > 102) {
 		//YIBO:: fragment is needed, Mtu of 802.15.4 is smaller than the packet. Test requested.
 		std::list<Ptr<Packet> > fragmentList;
-#ifdef YIBO
-		std::cout
-				<< "***YIBO: DoFragmentation of Send! Need Frag.*** origPacketSize ="
-				<< origPacketSize << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("***YIBO: DoFragmentation of Send! Need Frag.*** origPacketSize =" << origPacketSize);
 
 		DoFragmentation(packet, origPacketSize, origHdrSize, headersPre,
 				headersPost, fragmentList);
@@ -602,9 +563,7 @@ uint32_t SixLowPanNetDevice::CompressLowPanHc1(Ptr<Packet> packet,
 		packet->RemoveHeader(ipHeader);
 		size += ipHeader.GetSerializedSize();
 
-#ifdef YIBO
-		std::cout << "***YIBO: original header size = " << size << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("***YIBO: original header size = " << size);
 
 		hc1Header->SetHopLimit(ipHeader.GetHopLimit());
 		NS_LOG_DEBUG( "SixLowPanNetDevice::HopLimit/LLT = "<< int(hc1Header->GetHopLimit()));
@@ -681,10 +640,7 @@ uint32_t SixLowPanNetDevice::CompressLowPanHc1(Ptr<Packet> packet,
 		//YIBO:: This is feasible if both src and dest ports are between
 		//YIBO:: SIXLOWPAN_UDP_PORT_MIN and SIXLOWPAN_UDP_PORT_MIN + 15
 		if (nextHeader == Ipv6Header::IPV6_UDP) {
-#ifdef YIBO
-			std::cout << "-------YIBO: I am compressing a IPV6_UDP Header "
-					<< std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("-------YIBO: I am compressing a IPV6_UDP Header ");
 			NS_LOG_DEBUG( " -HC1 Compression:last 3 bits:011- ");
 			hc1Header->SetHc2HeaderPresent(true);
 
@@ -703,10 +659,7 @@ uint32_t SixLowPanNetDevice::CompressLowPanHc1(Ptr<Packet> packet,
 			size += 7;
 
 		} else if (nextHeader == Ipv6Header::IPV6_ICMPV6) {
-#ifdef YIBO
-			std::cout << "------YIBO: I am compressing a IPV6_ICMPV6 Header!"
-					<< std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("------YIBO: I am compressing a IPV6_ICMPV6 Header!");
 			NS_LOG_DEBUG( " -HC1 Compression:last 3 bits:110- ");
 //			hc1Header->SetHc1Encoding(0xFE);
 			hc1Header->SetHc2HeaderPresent(false);
@@ -720,10 +673,7 @@ uint32_t SixLowPanNetDevice::CompressLowPanHc1(Ptr<Packet> packet,
 		//Yibo:: Store the Hc1 Header to headersPre. Suspicious item.
 		headers->StoreHeader(SixLowPanHc1::GetTypeId(), hc1Header);
 
-#ifdef YIBO
-		std::cout << "------YIBO: after HC1 compress, size = " << size
-				<< std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("------YIBO: after HC1 compress, size = " << size);
 
 		return size; //YIBO:: Only compress IPv6 header.
 //		packet->AddHeader(*hc1Header);
@@ -740,10 +690,7 @@ void SixLowPanNetDevice::DecompressLowPanHc1(Ptr<Packet> packet,
 	Ipv6Header* ipHeaderPtr = new Ipv6Header;
 	SixLowPanHc1 encoding;
 	uint32_t packetOrigBufferSize = packet->GetSize();
-#ifdef YIBO
-	std::cout << "<<<<<<<<---START of DecompressLowPanHc1--->>>>>>>>"
-			<< std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("<<<<<<<<---START of DecompressLowPanHc1--->>>>>>>>");
 
 	packet->RemoveHeader(encoding);
 	ipHeaderPtr->SetHopLimit(encoding.GetHopLimit());
@@ -866,10 +813,7 @@ case SixLowPanHc1::HC1_PCIC:
 	} else {
 		NS_LOG_DEBUG( "YIBO:Decompressed Rebuilt packet: " << *ipHeaderPtr << " " << *packet << ", PL Size " << packet->GetSize () );
 	}NS_LOG_DEBUG( "---------------------------------------------------------------------------------" );
-#ifdef YIBO
-	std::cout << "<<<<<<<<---END of DecompressLowPanHc1--->>>>>>>>"
-			<< std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("<<<<<<<<---END of DecompressLowPanHc1--->>>>>>>>");
 }
 
 void SixLowPanNetDevice::FinalizePacketPreFrag(Ptr<Packet> packet,
@@ -879,9 +823,7 @@ void SixLowPanNetDevice::FinalizePacketPreFrag(Ptr<Packet> packet,
 		//YIBO:TODO: add the IPV6 dispatch header, haven't used yet.
 		//YIBO:IPV6 DISPATCH Something cannot be compressed, use IPV6 DISPATCH,compress nothing, copy IPv6 header in packet
 		Header* hdr;
-#ifdef YIBO
-		std::cout << "-YIBO: HeaderStorage is Empty!-" << std::endl;
-#endif
+		ILIVE_TRACE_ERROR ("-YIBO: HeaderStorage is Empty!-");
 
 //		uint8_t dispatchRawValFrag1 = 0;
 //		SixLowPanDispatch::Dispatch_e dispatchValFrag1;
@@ -897,9 +839,7 @@ void SixLowPanNetDevice::FinalizePacketPreFrag(Ptr<Packet> packet,
 //	    uncomp_hdr_len += UIP_IPH_LEN;
 		return;
 	}
-#ifdef YIBO
-	std::cout << "<<--YIBO: FinalizaPacketPreFrag-->>" << std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("<<--YIBO: FinalizaPacketPreFrag-->>");
 	Header* hdr;
 	hdr = headers->GetHeader(SixLowPanHc1::GetTypeId());
 	if (hdr) {
@@ -928,9 +868,7 @@ void SixLowPanNetDevice::FinalizePacketIp(Ptr<Packet> packet,
 		Ptr<HeaderStorage> headers) {
 	if (headers->IsEmpty()) {
 		//YIBO: What should do here?
-#ifdef YIBO
-		std::cout << "-headers is empty!!-" << std::endl;
-#endif
+		ILIVE_TRACE_ERROR ("-headers is empty!!-");
 		return;
 	}
 
@@ -938,9 +876,7 @@ void SixLowPanNetDevice::FinalizePacketIp(Ptr<Packet> packet,
 
 	hdr = headers->GetHeader(UdpHeader::GetTypeId());
 	if (hdr) {
-#ifdef YIBO
-		std::cout << "-YIBO: FinalizaPacketIp-UdpHeader" << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("-YIBO: FinalizaPacketIp-UdpHeader");
 		packet->AddHeader(*dynamic_cast<UdpHeader *>(hdr));
 	}
 
@@ -951,17 +887,13 @@ void SixLowPanNetDevice::FinalizePacketIp(Ptr<Packet> packet,
 
 	hdr = headers->GetHeader(Icmpv6Header::GetTypeId());
 	if (hdr) {
-#ifdef YIBO
-		std::cout << "-YIBO: FinalizaPacketIp-Icmpv6Header" << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("-YIBO: FinalizaPacketIp-Icmpv6Header");
 		packet->AddHeader(*dynamic_cast<Icmpv6Header *>(hdr));
 	}
 
 	hdr = headers->GetHeader(Ipv6Header::GetTypeId());
 	if (hdr) {
-#ifdef YIBO
-		std::cout << "-YIBO: FinalizaPacketIp-Ipv6Header" << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("-YIBO: FinalizaPacketIp-Ipv6Header");
 		packet->AddHeader(*dynamic_cast<Ipv6Header *>(hdr));
 	}
 	return;
@@ -985,19 +917,13 @@ void SixLowPanNetDevice::DoFragmentation(Ptr<Packet> packet,
 	uint32_t origPacketSize = packetSize + origHdrSize;
 	uint32_t cmpHdrSizePre = headersPre->GetHeaderSize();
 	uint32_t cmpHdrSizePost = headersPost->GetHeaderSize();
-#ifdef YIBO
-	std::cout << "packetSize - " << packetSize << ", cmpHdrSizePre -"
-			<< cmpHdrSizePre << ", cmpHdrSizePost -" << cmpHdrSizePost
-			<< std::endl;
-	std::cout << "original packet size = " << origPacketSize << std::endl;
+	ILIVE_TRACE_DEBUG ("packetSize - " << packetSize << ", cmpHdrSizePre -" << cmpHdrSizePre << ", cmpHdrSizePost -" << cmpHdrSizePost);
+	ILIVE_TRACE_DEBUG ("original packet size = " << origPacketSize);
 //	std::cout << "original packet = " << *p << std::endl;
-#endif
 	UniformVariable cd(0, 65535);
 	uint16_t tag;
 	tag = cd.GetValue();
-#ifdef YIBO
-	std::cout << "random tag " << tag << std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("random tag " << tag);
 
 	// First fragment
 	SixLowPanFrag1* frag1Hdr = new SixLowPanFrag1;
@@ -1011,9 +937,7 @@ void SixLowPanNetDevice::DoFragmentation(Ptr<Packet> packet,
 
 	size = (l2Mtu - frag1Hdr->GetSerializedSize() - cmpHdrSizePre
 			- cmpHdrSizePost) & 0xf8;
-#ifdef YIBO
-	std::cout << "First Frag payload size = " << size << std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("First Frag payload size = " << size);
 
 	frag1Hdr->SetDatagramSize(origPacketSize);
 
@@ -1027,9 +951,7 @@ void SixLowPanNetDevice::DoFragmentation(Ptr<Packet> packet,
 	FinalizePacketPostFrag(fragment1, headersPost);
 	listFragments.push_back(fragment1);
 
-#ifdef YIBO
-	std::cout << "Fragment1 = " << *fragment1 << std::endl;
-#endif
+	ILIVE_TRACE_PACKET ("Fragment1 = " << *fragment1);
 
 	bool moreFrag = true;
 	do {
@@ -1074,9 +996,7 @@ bool SixLowPanNetDevice::ProcessFragment(Ptr<Packet>& packet,
 	Ptr<Packet> p = packet->Copy();
 	uint16_t offset = 0;
 
-#ifdef YIBO
-	std::cout << "~~~~~~~~~~START of ProcessFragment~~~~~~~~~~" << std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("~~~~~~~~~~START of ProcessFragment~~~~~~~~~~");
 
 	if (isFirst) {
 		uint8_t dispatchRawValFrag1 = 0;
@@ -1085,27 +1005,19 @@ bool SixLowPanNetDevice::ProcessFragment(Ptr<Packet>& packet,
 		p->CopyData(&dispatchRawValFrag1, sizeof(dispatchRawValFrag1));
 		dispatchValFrag1 = SixLowPanDispatch::GetDispatchType(
 				dispatchRawValFrag1);
-#ifdef YIBO
-		std::cout << "<<ProcessFragment>>, dispatchValFrag1 = "
-				<< dispatchValFrag1 << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("<<ProcessFragment>>, dispatchValFrag1 = " << dispatchValFrag1);
 		p->RemoveHeader(frag1Header);
 		p->CopyData(&dispatchRawValFrag1, sizeof(dispatchRawValFrag1));
 		dispatchValFrag1 = SixLowPanDispatch::GetDispatchType(
 				dispatchRawValFrag1);
-#ifdef YIBO
-		std::cout << "<<ProcessFragment>>, dispatchValFrag1 = "
-				<< dispatchValFrag1 << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("<<ProcessFragment>>, dispatchValFrag1 = " << dispatchValFrag1);
 		switch (dispatchValFrag1) {
 		case SixLowPanDispatch::LOWPAN_NOTCOMPRESSED:
 			NS_LOG_DEBUG ( "Packet without compression:" << *p );
 			NS_LOG_DEBUG ( "Packet length:" << p->GetSize () );
 			break;
 		case SixLowPanDispatch::LOWPAN_HC1:
-#ifdef YIBO
-			std::cout << "YIBO::Processed Pkt:" << *p << std::endl;
-#endif
+			ILIVE_TRACE_PACKET ("YIBO::Processed Pkt:" << *p);
 			NS_LOG_DEBUG ( "Packet length:" << p->GetSize () );
 			DecompressLowPanHc1(p, src, dst, ipHeaders);
 			break;
@@ -1118,19 +1030,14 @@ bool SixLowPanNetDevice::ProcessFragment(Ptr<Packet>& packet,
 			break;
 		}
 		FinalizePacketIp(p, ipHeaders);
-#ifdef YIBO
-		std::cout << "Frag1Size = " << frag1Header.GetDatagramSize()
-				<< ", Frag1Tag = " << frag1Header.GetDatagramTag() << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("Frag1Size = " << frag1Header.GetDatagramSize() << ", Frag1Tag = " << frag1Header.GetDatagramTag());
 		key.second = std::pair<uint16_t, uint16_t>(
 				frag1Header.GetDatagramSize(), frag1Header.GetDatagramTag());
 	} else {
 		p->RemoveHeader(fragNHeader);
 		offset = fragNHeader.GetDatagramOffset() << 3;
 		offset += 48;
-#ifdef YIBO
-		std::cout << "fragNHeader's offset = " << offset << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("fragNHeader's offset = " << offset);
 		key.second = std::pair<uint16_t, uint16_t>(
 				fragNHeader.GetDatagramSize(), fragNHeader.GetDatagramTag());
 	}
@@ -1142,9 +1049,7 @@ bool SixLowPanNetDevice::ProcessFragment(Ptr<Packet>& packet,
 		// erase the oldest packet.
 		if (m_fragmentReassemblyListSize
 				&& (m_fragments.size() >= m_fragmentReassemblyListSize)) {
-#ifdef YIBO
-			std::cout << "Going to erase the oldest fragment! " << std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("Going to erase the oldest fragment! ");
 			MapFragmentsTimers_t::iterator iter;
 			MapFragmentsTimers_t::iterator iterFound =
 					m_fragmentsTimers.begin();
@@ -1162,9 +1067,7 @@ bool SixLowPanNetDevice::ProcessFragment(Ptr<Packet>& packet,
 			m_dropTrace(DROP_FRAGMENT_BUFFERFULL,
 					m_node->GetObject<SixLowPanNetDevice>(), GetIfIndex());
 		}
-#ifdef YIBO
-		std::cout << "---###it == m_fragments.end()###---" << std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("---###it == m_fragments.end()###---");
 		fragments = Create<Fragments>();
 		fragments->SetPacketSize(frag1Header.GetDatagramSize() - 7 + 48, ipHeaders);
 		m_fragments.insert(std::make_pair(key, fragments));
@@ -1215,20 +1118,13 @@ bool SixLowPanNetDevice::ProcessFragment(Ptr<Packet>& packet,
 			m_fragmentsTimers[key].Cancel();
 		}
 		m_fragmentsTimers.erase(key);
-#ifdef YIBO
-		std::cout << "~~~~~~~~~~assembly packet =" << *packet
-						<< std::endl;
-		std::cout << "~~~~~~~~~~END of ProcessFragment, return true~~~~~~~~~~"
-				<< std::endl;
-#endif
+		ILIVE_TRACE_PACKET ("~~~~~~~~~~assembly packet =" << *packet);
+		ILIVE_TRACE_DEBUG ("~~~~~~~~~~END of ProcessFragment, return true~~~~~~~~~~");
 		return true;
 
 	} else {
 
-#ifdef YIBO
-		std::cout << "~~~~~~~~~~END of ProcessFragment, return false~~~~~~~~~~"
-				<< std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("~~~~~~~~~~END of ProcessFragment, return false~~~~~~~~~~");
 		return false;
 	}
 }
@@ -1301,10 +1197,7 @@ bool SixLowPanNetDevice::Fragments::IsEntire() const {
 	uint16_t lastEndOffset = 0;
 
 	if (ret) {
-#ifdef YIBO
-		std::cout << "$$$$$$$$ ret==real of Fragment is entire !! $$$$$$$$"
-				<< std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("$$$$$$$$ ret==real of Fragment is entire !! $$$$$$$$");
 //		uint16_t lastEndOffset = 0;
 
 		for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it =
@@ -1314,42 +1207,24 @@ bool SixLowPanNetDevice::Fragments::IsEntire() const {
 
 			if (lastEndOffset < it->second) {
 				ret = false;
-#ifdef YIBO
-				std::cout
-						<< "$$$$$$$$ Set ret = false of Fragment is entire !! $$$$$$$$"
-						<< std::endl;
-#endif
+				ILIVE_TRACE_DEBUG ("$$$$$$$$ Set ret = false of Fragment is entire !! $$$$$$$$");
 				break;
 			}
 			// fragments might overlap in strange ways
 			uint16_t fragmentEnd = it->first->GetSize() + it->second;
-#ifdef YIBO
-			std::cout << "it->first->GetSize() = " << it->first->GetSize()
-					<< ", it->second = " << it->second << std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("it->first->GetSize() = " << it->first->GetSize() << ", it->second = " << it->second);
 			lastEndOffset = std::max(lastEndOffset, fragmentEnd);
-#ifdef YIBO
-			std::cout << "fragmentEnd = " << fragmentEnd << ", lastEndOffset = "
-					<< lastEndOffset << std::endl;
-#endif
+			ILIVE_TRACE_DEBUG ("fragmentEnd = " << fragmentEnd << ", lastEndOffset = " << lastEndOffset);
 		}
 	}
 
-#ifdef YIBO
-	std::cout << "$$$$$$$$m_packetSize = " << m_packetSize << ", ret = " << ret << std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("$$$$$$$$m_packetSize = " << m_packetSize << ", ret = " << ret);
 
 	if (ret && (lastEndOffset == m_packetSize)) {
-#ifdef YIBO
-		std::cout << "$$$$$$$$ Return True of Fragment is entire !! $$$$$$$$"
-				<< std::endl;
-#endif
+		ILIVE_TRACE_DEBUG ("$$$$$$$$ Return True of Fragment is entire !! $$$$$$$$");
 		return true;
 	}
-#ifdef YIBO
-	std::cout << "$$$$$$$$ Return False of Fragment is entire !! $$$$$$$$"
-			<< std::endl;
-#endif
+	ILIVE_TRACE_DEBUG ("$$$$$$$$ Return False of Fragment is entire !! $$$$$$$$");
 	return false;
 }
 
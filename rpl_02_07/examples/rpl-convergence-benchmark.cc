@@ -0,0 +1,319 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Control-plane convergence benchmark of RPL.
+//
+// Builds a grid, random-disk or line topology of 6LoWPAN over 802.11 ad hoc
+// nodes, whose links reach the neighbors closer than --range meters. Node 0
+// is the DODAG root: it sits in a corner of the grid, at an end of the line
+// and at the center of the disk. The disk keeps the node density of the
+// grid. The DODAG stores its downward routes in every node, or with
+// --mop=non-storing at the root only, which source-routes the packets down.
+//
+// The run prints one CSV line:
+//   topology,mop,nodes,run,joined,formation_s,dis_tx,dis_bytes,dio_tx,dio_bytes,
+//   dao_tx,dao_bytes,dao_ack_tx,dao_ack_bytes,peak_routes,events,wall_ms,rss_kb
+// - formation_s is the time at which the last node joined the DODAG, -1 if
+//   some node did not join before --stopTime;
+// - the byte counts are the ICMPv6 messages, without the IPv6 header;
+// - peak_routes is the largest routing table of a node, sampled every
+//   --sampleInterval seconds;
+// - events is the number of events the scheduler dequeued;
+// - rss_kb is the peak resident set size of the process.
+//
+// Examples:
+//   ./waf --run "rpl-convergence-benchmark --topology=grid --nodes=100 --output=convergence.csv"
+//   ./waf --run "rpl-convergence-benchmark --topology=grid --nodes=100 --mop=non-storing --output=convergence.csv"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/sixlowpan-helper.h"
+#include "ns3/rpl-helper.h"
+#include "ns3/rpl-routing-protocol.h"
+
+#include <sys/resource.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+NS_LOG_COMPONENT_DEFINE ("RplConvergenceBenchmark");
+
+using namespace ns3;
+
+/**
+ * \brief Map scheduler that counts the events dequeued by the simulator
+ */
+class CountingScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::CountingScheduler")
+      .SetParent<MapScheduler> ()
+      .AddConstructor<CountingScheduler> ();
+    return tid;
+  }
+  virtual Scheduler::Event RemoveNext (void)
+  {
+    ++m_count;
+    return MapScheduler::RemoveNext ();
+  }
+  static uint64_t m_count;
+};
+
+uint64_t CountingScheduler::m_count = 0;
+
+NS_OBJECT_ENSURE_REGISTERED (CountingScheduler);
+
+/// Statistics of a benchmark run
+struct Convergence
+{
+  Convergence (uint32_t nodes)
+    : joined (nodes, false),
+      nJoined (0),
+      formation (Seconds (-1)),
+      peakRoutes (0)
+  {
+    for (uint32_t i = 0; i < 4; ++i)
+      {
+        tx[i] = 0;
+        bytes[i] = 0;
+      }
+  }
+
+  std::vector<bool> joined;
+  uint32_t nJoined;
+  Time formation;
+  /// Messages and bytes sent, by DIS, DIO, DAO and DAO-ACK code
+  uint64_t tx[4];
+  uint64_t bytes[4];
+  uint32_t peakRoutes;
+};
+
+static void
+ControlTx (Convergence *stats, Ptr<const Packet> packet)
+{
+  Icmpv6Header icmp;
+  packet->PeekHeader (icmp);
+  uint8_t code = icmp.GetCode ();
+  if (code <= RPL_CODE_DAO_ACK)
+    {
+      stats->tx[code]++;
+      stats->bytes[code] += packet->GetSize ();
+    }
+}
+
+static void
+DagJoin (Convergence *stats, std::string context, uint8_t instanceId, Ipv6Address dagId)
+{
+  uint32_t node = std::atoi (context.c_str ());
+  if (stats->joined[node])
+    {
+      return;
+    }
+  stats->joined[node] = true;
+  if (++stats->nJoined == stats->joined.size ())
+    {
+      stats->formation = Simulator::Now ();
+    }
+}
+
+static void
+SampleRoutes (Convergence *stats, std::vector<Ptr<rpl::RoutingProtocol> > const *agents, Time interval)
+{
+  for (uint32_t i = 0; i < agents->size (); ++i)
+    {
+      uint32_t routes = (*agents)[i]->GetNRoutes ();
+      if (routes > stats->peakRoutes)
+        {
+          stats->peakRoutes = routes;
+        }
+    }
+  Simulator::Schedule (interval, &SampleRoutes, stats, agents, interval);
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string topology ("grid");
+  std::string mop ("storing");
+  uint32_t nodes = 100;
+  double spacing = 20.0;
+  double range = 30.0;
+  double stopTime = 120.0;
+  double sampleInterval = 1.0;
+  uint32_t run = 1;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue ("topology", "grid, disk or line", topology);
+  cmd.AddValue ("mop", "mode of operation of the DODAG: storing or non-storing", mop);
+  cmd.AddValue ("nodes", "number of nodes, from 10 to 10000", nodes);
+  cmd.AddValue ("spacing", "distance between neighbor nodes of the grid and of the line (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("stopTime", "simulation time (s)", stopTime);
+  cmd.AddValue ("sampleInterval", "period of the routing table size samples (s)", sampleInterval);
+  cmd.AddValue ("run", "run number of the random number generator", run);
+  cmd.AddValue ("output", "CSV file to append the result to, instead of the standard output", output);
+  cmd.Parse (argc, argv);
+
+  if (nodes < 10 || nodes > 10000)
+    {
+      NS_FATAL_ERROR ("The number of nodes must be in [10, 10000]");
+    }
+  if (topology != "grid" && topology != "disk" && topology != "line")
+    {
+      NS_FATAL_ERROR ("Unknown topology " << topology);
+    }
+  if (mop != "storing" && mop != "non-storing")
+    {
+      NS_FATAL_ERROR ("Unknown mode of operation " << mop);
+    }
+  Config::SetDefault ("ns3::rpl::RoutingProtocol::Mop",
+                      StringValue (mop == "storing" ? "Storing" : "NonStoring"));
+
+  SystemWallClockMs wallClock;
+  wallClock.Start ();
+
+  ObjectFactory scheduler;
+  scheduler.SetTypeId (CountingScheduler::GetTypeId ());
+  Simulator::SetScheduler (scheduler);
+  RngSeedManager::SetRun (run);
+
+  NodeContainer c;
+  c.Create (nodes);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("DsssRate1Mbps"),
+                                "ControlMode", StringValue ("DsssRate1Mbps"));
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
+  wifiPhy.SetChannel (wifiChannel.Create ());
+  NqosWifiMacHelper wifiMac = NqosWifiMacHelper::Default ();
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  if (topology == "disk")
+    {
+      // uniform over the area of a disk holding the nodes at the density of the grid
+      double radius = spacing * std::sqrt (nodes / M_PI);
+      Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+      Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+      positions->Add (Vector (0.0, 0.0, 0.0));
+      for (uint32_t i = 1; i < nodes; ++i)
+        {
+          double rho = radius * std::sqrt (u->GetValue ());
+          double theta = u->GetValue (0.0, 2 * M_PI);
+          positions->Add (Vector (rho * std::cos (theta), rho * std::sin (theta), 0.0));
+        }
+      mobility.SetPositionAllocator (positions);
+    }
+  else
+    {
+      uint32_t width = nodes;
+      if (topology == "grid")
+        {
+          width = (uint32_t) std::ceil (std::sqrt ((double) nodes));
+        }
+      mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                     "MinX", DoubleValue (0.0),
+                                     "MinY", DoubleValue (0.0),
+                                     "DeltaX", DoubleValue (spacing),
+                                     "DeltaY", DoubleValue (spacing),
+                                     "GridWidth", UintegerValue (width),
+                                     "LayoutType", StringValue ("RowFirst"));
+    }
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper rpl;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (rpl);
+  internet.Install (c);
+
+  SixLowPanHelper sixlowpan;
+  NetDeviceContainer sixDevices = sixlowpan.Install (devices);
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6.Assign (sixDevices);
+
+  Convergence stats (nodes);
+  std::vector<Ptr<rpl::RoutingProtocol> > agents;
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      Ptr<rpl::RoutingProtocol> agent = c.Get (i)->GetObject<rpl::RoutingProtocol> ();
+      NS_ASSERT (agent != 0);
+      agent->TraceConnectWithoutContext ("ControlTx", MakeBoundCallback (&ControlTx, &stats));
+      std::ostringstream node;
+      node << i;
+      agent->TraceConnect ("DagJoin", node.str (), MakeBoundCallback (&DagJoin, &stats));
+      agents.push_back (agent);
+    }
+  Simulator::Schedule (Seconds (sampleInterval), &SampleRoutes, &stats, &agents, Seconds (sampleInterval));
+
+  Simulator::Stop (Seconds (stopTime));
+  Simulator::Run ();
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      stats.peakRoutes = std::max (stats.peakRoutes, agents[i]->GetNRoutes ());
+    }
+  agents.clear ();
+  Simulator::Destroy ();
+
+  int64_t wallMs = wallClock.End ();
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+
+  std::ofstream file;
+  bool header = true;
+  if (!output.empty ())
+    {
+      std::ifstream existing (output.c_str ());
+      header = !existing.good () || existing.peek () == std::ifstream::traits_type::eof ();
+      file.open (output.c_str (), std::ios::app);
+    }
+  std::ostream &csv = output.empty () ? std::cout : file;
+  if (header)
+    {
+      csv << "topology,mop,nodes,run,joined,formation_s,dis_tx,dis_bytes,dio_tx,dio_bytes,"
+          << "dao_tx,dao_bytes,dao_ack_tx,dao_ack_bytes,peak_routes,events,wall_ms,rss_kb" << std::endl;
+    }
+  csv << topology << "," << mop << "," << nodes << "," << run << "," << stats.nJoined << ","
+      << stats.formation.GetSeconds ();
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      csv << "," << stats.tx[i] << "," << stats.bytes[i];
+    }
+  csv << "," << stats.peakRoutes << "," << CountingScheduler::m_count << ","
+      << wallMs << "," << usage.ru_maxrss << std::endl;
+
+  return 0;
+}
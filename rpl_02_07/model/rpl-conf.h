@@ -32,10 +32,14 @@ namespace ns3 {
 #ifdef RPL_CONF_OF
 #define RPL_OF RPL_CONF_OF
 #else
-/* ETX is the default objective function. */
-#define RPL_OF rpl_of_etx
+/* MRHOF over ETX is the default objective function. */
+#define RPL_OF rpl_mrhof
 #endif /* RPL_CONF_OF */
 
+/* Objective Code Points (RFC 6552, RFC 6719). */
+#define RPL_OCP_OF0                     0
+#define RPL_OCP_MRHOF                   1
+
 /* This value decides which DAG instance we should participate in by default. */
 #ifdef RPL_CONF_DEFAULT_INSTANCE
 #define RPL_DEFAULT_INSTANCE RPL_CONF_DEFAULT_INSTANCE
@@ -54,7 +58,18 @@ namespace ns3 {
 #endif
 
 /*
- * Maximum of concurent RPL instances.
+ * Set to 0 to send the data packets without the RPL option (RFC 6553),
+ * which carries the rank used to detect loops along the forwarding path.
+ */
+#ifdef RPL_CONF_INSERT_HBH_OPTION
+#define RPL_INSERT_HBH_OPTION RPL_CONF_INSERT_HBH_OPTION
+#else
+#define RPL_INSERT_HBH_OPTION 1
+#endif /* RPL_CONF_INSERT_HBH_OPTION */
+
+/*
+ * Default maximum of concurent RPL instances, see the MaxInstances attribute
+ * of the routing protocol.
  */
 #ifdef RPL_CONF_MAX_INSTANCES
 #define RPL_MAX_INSTANCES     RPL_CONF_MAX_INSTANCES
@@ -63,7 +78,8 @@ namespace ns3 {
 #endif /* RPL_CONF_MAX_INSTANCES */
 
 /*
- * Maximum number of DAGs within an instance.
+ * Default maximum number of DAGs within an instance, see the
+ * MaxDagsPerInstance attribute of the routing protocol.
  */
 #ifdef RPL_CONF_MAX_DAG_PER_INSTANCE
 #define RPL_MAX_DAG_PER_INSTANCE     RPL_CONF_MAX_DAG_PER_INSTANCE
@@ -71,6 +87,15 @@ namespace ns3 {
 #define RPL_MAX_DAG_PER_INSTANCE     2
 #endif /* RPL_CONF_MAX_DAG_PER_INSTANCE */
 
+/*
+ * Maximum number of candidate parents kept per DAG.
+ */
+#ifdef RPL_CONF_MAX_PARENTS_PER_DAG
+#define RPL_MAX_PARENTS_PER_DAG      RPL_CONF_MAX_PARENTS_PER_DAG
+#else
+#define RPL_MAX_PARENTS_PER_DAG      8
+#endif /* RPL_CONF_MAX_PARENTS_PER_DAG */
+
 /*
  *
  */
@@ -124,6 +149,31 @@ namespace ns3 {
 #define RPL_DIO_REDUNDANCY          10
 #endif
 
+/*
+ * Link metrics are kept as fixed-point ETX values, as in the Contiki
+ * neighbor-info module.
+ */
+#define NEIGHBOR_INFO_ETX_DIVISOR       16
+#define NEIGHBOR_INFO_ETX2FIX(etx)      ((etx) * NEIGHBOR_INFO_ETX_DIVISOR)
+#define NEIGHBOR_INFO_FIX2ETX(fix)      ((fix) / NEIGHBOR_INFO_ETX_DIVISOR)
+
+/*
+ * Link estimation: the ETX of a link is a moving average of the
+ * transmissions of its frames, weighted by RPL_LINK_ETX_ALPHA over
+ * RPL_LINK_ETX_SCALE. A frame that is not acknowledged counts as
+ * RPL_LINK_ETX_NOACK_PENALTY transmissions.
+ */
+#define RPL_LINK_ETX_SCALE              100
+#define RPL_LINK_ETX_ALPHA              90
+#define RPL_LINK_ETX_NOACK_PENALTY      15
+
+/* Number of neighbors whose link is estimated. */
+#ifdef RPL_CONF_LINK_ESTIMATOR_SIZE
+#define RPL_LINK_ESTIMATOR_SIZE         RPL_CONF_LINK_ESTIMATOR_SIZE
+#else
+#define RPL_LINK_ESTIMATOR_SIZE         16
+#endif
+
 /*
  * Initial metric attributed to a link when the ETX is unknown
  */
@@ -155,7 +205,7 @@ namespace ns3 {
 
 /*---------------------------------------------------------------------------*/
 /* The amount of parents that this node has in a particular DAG. */
-//#define RPL_PARENT_COUNT(dag)   list_length((dag)->parents)
+#define RPL_PARENT_COUNT(dag)   ((dag)->parent_count)
 /*---------------------------------------------------------------------------*/
 typedef uint16_t rpl_rank_t;
 typedef uint16_t rpl_ocp_t;
@@ -213,6 +263,9 @@ typedef uint16_t rpl_ocp_t;
 #define uip_create_linklocal_rplnodes_mcast(addr) Ipv6Address addr = new Ipv6Address("ff02::1a");
 //Ipv6Address((addr), 0xff02, 0, 0, 0, 0, 0, 0, 0x001a);
 /*---------------------------------------------------------------------------*/
+/* ICMPv6 message type carrying all RPL control messages (RFC 6550). */
+#define ICMP6_RPL                      155
+
 /* RPL message types */
 #define RPL_CODE_DIS                   0x00   /* DAG Information Solicitation */
 #define RPL_CODE_DIO                   0x01   /* DAG Information Option */
@@ -237,8 +290,14 @@ typedef uint16_t rpl_ocp_t;
 
 #define RPL_DAO_K_FLAG                   0x80 /* DAO ACK requested */
 #define RPL_DAO_D_FLAG                   0x40 /* DODAG ID present */
+
+#define RPL_PREFIX_FLAG_AUTONOMOUS       0x40 /* Prefix usable for address autoconfiguration */
+
+/* Routing type of the RPL Source Routing Header (RFC 6554). */
+#define RPL_SRH_ROUTING_TYPE             3
 /*---------------------------------------------------------------------------*/
 /* RPL IPv6 extension header option. */
+#define RPL_HDR_OPT_TYPE		0x63
 #define RPL_HDR_OPT_LEN			4
 #define RPL_HOP_BY_HOP_LEN		(RPL_HDR_OPT_LEN + 2 + 2)
 #define RPL_HDR_OPT_DOWN		0x80
@@ -254,12 +313,48 @@ typedef uint16_t rpl_ocp_t;
 #ifdef RPL_CONF_DAO_LATENCY
 #define RPL_DAO_LATENCY                 RPL_CONF_DAO_LATENCY
 #else /* RPL_CONF_DAO_LATENCY */
-#define RPL_DAO_LATENCY                 (CLOCK_SECOND * 4)
+#define RPL_DAO_LATENCY                 Seconds (4)
 #endif /* RPL_DAO_LATENCY */
 
+/* Largest DAO message: the ICMPv6 payload of an IPv6 packet of the minimum
+   MTU (1280 octets) that 6LoWPAN must carry. Targets beyond it go in
+   another DAO. */
+#ifdef RPL_CONF_DAO_MAX_SIZE
+#define RPL_DAO_MAX_SIZE                RPL_CONF_DAO_MAX_SIZE
+#else
+#define RPL_DAO_MAX_SIZE                (1280 - 40)
+#endif
+
+/* Number of child targets a storing mode node aggregates during
+   RPL_DAO_LATENCY before it sends them to its parent. */
+#ifdef RPL_CONF_DAO_MAX_AGGREGATED
+#define RPL_DAO_MAX_AGGREGATED          RPL_CONF_DAO_MAX_AGGREGATED
+#else
+#define RPL_DAO_MAX_AGGREGATED          32
+#endif
+
 /* Special value indicating immediate removal. */
 #define RPL_ZERO_LIFETIME               0
 
+/* Special value indicating a route that never expires. */
+#define RPL_INFINITE_LIFETIME           0xff
+
+/* Initial number of buckets of the downward (DAO) route table; it grows on demand. */
+#ifdef RPL_CONF_DAO_ROUTE_BUCKETS
+#define RPL_DAO_ROUTE_BUCKETS           RPL_CONF_DAO_ROUTE_BUCKETS
+#else
+#define RPL_DAO_ROUTE_BUCKETS           64
+#endif
+
+/* Number of slots of the timer wheel of the route settling times; the
+   wheel turns once every RPL_SETTLING_WHEEL_SLOTS ticks of the SettlingTick
+   attribute. */
+#ifdef RPL_CONF_SETTLING_WHEEL_SLOTS
+#define RPL_SETTLING_WHEEL_SLOTS        RPL_CONF_SETTLING_WHEEL_SLOTS
+#else
+#define RPL_SETTLING_WHEEL_SLOTS        64
+#endif
+
 #define RPL_LIFETIME(instance, lifetime) \
           ((unsigned long)(instance)->lifetime_unit * (lifetime))
 
@@ -323,6 +418,7 @@ typedef uint16_t rpl_ocp_t;
 #define RPL_MOP_STORING_NO_MULTICAST    2
 #define RPL_MOP_STORING_MULTICAST       3
 
+/* Default of the Mop attribute of the routing protocol */
 #ifdef  RPL_CONF_MOP
 #define RPL_MOP_DEFAULT                 RPL_CONF_MOP
 #else
@@ -337,13 +433,52 @@ typedef uint16_t rpl_ocp_t;
 #define RPL_DAG_MC_ETX_DIVISOR		128
 
 /* DIS related */
+/*
+ * Solicit DIOs with multicast DIS until the node joins a DAG.
+ */
+#ifdef  RPL_DIS_SEND_CONF
+#define RPL_DIS_SEND                    RPL_DIS_SEND_CONF
+#else
 #define RPL_DIS_SEND                    1
+#endif
 #ifdef  RPL_DIS_INTERVAL_CONF
 #define RPL_DIS_INTERVAL                RPL_DIS_INTERVAL_CONF
 #else
 #define RPL_DIS_INTERVAL                60
 #endif
-#define RPL_DIS_START_DELAY             5
+/*
+ * Upper bound of the random delay, in seconds, of the first DIS after the
+ * node starts.
+ */
+#ifdef  RPL_DIS_START_DELAY_CONF
+#define RPL_DIS_START_DELAY             RPL_DIS_START_DELAY_CONF
+#else
+#define RPL_DIS_START_DELAY             1
+#endif
+/*
+ * Upper bound of the random delay, in milliseconds, of the unicast DIO a
+ * node sends in reply to a multicast DIS. The delay spreads the replies of
+ * the neighbors of the soliciting node, and lets a multicast DIO of the DAG
+ * sent meanwhile cancel them.
+ */
+#ifdef  RPL_DIS_REPLY_DELAY_CONF
+#define RPL_DIS_REPLY_DELAY             RPL_DIS_REPLY_DELAY_CONF
+#else
+#define RPL_DIS_REPLY_DELAY             250
+#endif
+
+/* Repair related */
+/*
+ * Minimum time, in seconds, between two repairs an instance advertises:
+ * the DIO and DIS bursts of the local repairs of a node, and the DODAG
+ * version increments of a root. A repair requested sooner is deferred to
+ * the end of that time. See the MinRepairInterval attribute.
+ */
+#ifdef  RPL_REPAIR_INTERVAL_CONF
+#define RPL_REPAIR_INTERVAL             RPL_REPAIR_INTERVAL_CONF
+#else
+#define RPL_REPAIR_INTERVAL             5
+#endif
 /*---------------------------------------------------------------------------*/
 /* Lollipop counters */
 
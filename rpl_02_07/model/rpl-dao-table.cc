@@ -0,0 +1,309 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "rpl-dao-table.h"
+#include "rpl-conf.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <iomanip>
+
+NS_LOG_COMPONENT_DEFINE ("RplDaoRoutingTable");
+
+namespace ns3 {
+namespace rpl {
+
+DaoRoutingTableEntry::DaoRoutingTableEntry (Ptr<NetDevice> dev,
+                                            Ipv6Address target,
+                                            uint8_t prefixLength,
+                                            Ipv6Address source,
+                                            Ipv6Address nextHop,
+                                            uint8_t pathSequence,
+                                            Time expire)
+  : m_prefixLength (prefixLength),
+    m_pathSequence (pathSequence),
+    m_expire (expire)
+{
+  m_ipv6Route = Create<Ipv6Route> ();
+  m_ipv6Route->SetDestination (target);
+  m_ipv6Route->SetGateway (nextHop);
+  m_ipv6Route->SetSource (source);
+  m_ipv6Route->SetOutputDevice (dev);
+}
+
+void
+DaoRoutingTableEntry::Print (Ptr<OutputStreamWrapper> stream) const
+{
+  *stream->GetStream () << std::setiosflags (std::ios::fixed) << m_ipv6Route->GetDestination () << "/"
+                        << (uint32_t) m_prefixLength << "\t\t" << m_ipv6Route->GetGateway () << "\t\t"
+                        << std::setw (10) << (uint32_t) m_pathSequence << "\t" << std::setprecision (3)
+                        << (m_expire - Simulator::Now ()).GetSeconds () << "s\n";
+}
+
+DaoRoutingTable::DaoRoutingTable ()
+  : m_routes (RPL_DAO_ROUTE_BUCKETS)
+{
+}
+
+void
+DaoRoutingTable::Update (DaoRoutingTableEntry const & rt)
+{
+  RouteMap::iterator i = m_routes.find (rt.GetTarget ());
+  if (i == m_routes.end ())
+    {
+      m_routes.insert (std::make_pair (rt.GetTarget (), rt));
+    }
+  else
+    {
+      i->second = rt;
+    }
+  if (rt.GetExpireTime () < Simulator::GetMaximumSimulationTime ())
+    {
+      m_expiryIndex.Push (rt.GetTarget (), rt.GetExpireTime ());
+    }
+}
+
+bool
+DaoRoutingTable::LookupRoute (Ipv6Address target, DaoRoutingTableEntry & rt) const
+{
+  RouteMap::const_iterator i = m_routes.find (target);
+  if (i == m_routes.end ())
+    {
+      return false;
+    }
+  rt = i->second;
+  return true;
+}
+
+Ptr<Ipv6Route>
+DaoRoutingTable::LookupRoute (Ipv6Address dst) const
+{
+  if (m_routes.empty ())
+    {
+      return 0;
+    }
+  RouteMap::const_iterator i = m_routes.find (dst);
+  if (i == m_routes.end ())
+    {
+      return 0;
+    }
+  return i->second.GetRoute ();
+}
+
+bool
+DaoRoutingTable::DeleteRoute (Ipv6Address target)
+{
+  // the deadline left in the heap is skipped when popped
+  return m_routes.erase (target) > 0;
+}
+
+void
+DaoRoutingTable::DeleteRoutesWithNextHop (Ipv6Address nextHop, std::vector<DaoRoutingTableEntry> & removed)
+{
+  for (RouteMap::iterator i = m_routes.begin (); i != m_routes.end (); )
+    {
+      if (i->second.GetNextHop () == nextHop)
+        {
+          removed.push_back (i->second);
+          m_routes.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+DaoRoutingTable::Purge (std::vector<DaoRoutingTableEntry> & removed)
+{
+  Ipv6Address target;
+  while (m_expiryIndex.PopExpired (*this, Simulator::Now (), target))
+    {
+      RouteMap::iterator i = m_routes.find (target);
+      NS_LOG_LOGIC ("Downward route to " << target << " expired");
+      removed.push_back (i->second);
+      m_routes.erase (i);
+    }
+}
+
+bool
+DaoRoutingTable::GetNextExpiry (Time & expiry)
+{
+  return m_expiryIndex.GetNextExpiry (*this, expiry);
+}
+
+bool
+DaoRoutingTable::IsCurrentDeadline (Ipv6Address target, Time expire) const
+{
+  RouteMap::const_iterator i = m_routes.find (target);
+  return i != m_routes.end () && i->second.GetExpireTime () == expire;
+}
+
+void
+DaoRoutingTable::GetListOfAllRoutes (std::vector<DaoRoutingTableEntry> & routes) const
+{
+  routes.reserve (routes.size () + m_routes.size ());
+  for (RouteMap::const_iterator i = m_routes.begin (); i != m_routes.end (); ++i)
+    {
+      routes.push_back (i->second);
+    }
+}
+
+void
+DaoRoutingTable::Clear ()
+{
+  m_routes.clear ();
+  m_expiryIndex.Clear ();
+}
+
+uint32_t
+DaoRoutingTable::Size () const
+{
+  return m_routes.size ();
+}
+
+void
+DaoRoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
+{
+  *stream->GetStream () << "\nRPL Downward routes\n" << "Target\t\tNextHop\t\tPathSequence\t\tExpire\n";
+  for (RouteMap::const_iterator i = m_routes.begin (); i != m_routes.end (); ++i)
+    {
+      i->second.Print (stream);
+    }
+  *stream->GetStream () << "\n";
+}
+
+SourceRoutingTable::SourceRoutingTable ()
+  : m_links (RPL_DAO_ROUTE_BUCKETS)
+{
+}
+
+void
+SourceRoutingTable::Update (Ipv6Address target, Ipv6Address parent, uint8_t pathSequence, Time expire)
+{
+  Link & link = m_links[target];
+  link.parent = parent;
+  link.pathSequence = pathSequence;
+  link.expire = expire;
+  if (expire < Simulator::GetMaximumSimulationTime ())
+    {
+      m_expiryIndex.Push (target, expire);
+    }
+}
+
+bool
+SourceRoutingTable::LookupParent (Ipv6Address target, Ipv6Address & parent, uint8_t & pathSequence) const
+{
+  LinkMap::const_iterator i = m_links.find (target);
+  if (i == m_links.end ())
+    {
+      return false;
+    }
+  parent = i->second.parent;
+  pathSequence = i->second.pathSequence;
+  return true;
+}
+
+bool
+SourceRoutingTable::LookupRoute (Ipv6Address root, Ipv6Address target, std::vector<Ipv6Address> & hops) const
+{
+  hops.clear ();
+  if (target == root)
+    {
+      return false;
+    }
+  Ipv6Address hop = target;
+  // a path visits each target at most once, a longer walk is a loop
+  while (hop != root && hops.size () <= m_links.size ())
+    {
+      LinkMap::const_iterator i = m_links.find (hop);
+      if (i == m_links.end ())
+        {
+          hops.clear ();
+          return false;
+        }
+      hops.push_back (hop);
+      hop = i->second.parent;
+    }
+  if (hop != root)
+    {
+      NS_LOG_LOGIC ("Loop in the DAO parents of " << target);
+      hops.clear ();
+      return false;
+    }
+  std::reverse (hops.begin (), hops.end ());
+  return true;
+}
+
+bool
+SourceRoutingTable::DeleteRoute (Ipv6Address target)
+{
+  // the deadline left in the heap is skipped when popped
+  return m_links.erase (target) > 0;
+}
+
+void
+SourceRoutingTable::Purge ()
+{
+  Ipv6Address target;
+  while (m_expiryIndex.PopExpired (*this, Simulator::Now (), target))
+    {
+      NS_LOG_LOGIC ("DAO parent of " << target << " expired");
+      m_links.erase (target);
+    }
+}
+
+bool
+SourceRoutingTable::GetNextExpiry (Time & expiry)
+{
+  return m_expiryIndex.GetNextExpiry (*this, expiry);
+}
+
+bool
+SourceRoutingTable::IsCurrentDeadline (Ipv6Address target, Time expire) const
+{
+  LinkMap::const_iterator i = m_links.find (target);
+  return i != m_links.end () && i->second.expire == expire;
+}
+
+void
+SourceRoutingTable::Clear ()
+{
+  m_links.clear ();
+  m_expiryIndex.Clear ();
+}
+
+uint32_t
+SourceRoutingTable::Size () const
+{
+  return m_links.size ();
+}
+
+void
+SourceRoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
+{
+  *stream->GetStream () << "\nRPL DAO parents\n" << "Target\t\tParent\t\tPathSequence\t\tExpire\n";
+  for (LinkMap::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      *stream->GetStream () << std::setiosflags (std::ios::fixed) << i->first << "\t\t" << i->second.parent << "\t\t"
+                            << std::setw (10) << (uint32_t) i->second.pathSequence << "\t" << std::setprecision (3)
+                            << (i->second.expire - Simulator::Now ()).GetSeconds () << "s\n";
+    }
+  *stream->GetStream () << "\n";
+}
+
+} // namespace rpl
+} // namespace ns3
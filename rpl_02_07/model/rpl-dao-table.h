@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RPL_DAO_TABLE_H
+#define RPL_DAO_TABLE_H
+
+#include <vector>
+#include "ns3/sgi-hashmap.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/output-stream-wrapper.h"
+#include "rpl-deadline-index.h"
+
+namespace ns3 {
+namespace rpl {
+
+/**
+ * \ingroup rpl
+ * \brief Downward route learned from a DAO
+ */
+class DaoRoutingTableEntry
+{
+public:
+  /// c-tor
+  DaoRoutingTableEntry (Ptr<NetDevice> dev = 0, Ipv6Address target = Ipv6Address (), uint8_t prefixLength = 128,
+                        Ipv6Address source = Ipv6Address (), Ipv6Address nextHop = Ipv6Address (),
+                        uint8_t pathSequence = 0, Time expire = Seconds (0));
+
+  Ipv6Address
+  GetTarget () const
+  {
+    return m_ipv6Route->GetDestination ();
+  }
+  uint8_t
+  GetPrefixLength () const
+  {
+    return m_prefixLength;
+  }
+  Ipv6Address
+  GetNextHop () const
+  {
+    return m_ipv6Route->GetGateway ();
+  }
+  /// \return the route to the next hop, shared by all the packets sent to the target
+  Ptr<Ipv6Route>
+  GetRoute () const
+  {
+    return m_ipv6Route;
+  }
+  uint8_t
+  GetPathSequence () const
+  {
+    return m_pathSequence;
+  }
+  void
+  SetPathSequence (uint8_t pathSequence)
+  {
+    m_pathSequence = pathSequence;
+  }
+  /// \return the absolute time at which the route expires
+  Time
+  GetExpireTime () const
+  {
+    return m_expire;
+  }
+  void
+  SetExpireTime (Time expire)
+  {
+    m_expire = expire;
+  }
+  void
+  Print (Ptr<OutputStreamWrapper> stream) const;
+
+private:
+  /// Route to the target through the next hop
+  Ptr<Ipv6Route> m_ipv6Route;
+  /// Length of the target prefix
+  uint8_t m_prefixLength;
+  /// Path Sequence of the Transit option that installed the route
+  uint8_t m_pathSequence;
+  /// Expiration time of the route
+  Time m_expire;
+};
+
+/**
+ * \ingroup rpl
+ * \brief Downward routes of a storing mode node, indexed by target
+ *
+ * Targets are hashed, so that a root with thousands of descendants looks up
+ * and refreshes its routes in constant time. Routes expire through a
+ * DeadlineIndex.
+ */
+class DaoRoutingTable
+{
+public:
+  /// c-tor
+  DaoRoutingTable ();
+  /**
+   * Add the route, or replace the route to the same target
+   * \param rt the route
+   */
+  void
+  Update (DaoRoutingTableEntry const & rt);
+  /**
+   * Lookup the route to target
+   * \param target the target address
+   * \param rt the route, if exists
+   * \return true on success
+   */
+  bool
+  LookupRoute (Ipv6Address target, DaoRoutingTableEntry & rt) const;
+  /**
+   * Lookup the route to forward a packet to dst
+   * \param dst the destination address
+   * \return the route, or 0 if dst is not a known target
+   */
+  Ptr<Ipv6Route>
+  LookupRoute (Ipv6Address dst) const;
+  /// Delete the route to target. \return true on success
+  bool
+  DeleteRoute (Ipv6Address target);
+  /**
+   * Delete the routes through nextHop
+   * \param nextHop the next hop
+   * \param removed receives the deleted routes
+   */
+  void
+  DeleteRoutesWithNextHop (Ipv6Address nextHop, std::vector<DaoRoutingTableEntry> & removed);
+  /**
+   * Delete the expired routes
+   * \param removed receives the deleted routes
+   */
+  void
+  Purge (std::vector<DaoRoutingTableEntry> & removed);
+  /**
+   * Get the time at which the next route expires.
+   * \param expiry the absolute expiry time of the first route to expire
+   * \return false if no route can expire
+   */
+  bool
+  GetNextExpiry (Time & expiry);
+  /**
+   * Lookup list of all routes
+   * \param routes is the list that will hold the routes
+   */
+  void
+  GetListOfAllRoutes (std::vector<DaoRoutingTableEntry> & routes) const;
+  /// Delete all routes
+  void
+  Clear ();
+  /// Number of routes
+  uint32_t
+  Size () const;
+  /// Print the routes
+  void
+  Print (Ptr<OutputStreamWrapper> stream) const;
+
+private:
+  friend class DeadlineIndex<DaoRoutingTable>;
+  typedef sgi::hash_map<Ipv6Address, DaoRoutingTableEntry, Ipv6AddressHash> RouteMap;
+
+  /// \return true if the route to target still expires at expire
+  bool
+  IsCurrentDeadline (Ipv6Address target, Time expire) const;
+
+  /// Routes by target
+  RouteMap m_routes;
+  /// Expiry index of the routes
+  DeadlineIndex<DaoRoutingTable> m_expiryIndex;
+};
+
+/**
+ * \ingroup rpl
+ * \brief DAO parent graph of a non-storing mode root
+ *
+ * Each target is mapped to the parent its DAO announced in the Transit
+ * option. The root builds the source route to a target by walking the
+ * parents up to itself, so the nodes of the DODAG keep no downward state.
+ */
+class SourceRoutingTable
+{
+public:
+  /// c-tor
+  SourceRoutingTable ();
+  /**
+   * Set the parent of target, or replace it
+   * \param target the target address
+   * \param parent the parent announced by the Transit option
+   * \param pathSequence the Path Sequence of the Transit option
+   * \param expire the absolute expiry time of the link
+   */
+  void
+  Update (Ipv6Address target, Ipv6Address parent, uint8_t pathSequence, Time expire);
+  /**
+   * Lookup the parent of target
+   * \param target the target address
+   * \param parent the parent, if exists
+   * \param pathSequence the Path Sequence of the link, if exists
+   * \return true on success
+   */
+  bool
+  LookupParent (Ipv6Address target, Ipv6Address & parent, uint8_t & pathSequence) const;
+  /**
+   * Build the source route from root to target.
+   * \param root the address the children of the root announce as parent
+   * \param target the target address
+   * \param hops receives the hops from the first one to target
+   * \return false if target is unknown, or its path does not reach root
+   */
+  bool
+  LookupRoute (Ipv6Address root, Ipv6Address target, std::vector<Ipv6Address> & hops) const;
+  /// Delete the link of target. \return true on success
+  bool
+  DeleteRoute (Ipv6Address target);
+  /// Delete the expired links
+  void
+  Purge ();
+  /**
+   * Get the time at which the next link expires.
+   * \param expiry the absolute expiry time of the first link to expire
+   * \return false if no link can expire
+   */
+  bool
+  GetNextExpiry (Time & expiry);
+  /// Delete all links
+  void
+  Clear ();
+  /// Number of targets
+  uint32_t
+  Size () const;
+  /// Print the links
+  void
+  Print (Ptr<OutputStreamWrapper> stream) const;
+
+private:
+  friend class DeadlineIndex<SourceRoutingTable>;
+  /// Link from a target to its parent
+  struct Link
+  {
+    Ipv6Address parent;
+    uint8_t pathSequence;
+    Time expire;
+  };
+  typedef sgi::hash_map<Ipv6Address, Link, Ipv6AddressHash> LinkMap;
+
+  /// \return true if the link of target still expires at expire
+  bool
+  IsCurrentDeadline (Ipv6Address target, Time expire) const;
+
+  /// Links by target
+  LinkMap m_links;
+  /// Expiry index of the links
+  DeadlineIndex<SourceRoutingTable> m_expiryIndex;
+};
+
+} // namespace rpl
+} // namespace ns3
+
+#endif /* RPL_DAO_TABLE_H */
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RPL_DEADLINE_INDEX_H
+#define RPL_DEADLINE_INDEX_H
+
+#include <queue>
+#include <vector>
+#include <functional>
+#include "ns3/ipv6-address.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace rpl {
+
+/**
+ * \ingroup rpl
+ * \brief Expiry index of the entries of a table, keyed by address
+ *
+ * A min-heap of deadlines. Refreshing or deleting an entry leaves its old
+ * deadline in the heap: the record is only checked against the table when
+ * it reaches the top, and skipped if stale. The table tells whether a
+ * record is current through
+ *
+ * bool Table::IsCurrentDeadline (Ipv6Address key, Time expire) const;
+ *
+ * which may be private if the table befriends its index.
+ */
+template <typename Table>
+class DeadlineIndex
+{
+public:
+  /**
+   * Add the deadline of an entry
+   * \param key the key of the entry
+   * \param expire the absolute time at which it expires
+   */
+  void
+  Push (Ipv6Address key, Time expire)
+  {
+    Deadline record;
+    record.expire = expire;
+    record.key = key;
+    m_heap.push (record);
+  }
+  /**
+   * Pop the next current deadline that is due
+   * \param table the indexed table
+   * \param now the current time
+   * \param key the key of the expired entry
+   * \return false if no entry is due
+   */
+  bool
+  PopExpired (Table const & table, Time now, Ipv6Address & key)
+  {
+    while (!m_heap.empty () && m_heap.top ().expire <= now)
+      {
+        Deadline record = m_heap.top ();
+        m_heap.pop ();
+        if (table.IsCurrentDeadline (record.key, record.expire))
+          {
+            key = record.key;
+            return true;
+          }
+      }
+    return false;
+  }
+  /**
+   * Get the time at which the next entry expires, dropping the stale
+   * records on the way.
+   * \param table the indexed table
+   * \param expiry the absolute expiry time of the first entry to expire
+   * \return false if no entry can expire
+   */
+  bool
+  GetNextExpiry (Table const & table, Time & expiry)
+  {
+    while (!m_heap.empty ())
+      {
+        Deadline const & record = m_heap.top ();
+        if (table.IsCurrentDeadline (record.key, record.expire))
+          {
+            expiry = record.expire;
+            return true;
+          }
+        m_heap.pop ();
+      }
+    return false;
+  }
+  /// Forget all deadlines
+  void
+  Clear ()
+  {
+    m_heap = Heap ();
+  }
+
+private:
+  /// The deadline of an entry
+  struct Deadline
+  {
+    Time expire;
+    Ipv6Address key;
+    bool operator> (Deadline const & o) const
+    {
+      return expire > o.expire;
+    }
+  };
+  typedef std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline> > Heap;
+
+  /// Min-heap of deadlines, stale ones included
+  Heap m_heap;
+};
+
+} // namespace rpl
+} // namespace ns3
+
+#endif /* RPL_DEADLINE_INDEX_H */
@@ -0,0 +1,266 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "rpl-link-estimator.h"
+#include <cstring>
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/sixlowpan-net-device.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/wifi-remote-station-manager.h"
+
+NS_LOG_COMPONENT_DEFINE ("RplLinkEstimator");
+
+namespace ns3 {
+namespace rpl {
+
+NS_OBJECT_ENSURE_REGISTERED (LinkEstimatorTag);
+
+LinkEstimatorTag::LinkEstimatorTag (Ipv6Address nextHop)
+  : m_nextHop (nextHop)
+{
+}
+
+TypeId
+LinkEstimatorTag::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::rpl::LinkEstimatorTag")
+    .SetParent<Tag> ()
+    .AddConstructor<LinkEstimatorTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+LinkEstimatorTag::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+LinkEstimatorTag::GetSerializedSize () const
+{
+  return 16;
+}
+
+void
+LinkEstimatorTag::Serialize (TagBuffer i) const
+{
+  uint8_t buf[16];
+  m_nextHop.Serialize (buf);
+  i.Write (buf, 16);
+}
+
+void
+LinkEstimatorTag::Deserialize (TagBuffer i)
+{
+  uint8_t buf[16];
+  i.Read (buf, 16);
+  m_nextHop = Ipv6Address::Deserialize (buf);
+}
+
+void
+LinkEstimatorTag::Print (std::ostream &os) const
+{
+  os << "LinkEstimatorTag: next hop = " << m_nextHop;
+}
+
+LinkEstimator::LinkEstimator ()
+{
+  Clear ();
+}
+
+bool
+LinkEstimator::Attach (Ptr<NetDevice> device)
+{
+  Ptr<sixlowpan::SixLowPanNetDevice> lowpan = DynamicCast<sixlowpan::SixLowPanNetDevice> (device);
+  if (lowpan != 0 && lowpan->GetPort () != 0)
+    {
+      device = lowpan->GetPort ();
+    }
+
+  bool ok = false;
+  bool drop = false;
+  Ptr<WifiNetDevice> wifi = DynamicCast<WifiNetDevice> (device);
+  if (wifi != 0)
+    {
+      // the 802.11 MAC reports the outcome of a frame by its header only
+      ok = wifi->GetMac ()->TraceConnectWithoutContext ("TxOkHeader",
+                                                        MakeCallback (&LinkEstimator::WifiTxOk, this));
+      drop = wifi->GetRemoteStationManager ()->TraceConnectWithoutContext ("MacTxFinalDataFailed",
+                                                                           MakeCallback (&LinkEstimator::WifiTxFailed, this));
+    }
+  else
+    {
+      // e.g. the LrWpanMac of an LrWpanNetDevice, or the device itself
+      Ptr<Object> mac = device;
+      PointerValue ptr;
+      if (device->GetAttributeFailSafe ("Mac", ptr) && ptr.Get<Object> () != 0)
+        {
+          mac = ptr.Get<Object> ();
+        }
+      ok = mac->TraceConnectWithoutContext ("MacTxOk", MakeCallback (&LinkEstimator::TxOk, this));
+      drop = mac->TraceConnectWithoutContext ("MacTxDrop", MakeCallback (&LinkEstimator::TxDrop, this));
+    }
+  if (!ok || !drop)
+    {
+      NS_LOG_WARN ("No " << (ok ? "transmit failure" : "transmit success") << " trace on device "
+                   << device->GetIfIndex () << " (" << device->GetInstanceTypeId ().GetName ()
+                   << "), its link metrics will not be estimated");
+    }
+  return ok && drop;
+}
+
+void
+LinkEstimator::TxOk (Ptr<const Packet> packet)
+{
+  LinkEstimatorTag tag;
+  if (packet->PeekPacketTag (tag))
+    {
+      Update (tag.GetNextHop (), true);
+    }
+}
+
+void
+LinkEstimator::TxDrop (Ptr<const Packet> packet)
+{
+  LinkEstimatorTag tag;
+  if (packet->PeekPacketTag (tag))
+    {
+      Update (tag.GetNextHop (), false);
+    }
+}
+
+void
+LinkEstimator::WifiTxOk (const WifiMacHeader &header)
+{
+  // broadcast frames are not acknowledged
+  if (header.IsData () && !header.GetAddr1 ().IsGroup ())
+    {
+      Update (Ipv6Address::MakeAutoconfiguredLinkLocalAddress (header.GetAddr1 ()), true);
+    }
+}
+
+void
+LinkEstimator::WifiTxFailed (Mac48Address address)
+{
+  Update (Ipv6Address::MakeAutoconfiguredLinkLocalAddress (address), false);
+}
+
+bool
+LinkEstimator::SameNeighbor (Ipv6Address a, Ipv6Address b)
+{
+  uint8_t x[16];
+  uint8_t y[16];
+  a.GetBytes (x);
+  b.GetBytes (y);
+  return std::memcmp (x + 8, y + 8, 8) == 0;
+}
+
+LinkEstimator::Link *
+LinkEstimator::Find (Ipv6Address neighbor)
+{
+  for (Link *l = m_links; l < m_links + RPL_LINK_ESTIMATOR_SIZE; ++l)
+    {
+      if (l->used && SameNeighbor (l->neighbor, neighbor))
+        {
+          return l;
+        }
+    }
+  return 0;
+}
+
+void
+LinkEstimator::Update (Ipv6Address neighbor, bool acked)
+{
+  uint8_t sample = acked ? NEIGHBOR_INFO_ETX2FIX (1) : NEIGHBOR_INFO_ETX2FIX (RPL_LINK_ETX_NOACK_PENALTY);
+  uint8_t etx = sample;
+  Link *link = Find (neighbor);
+
+  if (link == 0)
+    {
+      // a new neighbor takes a free slot, or the least recently updated one
+      link = m_links;
+      for (Link *l = m_links; l < m_links + RPL_LINK_ESTIMATOR_SIZE; ++l)
+        {
+          if (!l->used)
+            {
+              link = l;
+              break;
+            }
+          if (l->updated < link->updated)
+            {
+              link = l;
+            }
+        }
+      link->neighbor = neighbor;
+      link->used = true;
+      link->etx = 0;
+    }
+  else
+    {
+      etx = (link->etx * RPL_LINK_ETX_ALPHA + sample * (RPL_LINK_ETX_SCALE - RPL_LINK_ETX_ALPHA))
+        / RPL_LINK_ETX_SCALE;
+    }
+  link->updated = Simulator::Now ();
+
+  if (etx == link->etx)
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("ETX of the link to " << neighbor << " is now "
+                << (double) etx / NEIGHBOR_INFO_ETX_DIVISOR);
+  link->etx = etx;
+  if (!m_linkMetricCallback.IsNull ())
+    {
+      m_linkMetricCallback (neighbor, etx);
+    }
+}
+
+bool
+LinkEstimator::Lookup (Ipv6Address neighbor, uint8_t & etx) const
+{
+  Link *link = const_cast<LinkEstimator *> (this)->Find (neighbor);
+  if (link == 0)
+    {
+      return false;
+    }
+  etx = link->etx;
+  return true;
+}
+
+void
+LinkEstimator::Clear ()
+{
+  for (Link *l = m_links; l < m_links + RPL_LINK_ESTIMATOR_SIZE; ++l)
+    {
+      l->used = false;
+      l->etx = 0;
+    }
+}
+
+void
+LinkEstimator::SetNextHop (Ptr<Packet> packet, Ipv6Address nextHop)
+{
+  LinkEstimatorTag tag;
+  packet->RemovePacketTag (tag);
+  packet->AddPacketTag (LinkEstimatorTag (nextHop));
+}
+
+} // namespace rpl
+} // namespace ns3
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RPL_LINK_ESTIMATOR_H
+#define RPL_LINK_ESTIMATOR_H
+
+#include "ns3/callback.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/mac48-address.h"
+#include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/tag.h"
+#include "rpl-conf.h"
+
+namespace ns3 {
+
+class WifiMacHeader;
+
+namespace rpl {
+
+/**
+ * \ingroup rpl
+ * \brief Tag naming the neighbor a unicast packet is sent to
+ *
+ * The MAC transmit traces only carry the packet; the tag tells the link
+ * estimator which link the outcome belongs to.
+ */
+class LinkEstimatorTag : public Tag
+{
+public:
+  /// c-tor
+  LinkEstimatorTag (Ipv6Address nextHop = Ipv6Address ());
+
+  static TypeId GetTypeId ();
+  virtual TypeId GetInstanceTypeId () const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+  Ipv6Address
+  GetNextHop () const
+  {
+    return m_nextHop;
+  }
+
+private:
+  /// Neighbor the packet is sent to
+  Ipv6Address m_nextHop;
+};
+
+/**
+ * \ingroup rpl
+ * \brief ETX estimation of the links to the neighbors from MAC transmit outcomes
+ *
+ * The estimator listens to the transmit outcome traces of the MAC below
+ * 6LoWPAN: TxOkHeader and the MacTxFinalDataFailed trace of the remote
+ * station manager on a WifiNetDevice, the MacTxOk and MacTxDrop traces of
+ * the "Mac" object of other devices, e.g. an LrWpanNetDevice, or of the
+ * device itself. The 802.11 traces name the receiver by its MAC address
+ * only, so neighbors are told apart by the interface identifier of their
+ * address, which is autoconfigured from the MAC address.
+ *
+ * Each outcome updates an exponentially weighted moving
+ * average of the ETX of the neighbor, as the Contiki neighbor-info module
+ * does; an acknowledged frame counts as one transmission, a dropped one as
+ * RPL_LINK_ETX_NOACK_PENALTY. The estimates are kept in a table of
+ * RPL_LINK_ESTIMATOR_SIZE neighbors, the least recently updated one is
+ * evicted for a new neighbor.
+ *
+ * ETX values are fixed-point, in NEIGHBOR_INFO_ETX_DIVISOR units, as
+ * rpl_parent::link_metric.
+ */
+class LinkEstimator
+{
+public:
+  /// Called with the neighbor and its new ETX when the ETX changes
+  typedef Callback<void, Ipv6Address, uint8_t> LinkMetricCallback;
+
+  /// c-tor
+  LinkEstimator ();
+  void
+  SetLinkMetricCallback (LinkMetricCallback cb)
+  {
+    m_linkMetricCallback = cb;
+  }
+  /**
+   * Listen to the transmit outcomes of a device, or of the port of a
+   * 6LoWPAN device.
+   * \param device the device of an RPL interface
+   * \return false if the device lacks the success or the failure trace
+   */
+  bool
+  Attach (Ptr<NetDevice> device);
+  /**
+   * Account for the outcome of a transmission to a neighbor
+   * \param neighbor the neighbor
+   * \param acked whether the frame was acknowledged
+   */
+  void
+  Update (Ipv6Address neighbor, bool acked);
+  /**
+   * Lookup the ETX of the link to a neighbor
+   * \param neighbor the neighbor
+   * \param etx the fixed-point ETX, if known
+   * \return true if the neighbor is in the table
+   */
+  bool
+  Lookup (Ipv6Address neighbor, uint8_t & etx) const;
+  /// Forget all neighbors
+  void
+  Clear ();
+  /// Mark packet as sent to nextHop, replacing the mark of a previous hop
+  static void
+  SetNextHop (Ptr<Packet> packet, Ipv6Address nextHop);
+
+private:
+  /// Estimated link
+  struct Link
+  {
+    Ipv6Address neighbor;
+    Time updated;
+    uint8_t etx;
+    bool used;
+  };
+
+  /// MacTxOk trace sink
+  void
+  TxOk (Ptr<const Packet> packet);
+  /// MacTxDrop trace sink
+  void
+  TxDrop (Ptr<const Packet> packet);
+  /// TxOkHeader trace sink of a WifiMac
+  void
+  WifiTxOk (const WifiMacHeader &header);
+  /// MacTxFinalDataFailed trace sink of a WifiRemoteStationManager
+  void
+  WifiTxFailed (Mac48Address address);
+  /// Whether two addresses have the same interface identifier
+  static bool
+  SameNeighbor (Ipv6Address a, Ipv6Address b);
+  /// Find the link to neighbor, or 0
+  Link *
+  Find (Ipv6Address neighbor);
+
+  /// The links, in no particular order
+  Link m_links[RPL_LINK_ESTIMATOR_SIZE];
+  LinkMetricCallback m_linkMetricCallback;
+};
+
+} // namespace rpl
+} // namespace ns3
+
+#endif /* RPL_LINK_ESTIMATOR_H */
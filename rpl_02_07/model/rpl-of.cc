@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* Objective functions, after ContikiRPL's rpl-of0.c and rpl-mrhof.c. */
+
+#include "rpl-of.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE("RplObjectiveFunction");
+
+namespace ns3 {
+namespace rpl {
+
+/*---------------------------------------------------------------------------*/
+/* Increment of the rank, saturated at INFINITE_RANK. */
+static rpl_rank_t add_rank(rpl_rank_t base_rank, uint32_t increment) {
+	if ((uint32_t) INFINITE_RANK - base_rank <= increment) {
+		return INFINITE_RANK;
+	}
+	return base_rank + increment;
+}
+/*---------------------------------------------------------------------------*/
+/* Both OFs prefer a grounded DAG, then the preferred one, then the lowest
+ rank. */
+static rpl_dag_t *
+best_dag(rpl_dag_t *d1, rpl_dag_t *d2) {
+	if (d1->grounded != d2->grounded) {
+		return d1->grounded ? d1 : d2;
+	}
+	if (d1->preference != d2->preference) {
+		return d1->preference > d2->preference ? d1 : d2;
+	}
+	return d1->rank < d2->rank ? d1 : d2;
+}
+/*---------------------------------------------------------------------------*/
+static void reset(rpl_dag_t *dag) {
+	NS_LOG_DEBUG ("RPL: Resetting the OF state of DAG " << dag->dag_id);
+}
+/*---------------------------------------------------------------------------*/
+static void parent_state_callback(rpl_parent_t *parent, int known, int etx) {
+	if (known) {
+		parent->link_metric = etx;
+	}
+}
+/*---------------------------------------------------------------------------*/
+/* OF0 */
+
+/* Rank difference, one and a half rank steps, a parent must beat the
+ preferred parent by. */
+#define OF0_MIN_DIFFERENCE(instance) \
+	((instance)->min_hoprankinc + (instance)->min_hoprankinc / 2)
+
+static rpl_rank_t of0_calculate_rank(rpl_parent_t *p, rpl_rank_t base_rank) {
+	rpl_rank_t increment;
+
+	if (p == NULL) {
+		if (base_rank == 0) {
+			return INFINITE_RANK;
+		}
+		increment = RPL_MIN_HOPRANKINC;
+	} else {
+		/* step_of_rank of 1, no stretch */
+		increment = p->dag->instance->min_hoprankinc;
+		if (base_rank == 0) {
+			base_rank = p->rank;
+		}
+	}
+	return add_rank(base_rank, increment);
+}
+/*---------------------------------------------------------------------------*/
+static rpl_parent_t *
+of0_best_parent(rpl_parent_t *p1, rpl_parent_t *p2) {
+	rpl_dag_t *dag = p1->dag;
+	int32_t r1, r2, difference;
+
+	r1 = DAG_RANK(p1->rank, dag->instance) * dag->instance->min_hoprankinc
+			+ p1->link_metric;
+	r2 = DAG_RANK(p2->rank, dag->instance) * dag->instance->min_hoprankinc
+			+ p2->link_metric;
+	difference = OF0_MIN_DIFFERENCE(dag->instance);
+
+	/* Keep the preferred parent unless the other one is clearly better. */
+	if ((p1 == dag->preferred_parent || p2 == dag->preferred_parent)
+			&& r1 < r2 + difference && r1 > r2 - difference) {
+		return dag->preferred_parent;
+	}
+	return r1 < r2 ? p1 : p2;
+}
+/*---------------------------------------------------------------------------*/
+static void of0_update_metric_container(rpl_instance_t *instance) {
+	instance->mc.type = RPL_DAG_MC_NONE;
+}
+/*---------------------------------------------------------------------------*/
+rpl_of_t rpl_of0 = {
+	reset,
+	parent_state_callback,
+	of0_best_parent,
+	best_dag,
+	of0_calculate_rank,
+	of0_update_metric_container,
+	RPL_OCP_OF0
+};
+/*---------------------------------------------------------------------------*/
+/* MRHOF */
+
+/* Path cost difference, in rank units, a parent must beat the preferred
+ parent by: an ETX of 1.5, as PARENT_SWITCH_THRESHOLD of RFC 6719. */
+#define MRHOF_SWITCH_THRESHOLD(instance) \
+	((instance)->min_hoprankinc + (instance)->min_hoprankinc / 2)
+
+/* Rank increase of the link to p: its ETX in MinHopRankIncrease units. */
+static uint32_t mrhof_link_cost(rpl_parent_t *p) {
+	return (uint32_t) p->link_metric * p->dag->instance->min_hoprankinc
+			/ NEIGHBOR_INFO_ETX_DIVISOR;
+}
+/*---------------------------------------------------------------------------*/
+/* Cost of the path through p, in rank units. The rank of an MRHOF node is
+ the ETX of its path, so it stands for the path cost when the DIO carries no
+ ETX metric container. */
+static uint32_t mrhof_path_cost(rpl_parent_t *p) {
+	rpl_instance_t *instance = p->dag->instance;
+
+	if (p->mc.type == RPL_DAG_MC_ETX) {
+		return ROOT_RANK(instance) + (uint32_t) p->mc.obj.etx
+				* instance->min_hoprankinc / RPL_DAG_MC_ETX_DIVISOR
+				+ mrhof_link_cost(p);
+	}
+	return (uint32_t) p->rank + mrhof_link_cost(p);
+}
+/*---------------------------------------------------------------------------*/
+static rpl_rank_t mrhof_calculate_rank(rpl_parent_t *p, rpl_rank_t base_rank) {
+	uint32_t increment;
+
+	if (p == NULL) {
+		if (base_rank == 0) {
+			return INFINITE_RANK;
+		}
+		increment = (uint32_t) RPL_INIT_LINK_METRIC * RPL_MIN_HOPRANKINC
+				/ NEIGHBOR_INFO_ETX_DIVISOR;
+	} else {
+		increment = mrhof_link_cost(p);
+		if (base_rank == 0) {
+			base_rank = p->rank;
+		}
+	}
+	return add_rank(base_rank, increment);
+}
+/*---------------------------------------------------------------------------*/
+static rpl_parent_t *
+mrhof_best_parent(rpl_parent_t *p1, rpl_parent_t *p2) {
+	rpl_dag_t *dag = p1->dag;
+	uint32_t c1, c2, threshold;
+
+	c1 = mrhof_path_cost(p1);
+	c2 = mrhof_path_cost(p2);
+	threshold = MRHOF_SWITCH_THRESHOLD(dag->instance);
+
+	/* Hysteresis: a parent replaces the preferred one only if its path is
+	 cheaper by the switch threshold. */
+	if (p1 == dag->preferred_parent && c2 + threshold > c1) {
+		return p1;
+	}
+	if (p2 == dag->preferred_parent && c1 + threshold > c2) {
+		return p2;
+	}
+	return c1 < c2 ? p1 : p2;
+}
+/*---------------------------------------------------------------------------*/
+static void mrhof_update_metric_container(rpl_instance_t *instance) {
+	rpl_dag_t *dag = instance->current_dag;
+	uint32_t cost = 0;
+
+	instance->mc.type = RPL_DAG_MC_ETX;
+	instance->mc.flags = RPL_DAG_MC_FLAG_P;
+	instance->mc.aggr = RPL_DAG_MC_AGGR_ADDITIVE;
+	instance->mc.prec = 0;
+	instance->mc.length = sizeof(instance->mc.obj.etx);
+
+	if (dag == NULL || !dag->joined) {
+		return;
+	}
+	if (dag->rank != ROOT_RANK(instance) && dag->preferred_parent != NULL) {
+		cost = mrhof_path_cost(dag->preferred_parent) - ROOT_RANK(instance);
+	}
+	cost = cost * RPL_DAG_MC_ETX_DIVISOR / instance->min_hoprankinc;
+	instance->mc.obj.etx = cost > 0xffff ? 0xffff : cost;
+}
+/*---------------------------------------------------------------------------*/
+rpl_of_t rpl_mrhof = {
+	reset,
+	parent_state_callback,
+	mrhof_best_parent,
+	best_dag,
+	mrhof_calculate_rank,
+	mrhof_update_metric_container,
+	RPL_OCP_MRHOF
+};
+/*---------------------------------------------------------------------------*/
+rpl_of_t *rpl_objective_functions[] = { &rpl_of0, &rpl_mrhof, NULL };
+
+} // namespace rpl
+} // namespace ns3
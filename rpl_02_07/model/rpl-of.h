@@ -0,0 +1,41 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RPL_OF_H
+#define RPL_OF_H
+
+#include "rpl-packet.h"
+
+namespace ns3 {
+namespace rpl {
+
+/*---------------------------------------------------------------------------*/
+/* Objective Function Zero (RFC 6552): the rank grows by MinHopRankIncrease
+ per hop, the link metric only breaks ties between parents. */
+extern rpl_of_t rpl_of0;
+
+/* Minimum Rank with Hysteresis Objective Function (RFC 6719) over ETX: the
+ rank grows by the ETX of the link to the preferred parent, which only
+ changes for a path that is better by PARENT_SWITCH_THRESHOLD. */
+extern rpl_of_t rpl_mrhof;
+
+/* The objective functions a node can join a DODAG with, NULL terminated. */
+extern rpl_of_t *rpl_objective_functions[];
+
+} // namespace rpl
+} // namespace ns3
+
+#endif /* RPL_OF_H */
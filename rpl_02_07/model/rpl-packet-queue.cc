@@ -29,8 +29,6 @@
  * US Department of Defense (DoD), and ITTC at The University of Kansas.
  */
 #include "rpl-packet-queue.h"
-#include <algorithm>
-#include <functional>
 #include "ns3/ipv6-route.h"
 #include "ns3/socket.h"
 #include "ns3/log.h"
@@ -39,11 +37,99 @@ NS_LOG_COMPONENT_DEFINE ("RplPacketQueue");
 
 namespace ns3 {
 namespace rpl {
+
+PacketQueue::Priority
+PacketQueue::GetPriority (Ipv6Header const & header)
+{
+  uint8_t precedence = header.GetTrafficClass () >> 5;
+  if (precedence >= 6)
+    {
+      return PRIORITY_CONTROL;
+    }
+  if (precedence >= 4)
+    {
+      return PRIORITY_ALARM;
+    }
+  return PRIORITY_BULK;
+}
+
+uint32_t
+PacketQueue::DstQueue::Find (uint64_t uid) const
+{
+  uint32_t i = 0;
+  while (i < m_count && Get (i).GetPacket ()->GetUid () != uid)
+    {
+      ++i;
+    }
+  return i;
+}
+
+uint32_t
+PacketQueue::DstQueue::Find (uint64_t uid, Time expire) const
+{
+  Time left = expire - Simulator::Now ();
+  uint32_t i = 0;
+  while (i < m_count && (Get (i).GetPacket ()->GetUid () != uid || Get (i).GetExpireTime () != left))
+    {
+      ++i;
+    }
+  return i;
+}
+
+void
+PacketQueue::DstQueue::PushBack (QueueEntry const & entry)
+{
+  if (m_count == m_ring.size ())
+    {
+      std::vector<QueueEntry> ring;
+      ring.reserve (m_count < 2 ? 4 : 2 * m_count);
+      for (uint32_t i = 0; i < m_count; ++i)
+        {
+          ring.push_back (Get (i));
+        }
+      ring.resize (ring.capacity ());
+      m_ring.swap (ring);
+      m_head = 0;
+    }
+  m_ring[(m_head + m_count) % m_ring.size ()] = entry;
+  ++m_count;
+}
+
+void
+PacketQueue::DstQueue::PopFront ()
+{
+  NS_ASSERT (m_count > 0);
+  // release the packet
+  m_ring[m_head] = QueueEntry ();
+  m_head = (m_head + 1) % m_ring.size ();
+  --m_count;
+}
+
+void
+PacketQueue::DstQueue::Remove (uint32_t i)
+{
+  NS_ASSERT (i < m_count);
+  uint32_t size = m_ring.size ();
+  for (uint32_t k = i; k + 1 < m_count; ++k)
+    {
+      m_ring[(m_head + k) % size] = m_ring[(m_head + k + 1) % size];
+    }
+  m_ring[(m_head + m_count - 1) % size] = QueueEntry ();
+  --m_count;
+}
+
 uint32_t
 PacketQueue::GetSize ()
 {
   Purge ();
-  return m_queue.size ();
+  return m_size;
+}
+
+uint32_t
+PacketQueue::GetNBytes ()
+{
+  Purge ();
+  return m_bytes;
 }
 
 bool
@@ -51,32 +137,56 @@ PacketQueue::Enqueue (QueueEntry & entry)
 {
   NS_LOG_FUNCTION ("Enqueing packet destined for" << entry.GetIpv6Header ().GetDestinationAddress());
   Purge ();
-  uint32_t numPacketswithdst;
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  Ipv6Address dst = entry.GetIpv6Header ().GetDestinationAddress ();
+  uint32_t size = entry.GetPacket ()->GetSize ();
+  Priority priority = GetPriority (entry.GetIpv6Header ());
+  uint32_t numPacketswithdst = 0;
+  DstMap::iterator q = Prune (dst);
+  if (q != m_queue.end ())
     {
-      if ((i->GetPacket ()->GetUid () == entry.GetPacket ()->GetUid ())
-          && (i->GetIpv6Header ().GetDestinationAddress()
-              == entry.GetIpv6Header ().GetDestinationAddress()))
+      numPacketswithdst = q->second.GetCount ();
+      if (q->second.Find (entry.GetPacket ()->GetUid ()) < numPacketswithdst)
         {
           return false;
         }
     }
-  numPacketswithdst = GetCountForPacketsWithDst (entry.GetIpv6Header ().GetDestinationAddress());
   NS_LOG_DEBUG ("Number of packets with this destination: " << numPacketswithdst);
   /** For Brock Paper comparision*/
-  if (numPacketswithdst >= m_maxLenPerDst || m_queue.size () >= m_maxLen)
+  bool fits = size <= m_maxBytes;
+  if (fits && numPacketswithdst >= m_maxLenPerDst)
+    {
+      NS_LOG_DEBUG ("Max packets reached for this destination");
+      fits = numPacketswithdst > 0 && MakeRoom (q, priority);
+    }
+  while (fits && (m_size >= m_maxLen || m_bytes + size > m_maxBytes))
     {
-      NS_LOG_DEBUG ("Max packets reached for this destination. Not queuing any further packets");
+      NS_LOG_DEBUG ("Max packets or bytes reached");
+      fits = MakeRoom (priority);
+    }
+  if (!fits)
+    {
+      NS_LOG_DEBUG ("Not queuing the packet");
+      Drop (entry, DROP_REASON_TAIL);
       return false;
     }
-  else
+  // NS_LOG_DEBUG("Packet size while enqueing "<<entry.GetPacket()->GetSize());
+  entry.SetExpireTime (m_queueTimeout);
+  m_queue[dst].PushBack (entry);
+  Arrival arrival;
+  arrival.expire = Simulator::Now () + m_queueTimeout;
+  arrival.dst = dst;
+  arrival.uid = entry.GetPacket ()->GetUid ();
+  // behind the arrivals expiring no later, which are all of them unless the timeout was shortened
+  std::deque<Arrival> & arrivals = m_arrivals[priority];
+  std::deque<Arrival>::iterator at = arrivals.end ();
+  while (at != arrivals.begin () && arrival.expire < (at - 1)->expire)
     {
-      // NS_LOG_DEBUG("Packet size while enqueing "<<entry.GetPacket()->GetSize());
-      entry.SetExpireTime (m_queueTimeout);
-      m_queue.push_back (entry);
-      return true;
+      --at;
     }
+  arrivals.insert (at, arrival);
+  ++m_size;
+  m_bytes += size;
+  return true;
 }
 
 void
@@ -84,16 +194,18 @@ PacketQueue::DropPacketWithDst (Ipv6Address dst)
 {
   NS_LOG_FUNCTION ("Dropping packet to " << dst);
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  DstMap::iterator q = m_queue.find (dst);
+  if (q == m_queue.end ())
     {
-      if (IsEqual (*i, dst))
-        {
-          Drop (*i, "DropPacketWithDst ");
-        }
+      return;
+    }
+  for (uint32_t i = 0; i < q->second.GetCount (); ++i)
+    {
+      m_bytes -= q->second.Get (i).GetPacket ()->GetSize ();
+      Drop (q->second.Get (i), DROP_REASON_FLUSHED);
     }
-  m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (),
-                                 std::bind2nd (std::ptr_fun (PacketQueue::IsEqual), dst)), m_queue.end ());
+  m_size -= q->second.GetCount ();
+  m_queue.erase (q);
 }
 
 bool
@@ -101,29 +213,29 @@ PacketQueue::Dequeue (Ipv6Address dst, QueueEntry & entry)
 {
   NS_LOG_FUNCTION ("Dequeueing packet destined for" << dst);
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+  DstMap::iterator q = Prune (dst);
+  if (q == m_queue.end ())
     {
-      if (i->GetIpv6Header ().GetDestinationAddress() == dst)
-        {
-          entry = *i;
-          m_queue.erase (i);
-          return true;
-        }
+      return false;
     }
-  return false;
+  entry = q->second.Get (0);
+  q->second.PopFront ();
+  --m_size;
+  m_bytes -= entry.GetPacket ()->GetSize ();
+  if (q->second.GetCount () == 0)
+    {
+      m_queue.erase (q);
+    }
+  return true;
 }
 
 bool
 PacketQueue::Find (Ipv6Address dst)
 {
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  if (Prune (dst) != m_queue.end ())
     {
-      if (i->GetIpv6Header ().GetDestinationAddress() == dst)
-        {
-          NS_LOG_DEBUG ("Find");
-          return true;
-        }
+      NS_LOG_DEBUG ("Find");
+      return true;
     }
   return false;
 }
@@ -131,53 +243,180 @@ PacketQueue::Find (Ipv6Address dst)
 uint32_t
 PacketQueue::GetCountForPacketsWithDst (Ipv6Address dst)
 {
-  uint32_t count = 0;
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  DstMap::iterator q = Prune (dst);
+  return q == m_queue.end () ? 0 : q->second.GetCount ();
+}
+
+PacketQueue::DstMap::iterator
+PacketQueue::Prune (Ipv6Address dst)
+{
+  DstMap::iterator q = m_queue.find (dst);
+  if (q == m_queue.end ())
     {
-      if (i->GetIpv6Header ().GetDestinationAddress() == dst)
+      return q;
+    }
+  // the ring is in arrival order, which is the expiry order unless the timeout changed
+  uint32_t i = 0;
+  while (i < q->second.GetCount ())
+    {
+      if (q->second.Get (i).GetExpireTime () >= Seconds (0))
+        {
+          ++i;
+          continue;
+        }
+      NS_LOG_DEBUG ("Dropping outdated Packets");
+      if (q->second.GetCount () == 1)
         {
-          count++;
+          Remove (q, i, DROP_REASON_EXPIRED);
+          return m_queue.end ();
         }
+      Remove (q, i, DROP_REASON_EXPIRED);
     }
-  return count;
+  return q;
 }
 
-struct IsExpired
-{
-  bool
-  operator() (QueueEntry const & e) const
-  {
-    // NS_LOG_DEBUG("Expire time for packet in req queue: "<<e.GetExpireTime ());
-    return (e.GetExpireTime () < Seconds (0));
-  }
-};
-
 void
 PacketQueue::Purge ()
 {
   // NS_LOG_DEBUG("Purging Queue");
-  IsExpired pred;
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  Time now = Simulator::Now ();
+  for (uint32_t c = 0; c < N_PRIORITIES; ++c)
     {
-      if (pred (*i))
+      while (!m_arrivals[c].empty () && m_arrivals[c].front ().expire < now)
         {
-          NS_LOG_DEBUG ("Dropping outdated Packets");
-          Drop (*i, "Drop outdated packet ");
+          Arrival arrival = m_arrivals[c].front ();
+          m_arrivals[c].pop_front ();
+          DstMap::iterator q = m_queue.find (arrival.dst);
+          if (q == m_queue.end ())
+            {
+              continue;
+            }
+          uint32_t i = q->second.Find (arrival.uid, arrival.expire);
+          if (i < q->second.GetCount ())
+            {
+              NS_LOG_DEBUG ("Dropping outdated Packets");
+              Remove (q, i, DROP_REASON_EXPIRED);
+            }
         }
     }
-  m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (), pred),
-                 m_queue.end ());
 }
 
 void
-PacketQueue::Drop (QueueEntry en, std::string reason)
+PacketQueue::Remove (DstMap::iterator q, uint32_t i, DropReason reason)
+{
+  QueueEntry entry = q->second.Get (i);
+  q->second.Remove (i);
+  --m_size;
+  m_bytes -= entry.GetPacket ()->GetSize ();
+  if (q->second.GetCount () == 0)
+    {
+      m_queue.erase (q);
+    }
+  Drop (entry, reason);
+}
+
+bool
+PacketQueue::MakeRoom (DstMap::iterator q, Priority priority)
 {
-  NS_LOG_LOGIC (reason << en.GetPacket ()->GetUid () << " " << en.GetIpv6Header ().GetDestinationAddress());
+  switch (m_dropPolicy)
+    {
+    case DROP_HEAD:
+      Remove (q, 0, DROP_REASON_HEAD);
+      return true;
+    case DROP_LOWEST_PRIORITY:
+      {
+        // the oldest packet of the lowest class
+        uint32_t victim = q->second.GetCount ();
+        Priority lowest = priority;
+        for (uint32_t i = 0; i < q->second.GetCount (); ++i)
+          {
+            Priority p = GetPriority (q->second.Get (i).GetIpv6Header ());
+            if (p < lowest)
+              {
+                lowest = p;
+                victim = i;
+              }
+          }
+        if (victim == q->second.GetCount ())
+          {
+            return false;
+          }
+        Remove (q, victim, DROP_REASON_PRIORITY);
+        return true;
+      }
+    default:
+      return false;
+    }
+}
+
+bool
+PacketQueue::MakeRoom (Priority priority)
+{
+  int victim = -1;
+  switch (m_dropPolicy)
+    {
+    case DROP_HEAD:
+      // the packet nearest its expiry, at the front of the arrivals of its class
+      for (uint32_t c = 0; c < N_PRIORITIES; ++c)
+        {
+          if (SkipStale (Priority (c))
+              && (victim < 0 || m_arrivals[c].front ().expire < m_arrivals[victim].front ().expire))
+            {
+              victim = c;
+            }
+        }
+      break;
+    case DROP_LOWEST_PRIORITY:
+      for (uint32_t c = 0; c < static_cast<uint32_t> (priority) && victim < 0; ++c)
+        {
+          if (SkipStale (Priority (c)))
+            {
+              victim = c;
+            }
+        }
+      break;
+    default:
+      break;
+    }
+  if (victim < 0)
+    {
+      return false;
+    }
+  Arrival arrival = m_arrivals[victim].front ();
+  m_arrivals[victim].pop_front ();
+  DstMap::iterator q = m_queue.find (arrival.dst);
+  Remove (q, q->second.Find (arrival.uid, arrival.expire), m_dropPolicy == DROP_HEAD ? DROP_REASON_HEAD : DROP_REASON_PRIORITY);
+  return true;
+}
+
+bool
+PacketQueue::SkipStale (Priority priority)
+{
+  std::deque<Arrival> & arrivals = m_arrivals[priority];
+  while (!arrivals.empty ())
+    {
+      DstMap::const_iterator q = m_queue.find (arrivals.front ().dst);
+      if (q != m_queue.end ()
+          && q->second.Find (arrivals.front ().uid, arrivals.front ().expire) < q->second.GetCount ())
+        {
+          return true;
+        }
+      arrivals.pop_front ();
+    }
+  return false;
+}
+
+void
+PacketQueue::Drop (QueueEntry const & en, DropReason reason)
+{
+  NS_LOG_LOGIC ("Drop packet " << en.GetPacket ()->GetUid () << " to " << en.GetIpv6Header ().GetDestinationAddress()
+                               << ", reason " << reason);
   // en.GetErrorCallback () (en.GetPacket (), en.GetIpv6Header (),
   //   Socket::ERROR_NOROUTETOHOST);
-  return;
+  if (!m_dropCallback.IsNull ())
+    {
+      m_dropCallback (en, reason);
+    }
 }
 
 }
@@ -32,7 +32,10 @@
 #ifndef DSDV_PACKETQUEUE_H
 #define DSDV_PACKETQUEUE_H
 
+#include <deque>
 #include <vector>
+#include "ns3/sgi-hashmap.h"
+#include "ns3/callback.h"
 #include "ns3/ipv6-routing-protocol.h"
 #include "ns3/simulator.h"
 
@@ -126,17 +129,60 @@ private:
  * \ingroup dsdv
  * \brief DSDV Packet queue
  *
- * When a route is not available, the packets are queued. Every node can buffer up to 5 packets per
- * destination. We have implemented a "drop front on full" queue where the first queued packet will be dropped
- * to accommodate newer packets.
+ * When a route is not available, the packets are queued until the route arrives or the queue
+ * timeout expires. The queue is bounded in packets, in packets per destination and in bytes.
+ * A packet that does not fit is handled by the drop policy: by default (DROP_TAIL) the new
+ * packet is refused, DROP_HEAD evicts the queued packets nearest their expiry instead, and
+ * DROP_LOWEST_PRIORITY evicts those of a lower priority class than the new packet.
+ *
+ * The packets are kept in a FIFO ring per destination, found by hashing the destination, so
+ * the operations only visit the packets of their destination. The arrivals of the packets of
+ * each class are kept in expiry order, which is their arrival order as long as the queue
+ * timeout does not change: the expired packets are found from the front of the arrivals
+ * without scanning the queue.
+ *
+ * Every dropped packet is reported to the drop callback with the reason of the drop.
  */
 class PacketQueue
 {
 public:
+  /// Priority classes of the packets, from the precedence of their IPv6 traffic class
+  enum Priority
+  {
+    PRIORITY_BULK = 0,     // !< precedence 0 to 3
+    PRIORITY_ALARM = 1,     // !< precedence 4 and 5, which include the expedited forwarding class
+    PRIORITY_CONTROL = 2,     // !< precedence 6 and 7, network control
+    N_PRIORITIES = 3,
+  };
+  /// What is dropped when a packet does not fit in the queue
+  enum DropPolicy
+  {
+    DROP_TAIL = 0,     // !< the new packet
+    DROP_HEAD = 1,     // !< the packets nearest their expiry, the oldest ones for a fixed timeout
+    DROP_LOWEST_PRIORITY = 2,     // !< the packets nearest their expiry of the lowest class below the new packet, else the new packet
+  };
+  /// Why a packet is dropped from the queue
+  enum DropReason
+  {
+    DROP_REASON_TAIL = 0,     // !< refused as the queue was full
+    DROP_REASON_HEAD = 1,     // !< evicted as the oldest packet
+    DROP_REASON_PRIORITY = 2,     // !< evicted for a packet of a higher class
+    DROP_REASON_EXPIRED = 3,     // !< queued for longer than the queue timeout
+    DROP_REASON_FLUSHED = 4,     // !< dropped with all the packets to its destination
+  };
+  /// Callback of the dropped packets
+  typedef Callback<void, QueueEntry const &, DropReason> DropCallback;
+
   /// Default c-tor
   PacketQueue ()
+    : m_maxBytes (0xffffffff),
+      m_dropPolicy (DROP_TAIL),
+      m_size (0),
+      m_bytes (0)
   {
   }
+  /// \return the priority class of a packet with header
+  static Priority GetPriority (Ipv6Header const & header);
   /// Push entry in queue, if there is no entry with the same packet and destination address in queue.
   bool Enqueue (QueueEntry & entry);
   /// Return first found (the earliest) entry for given destination
@@ -150,6 +196,8 @@ public:
   GetCountForPacketsWithDst (Ipv6Address dst);
   /// Number of entries
   uint32_t GetSize ();
+  /// Number of bytes of the queued packets
+  uint32_t GetNBytes ();
   ///\name Fields
   // \{
   uint32_t GetMaxQueueLen () const
@@ -176,24 +224,108 @@ public:
   {
     m_queueTimeout = t;
   }
+  uint32_t GetMaxQueueBytes () const
+  {
+    return m_maxBytes;
+  }
+  void SetMaxQueueBytes (uint32_t bytes)
+  {
+    m_maxBytes = bytes;
+  }
+  DropPolicy GetDropPolicy () const
+  {
+    return m_dropPolicy;
+  }
+  void SetDropPolicy (DropPolicy policy)
+  {
+    m_dropPolicy = policy;
+  }
+  void SetDropCallback (DropCallback cb)
+  {
+    m_dropCallback = cb;
+  }
   // \}
 
 private:
-  std::vector<QueueEntry> m_queue;
+  /// Packets to a destination, in arrival order
+  class DstQueue
+  {
+public:
+    DstQueue ()
+      : m_head (0),
+        m_count (0)
+    {
+    }
+    uint32_t GetCount () const
+    {
+      return m_count;
+    }
+    /// \return the i-th packet from the front
+    QueueEntry const & Get (uint32_t i) const
+    {
+      return m_ring[(m_head + i) % m_ring.size ()];
+    }
+    /// \return the index of the packet with uid, or GetCount ()
+    uint32_t Find (uint64_t uid) const;
+    /// \return the index of the packet with uid queued until expire, or GetCount ()
+    uint32_t Find (uint64_t uid, Time expire) const;
+    void PushBack (QueueEntry const & entry);
+    void PopFront ();
+    /// Remove the i-th packet from the front
+    void Remove (uint32_t i);
+
+private:
+    std::vector<QueueEntry> m_ring;
+    uint32_t m_head;
+    uint32_t m_count;
+  };
+  typedef sgi::hash_map<Ipv6Address, DstQueue, Ipv6AddressHash> DstMap;
+  /// Arrival of a queued packet, which identifies the packet by its uid and expiry time
+  struct Arrival
+  {
+    Time expire;
+    Ipv6Address dst;
+    uint64_t uid;
+  };
+
+  /// Drop the expired packets of the queue of dst
+  /// \return the queue of dst, or m_queue.end () if empty
+  DstMap::iterator Prune (Ipv6Address dst);
   /// Remove all expired entries
   void Purge ();
-  /// Notify that packet is dropped from queue by timeout
-  void Drop (QueueEntry en, std::string reason);
+  /// Remove the i-th packet of the queue q, erasing q if it empties
+  void Remove (DstMap::iterator q, uint32_t i, DropReason reason);
+  /// Evict a packet of the queue of q for a packet of class priority, after the drop policy
+  /// \return false if the policy keeps the queued packets
+  bool MakeRoom (DstMap::iterator q, Priority priority);
+  /// Evict a packet of the queue for a packet of class priority, after the drop policy
+  /// \return false if the policy keeps the queued packets
+  bool MakeRoom (Priority priority);
+  /// Drop the arrivals of class priority whose packet left the queue, from the front
+  /// \return false if no arrival is left
+  bool SkipStale (Priority priority);
+  /// Notify that packet is dropped from queue
+  void Drop (QueueEntry const & en, DropReason reason);
   /// The maximum number of packets that we allow a routing protocol to buffer.
   uint32_t m_maxLen;
   /// The maximum number of packets that we allow per destination to buffer.
   uint32_t m_maxLenPerDst;
   /// The maximum period of time that a routing protocol is allowed to buffer a packet for, seconds.
   Time m_queueTimeout;
-  static bool IsEqual (QueueEntry en, const Ipv6Address dst)
-  {
-    return (en.GetIpv6Header ().GetDestinationAddress() == dst);
-  }
+  /// The maximum number of bytes of the buffered packets.
+  uint32_t m_maxBytes;
+  /// What is dropped when a packet does not fit
+  DropPolicy m_dropPolicy;
+  /// Callback of the dropped packets
+  DropCallback m_dropCallback;
+  /// Queued packets by destination. Destinations without packets are erased.
+  DstMap m_queue;
+  /// Arrivals of the queued packets of each class, in expiry order. Those of dequeued packets are skipped when reached.
+  std::deque<Arrival> m_arrivals[N_PRIORITIES];
+  /// Number of queued packets
+  uint32_t m_size;
+  /// Number of bytes of the queued packets
+  uint32_t m_bytes;
 };
 }
 }
@@ -32,6 +32,7 @@
 #include "rpl-conf.h"
 #include "ns3/address-utils.h"
 #include "ns3/packet.h"
+#include <cstring>
 
 namespace ns3 {
 namespace rpl {
@@ -57,7 +58,7 @@ TypeId RplHeader::GetInstanceTypeId() const {
 }
 
 uint32_t RplHeader::GetSerializedSize() const {
-	return 12;
+	return 24;
 }
 
 void RplHeader::Serialize(Buffer::Iterator i) const {
@@ -84,6 +85,506 @@ void RplHeader::Print(std::ostream &os) const {
 			<< " SequenceNumber: " << m_dstSeqNo;
 }
 
+/*
+ * Batch of route updates
+ */
+
+static uint32_t GetVarintSize(uint32_t value) {
+	uint32_t size = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		size++;
+	}
+	return size;
+}
+
+static void WriteVarint(Buffer::Iterator &i, uint32_t value) {
+	while (value >= 0x80) {
+		i.WriteU8((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	i.WriteU8(value);
+}
+
+/* Read a varint of at most 5 octets. Return false if it runs past the end
+ of the buffer or is longer. */
+static bool ReadVarint(Buffer::Iterator &i, uint32_t &value) {
+	uint8_t byte;
+	int shift = 0;
+	value = 0;
+	do {
+		if (i.GetRemainingSize() == 0 || shift >= 35) {
+			return false;
+		}
+		byte = i.ReadU8();
+		value |= (uint32_t) (byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return true;
+}
+
+/* Map the difference of two sequence numbers, modulo 2^32, to a small
+ value when it is close to 0 in either direction. */
+static uint32_t ZigZag(uint32_t delta) {
+	return (delta << 1) ^ (uint32_t) ((int32_t) delta >> 31);
+}
+
+static uint32_t UnZigZag(uint32_t value) {
+	return (value >> 1) ^ (uint32_t) -(int32_t) (value & 1);
+}
+
+NS_OBJECT_ENSURE_REGISTERED(RplUpdateHeader);
+
+RplUpdateHeader::RplUpdateHeader() :
+		m_prefixLen(0) {
+}
+
+RplUpdateHeader::~RplUpdateHeader() {
+}
+
+TypeId RplUpdateHeader::GetTypeId(void) {
+	static TypeId tid =
+			TypeId("ns3::rpl::RplUpdateHeader").SetParent<Header>().AddConstructor<
+					RplUpdateHeader>();
+	return tid;
+}
+
+TypeId RplUpdateHeader::GetInstanceTypeId() const {
+	return GetTypeId();
+}
+
+void RplUpdateHeader::AddRecord(RplHeader const & record) {
+	if (m_records.empty()) {
+		m_prefixLen = 16;
+	} else {
+		uint8_t first[16], dst[16];
+		m_records.front().GetDst().GetBytes(first);
+		record.GetDst().GetBytes(dst);
+		uint8_t len = 0;
+		while (len < m_prefixLen && first[len] == dst[len]) {
+			len++;
+		}
+		m_prefixLen = len;
+	}
+	m_records.push_back(record);
+}
+
+uint32_t RplUpdateHeader::GetSerializedSize() const {
+	uint32_t size = GetVarintSize(m_records.size()) + 1 + m_prefixLen;
+	uint32_t seqNo = 0;
+	for (std::vector<RplHeader>::const_iterator r = m_records.begin();
+			r != m_records.end(); ++r) {
+		size += 16 - m_prefixLen + GetVarintSize(r->GetHopCount())
+				+ GetVarintSize(ZigZag(r->GetDstSeqno() - seqNo));
+		seqNo = r->GetDstSeqno();
+	}
+	return size;
+}
+
+void RplUpdateHeader::Serialize(Buffer::Iterator i) const {
+	uint8_t buf[16];
+	uint32_t seqNo = 0;
+
+	WriteVarint(i, m_records.size());
+	i.WriteU8(m_prefixLen);
+	memset(buf, 0, sizeof(buf));
+	if (!m_records.empty()) {
+		m_records.front().GetDst().GetBytes(buf);
+	}
+	i.Write(buf, m_prefixLen);
+	for (std::vector<RplHeader>::const_iterator r = m_records.begin();
+			r != m_records.end(); ++r) {
+		r->GetDst().GetBytes(buf);
+		i.Write(buf + m_prefixLen, 16 - m_prefixLen);
+		WriteVarint(i, r->GetHopCount());
+		WriteVarint(i, ZigZag(r->GetDstSeqno() - seqNo));
+		seqNo = r->GetDstSeqno();
+	}
+}
+
+uint32_t RplUpdateHeader::Deserialize(Buffer::Iterator start) {
+	Buffer::Iterator i = start;
+	uint8_t buf[16];
+	uint32_t count, hopCount, seqDelta;
+	uint32_t seqNo = 0;
+
+	/* A short or corrupt header is rejected as a whole. */
+	m_records.clear();
+	m_prefixLen = 0;
+	if (!ReadVarint(i, count) || i.GetRemainingSize() < 1) {
+		return 0;
+	}
+	uint8_t prefixLen = i.ReadU8();
+	if (prefixLen > 16 || i.GetRemainingSize() < prefixLen) {
+		return 0;
+	}
+	/* a record takes at least its suffix and two one-octet varints */
+	if (count > (i.GetRemainingSize() - prefixLen) / (16 - prefixLen + 2)) {
+		return 0;
+	}
+	i.Read(buf, prefixLen);
+	m_records.reserve(count);
+	for (uint32_t n = 0; n < count; n++) {
+		if (i.GetRemainingSize() < 16u - prefixLen) {
+			m_records.clear();
+			return 0;
+		}
+		i.Read(buf + prefixLen, 16 - prefixLen);
+		if (!ReadVarint(i, hopCount) || !ReadVarint(i, seqDelta)) {
+			m_records.clear();
+			return 0;
+		}
+		seqNo += UnZigZag(seqDelta);
+		m_records.push_back(RplHeader(Ipv6Address(buf), hopCount, seqNo));
+	}
+	m_prefixLen = prefixLen;
+	return i.GetDistanceFrom(start);
+}
+
+void RplUpdateHeader::Print(std::ostream &os) const {
+	os << "Updates: " << m_records.size() << " Prefix: "
+			<< (uint32_t) m_prefixLen * 8;
+	for (std::vector<RplHeader>::const_iterator r = m_records.begin();
+			r != m_records.end(); ++r) {
+		os << " (";
+		r->Print(os);
+		os << ")";
+	}
+}
+
+/*
+ * DIS Packet of RPL
+ */
+
+NS_OBJECT_ENSURE_REGISTERED(DISPacket);
+
+TypeId DISPacket::GetTypeId() {
+	static TypeId tid =
+			TypeId("ns3::DISPacket").SetParent<Icmpv6Header>().AddConstructor<
+					DISPacket>();
+	return tid;
+}
+
+TypeId DISPacket::GetInstanceTypeId() const {
+	return GetTypeId();
+}
+
+DISPacket::DISPacket() {
+	SetType(ICMP6_RPL);
+	SetCode(RPL_CODE_DIS);
+	m_checksum = 0;
+}
+
+DISPacket::~DISPacket() {
+}
+
+void DISPacket::Print(std::ostream& os) const {
+	os << "( type = " << (uint32_t) GetType() << " (DIS) code = "
+			<< (uint32_t) GetCode() << " checksum = "
+			<< (uint32_t) GetChecksum() << ")";
+}
+
+uint32_t DISPacket::GetSerializedSize() const {
+	return 6;
+}
+
+void DISPacket::Serialize(Buffer::Iterator start) const {
+	Buffer::Iterator i = start;
+
+	i.WriteU8(GetType());
+	i.WriteU8(GetCode());
+	i.WriteU16(0);
+
+	i.WriteU8(0); /* flags */
+	i.WriteU8(0); /* reserved */
+
+	if (m_calcChecksum) {
+		i = start;
+		uint16_t checksum = i.CalculateIpChecksum(i.GetSize(), GetChecksum());
+		i = start;
+		i.Next(2);
+		i.WriteU16(checksum);
+	}
+}
+
+uint32_t DISPacket::Deserialize(Buffer::Iterator start) {
+	Buffer::Iterator i = start;
+
+	SetType(i.ReadU8());
+	SetCode(i.ReadU8());
+	m_checksum = i.ReadU16();
+
+	i.ReadU8(); /* flags */
+	i.ReadU8(); /* reserved */
+
+	return i.GetDistanceFrom(start);
+}
+
+/**
+ * RPL control message options
+ */
+
+bool RplOption::Next(Buffer::Iterator &i, uint32_t &left, uint8_t &type,
+		uint8_t &len, Buffer::Iterator &body) {
+	while (left > 0) {
+		type = i.ReadU8();
+		left--;
+		if (type == RPL_OPTION_PAD1) {
+			continue;
+		}
+		if (left == 0) {
+			return false;
+		}
+		len = i.ReadU8();
+		left--;
+		if (len > left) {
+			return false;
+		}
+		body = i;
+		i.Next(len);
+		left -= len;
+		if (type == RPL_OPTION_PADN) {
+			continue;
+		}
+		return true;
+	}
+	return false;
+}
+/*---------------------------------------------------------------------------*/
+void RplOption::WritePad(Buffer::Iterator &i, uint8_t n) {
+	if (n == 0) {
+		return;
+	}
+	if (n == 1) {
+		i.WriteU8(RPL_OPTION_PAD1);
+		return;
+	}
+	i.WriteU8(RPL_OPTION_PADN);
+	i.WriteU8(n - 2);
+	i.WriteU8(0, n - 2);
+}
+/*---------------------------------------------------------------------------*/
+uint32_t RplOption::GetMetricContainerSize(rpl_metric_container_t const & mc) {
+	if (mc.type != RPL_DAG_MC_ETX && mc.type != RPL_DAG_MC_ENERGY) {
+		return 0;
+	}
+	return 2 + 6;
+}
+/*---------------------------------------------------------------------------*/
+void RplOption::WriteMetricContainer(Buffer::Iterator &i,
+		rpl_metric_container_t const & mc) {
+	i.WriteU8(RPL_OPTION_DAG_METRIC_CONTAINER);
+	i.WriteU8(6);
+	i.WriteU8(mc.type);
+	i.WriteU8(mc.flags >> 1);
+	i.WriteU8(((mc.flags & 1) << 7) | (mc.aggr << 4) | mc.prec);
+	i.WriteU8(2);
+	if (mc.type == RPL_DAG_MC_ETX) {
+		i.WriteHtonU16(mc.obj.etx);
+	} else {
+		i.WriteU8(mc.obj.energy.flags);
+		i.WriteU8(mc.obj.energy.energy_est);
+	}
+}
+/*---------------------------------------------------------------------------*/
+bool RplOption::ReadMetricContainer(Buffer::Iterator body, uint8_t len,
+		rpl_metric_container_t &mc) {
+	if (len < 6) {
+		return false;
+	}
+	mc.type = body.ReadU8();
+	uint8_t flags = body.ReadU8();
+	uint8_t temp = body.ReadU8();
+	mc.flags = (flags << 1) | (temp >> 7);
+	mc.aggr = (temp >> 4) & 0x3;
+	mc.prec = temp & 0xf;
+	mc.length = body.ReadU8();
+	if (mc.type == RPL_DAG_MC_ETX) {
+		mc.obj.etx = body.ReadNtohU16();
+	} else if (mc.type == RPL_DAG_MC_ENERGY) {
+		mc.obj.energy.flags = body.ReadU8();
+		mc.obj.energy.energy_est = body.ReadU8();
+	} else {
+		mc.type = RPL_DAG_MC_NONE;
+		return false;
+	}
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t RplOption::GetRouteInfoSize(rpl_prefix_t const & prefix) {
+	return 2 + 6 + (prefix.length + 7) / 8;
+}
+/*---------------------------------------------------------------------------*/
+void RplOption::WriteRouteInfo(Buffer::Iterator &i,
+		rpl_prefix_t const & prefix) {
+	uint8_t buf[16];
+	uint8_t prefixBytes = (prefix.length + 7) / 8;
+	i.WriteU8(RPL_OPTION_ROUTE_INFO);
+	i.WriteU8(6 + prefixBytes);
+	i.WriteU8(prefix.length);
+	i.WriteU8(prefix.flags);
+	i.WriteHtonU32(prefix.lifetime);
+	prefix.prefix.Serialize(buf);
+	i.Write(buf, prefixBytes);
+}
+/*---------------------------------------------------------------------------*/
+bool RplOption::ReadRouteInfo(Buffer::Iterator body, uint8_t len,
+		rpl_prefix_t &prefix) {
+	uint8_t buf[16];
+	if (len < 6) {
+		return false;
+	}
+	uint8_t length = body.ReadU8();
+	uint8_t prefixBytes = (length + 7) / 8;
+	if (length > 128 || len < 6 + prefixBytes) {
+		return false;
+	}
+	prefix.length = length;
+	prefix.flags = body.ReadU8();
+	prefix.lifetime = body.ReadNtohU32();
+	memset(buf, 0, 16);
+	body.Read(buf, prefixBytes);
+	prefix.prefix.Set(buf);
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+void RplOption::WriteDagConf(Buffer::Iterator &i, rpl_dio_t const & dio) {
+	i.WriteU8(RPL_OPTION_DAG_CONF);
+	i.WriteU8(14);
+	i.WriteU8(0); /* No Auth, PCS = 0 */
+	i.WriteU8(dio.dag_intdoubl);
+	i.WriteU8(dio.dag_intmin);
+	i.WriteU8(dio.dag_redund);
+	i.WriteHtonU16(dio.dag_max_rankinc);
+	i.WriteHtonU16(dio.dag_min_hoprankinc);
+	i.WriteHtonU16(dio.ocp);
+	i.WriteU8(0); /* reserved */
+	i.WriteU8(dio.default_lifetime);
+	i.WriteHtonU16(dio.lifetime_unit);
+}
+/*---------------------------------------------------------------------------*/
+bool RplOption::ReadDagConf(Buffer::Iterator body, uint8_t len,
+		rpl_dio_t &dio) {
+	if (len < 14) {
+		return false;
+	}
+	body.ReadU8(); /* No Auth, PCS */
+	dio.dag_intdoubl = body.ReadU8();
+	dio.dag_intmin = body.ReadU8();
+	dio.dag_redund = body.ReadU8();
+	dio.dag_max_rankinc = body.ReadNtohU16();
+	dio.dag_min_hoprankinc = body.ReadNtohU16();
+	dio.ocp = body.ReadNtohU16();
+	body.ReadU8(); /* reserved */
+	dio.default_lifetime = body.ReadU8();
+	dio.lifetime_unit = body.ReadNtohU16();
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+void RplOption::WritePrefixInfo(Buffer::Iterator &i,
+		rpl_prefix_t const & prefix) {
+	uint8_t buf[16];
+	i.WriteU8(RPL_OPTION_PREFIX_INFO);
+	i.WriteU8(30);
+	i.WriteU8(prefix.length);
+	i.WriteU8(prefix.flags);
+	i.WriteHtonU32(prefix.lifetime); /* valid lifetime */
+	i.WriteHtonU32(prefix.lifetime); /* preferred lifetime */
+	i.WriteHtonU32(0); /* reserved */
+	prefix.prefix.Serialize(buf);
+	i.Write(buf, 16);
+}
+/*---------------------------------------------------------------------------*/
+bool RplOption::ReadPrefixInfo(Buffer::Iterator body, uint8_t len,
+		rpl_prefix_t &prefix) {
+	uint8_t buf[16];
+	if (len < 30) {
+		return false;
+	}
+	prefix.length = body.ReadU8();
+	prefix.flags = body.ReadU8();
+	prefix.lifetime = body.ReadNtohU32();
+	body.ReadNtohU32(); /* preferred lifetime */
+	body.ReadNtohU32(); /* reserved */
+	body.Read(buf, 16);
+	prefix.prefix.Set(buf);
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t RplOption::GetTargetSize(rpl_dao_target_t const & target) {
+	return 2 + 2 + (target.prefix_len + 7) / 8;
+}
+/*---------------------------------------------------------------------------*/
+void RplOption::WriteTarget(Buffer::Iterator &i,
+		rpl_dao_target_t const & target) {
+	uint8_t buf[16];
+	uint8_t prefixBytes = (target.prefix_len + 7) / 8;
+	i.WriteU8(RPL_OPTION_TARGET);
+	i.WriteU8(2 + prefixBytes);
+	i.WriteU8(0); /* flags */
+	i.WriteU8(target.prefix_len);
+	target.prefix.Serialize(buf);
+	i.Write(buf, prefixBytes);
+}
+/*---------------------------------------------------------------------------*/
+bool RplOption::ReadTarget(Buffer::Iterator body, uint8_t len,
+		rpl_dao_target_t &target) {
+	uint8_t buf[16];
+	if (len < 2) {
+		return false;
+	}
+	body.ReadU8(); /* flags */
+	uint8_t prefixLen = body.ReadU8();
+	uint8_t prefixBytes = (prefixLen + 7) / 8;
+	if (prefixLen > 128 || len < 2 + prefixBytes) {
+		return false;
+	}
+	target.prefix_len = prefixLen;
+	memset(buf, 0, 16);
+	body.Read(buf, prefixBytes);
+	target.prefix.Set(buf);
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t RplOption::GetTransitSize(rpl_dao_target_t const & target) {
+	return 2 + 4 + (target.parent != Ipv6Address::GetAny() ? 16 : 0);
+}
+/*---------------------------------------------------------------------------*/
+void RplOption::WriteTransit(Buffer::Iterator &i,
+		rpl_dao_target_t const & target) {
+	uint8_t buf[16];
+	bool withParent = target.parent != Ipv6Address::GetAny();
+	i.WriteU8(RPL_OPTION_TRANSIT);
+	i.WriteU8(withParent ? 20 : 4);
+	i.WriteU8(0); /* flags */
+	i.WriteU8(0); /* path control */
+	i.WriteU8(target.path_sequence);
+	i.WriteU8(target.lifetime);
+	if (withParent) {
+		target.parent.Serialize(buf);
+		i.Write(buf, 16);
+	}
+}
+/*---------------------------------------------------------------------------*/
+bool RplOption::ReadTransit(Buffer::Iterator body, uint8_t len,
+		rpl_dao_target_t &target) {
+	uint8_t buf[16];
+	if (len < 4) {
+		return false;
+	}
+	body.ReadU8(); /* flags */
+	body.ReadU8(); /* path control */
+	target.path_sequence = body.ReadU8();
+	target.lifetime = body.ReadU8();
+	target.parent = Ipv6Address::GetAny();
+	if (len >= 20) {
+		/* parent address, non-storing mode */
+		body.Read(buf, 16);
+		target.parent.Set(buf);
+	}
+	return true;
+}
+
 /**
  * DIO Packet of RPL
  */
@@ -104,247 +605,808 @@ TypeId DIOPacket::GetInstanceTypeId() const {
 
 DIOPacket::DIOPacket() {
 
-	SetType(155);
-	SetCode(1);
-	SetReserved(0);
-	SetFlagR(0);
-	SetFlagS(0);
-	SetFlagO(0);
+	SetType(ICMP6_RPL);
+	SetCode(RPL_CODE_DIO);
 	m_checksum = 0;
+	m_dio = rpl_dio_t();
 }
 
 DIOPacket::~DIOPacket() {
 
 }
 
-uint32_t DIOPacket::GetReserved() const {
-	return m_reserved;
+uint8_t DIOPacket::GetInstanceID() const {
+	return m_dio.instance_id;
+}
+
+void DIOPacket::SetInstanceID(uint8_t IntanceID) {
+	m_dio.instance_id = IntanceID;
+}
+
+uint8_t DIOPacket::GetDagVersion() const {
+	return m_dio.version;
+}
+
+void DIOPacket::SetDagVersion(uint8_t DagVersion) {
+	m_dio.version = DagVersion;
 }
 
-void DIOPacket::SetReserved(uint32_t reserved) {
-	m_reserved = reserved;
+uint16_t DIOPacket::GetRank() const {
+	return m_dio.rank;
 }
 
-Ipv6Address DIOPacket::GetIpv6Target() const {
-	return m_target;
+void DIOPacket::SetRank(uint16_t Rank) {
+	m_dio.rank = Rank;
 }
 
-bool DIOPacket::GetFlagR() const {
-	return m_flagR;
+uint8_t DIOPacket::GetGrounded() const {
+	return m_dio.grounded;
 }
 
-void DIOPacket::SetFlagR(bool r) {
-	m_flagR = r;
+void DIOPacket::SetGrounded(uint8_t Grounded) {
+	m_dio.grounded = Grounded;
 }
 
-bool DIOPacket::GetFlagS() const {
-	return m_flagS;
+uint8_t DIOPacket::GetMOP() const {
+	return m_dio.mop;
 }
 
-void DIOPacket::SetFlagS(bool s) {
-	m_flagS = s;
+void DIOPacket::SetMOP(uint8_t MOP) {
+	m_dio.mop = MOP;
 }
 
-bool DIOPacket::GetFlagO() const {
-	return m_flagO;
+uint8_t DIOPacket::GetPreference() const {
+	return m_dio.preference;
 }
 
-void DIOPacket::SetFlagO(bool o) {
+void DIOPacket::SetPreference(uint8_t Preference) {
+	m_dio.preference = Preference;
+}
+
+Ipv6Address DIOPacket::GetDagID() const {
+	return m_dio.dag_id;
+}
 
-	m_flagO = o;
+void DIOPacket::SetDagID(Ipv6Address DagID) {
+	m_dio.dag_id = DagID;
 }
 
-void DIOPacket::SetIpv6Target(Ipv6Address target) {
+rpl_dio_t DIOPacket::GetDio() const {
+	return m_dio;
+}
 
-	m_target = target;
+void DIOPacket::SetDio(rpl_dio_t const & dio) {
+	m_dio = dio;
 }
 
 void DIOPacket::Print(std::ostream& os) const {
 
-	os << "( type = " << (uint32_t) GetType() << " (NA) code = "
+	os << "( type = " << (uint32_t) GetType() << " (DIO) code = "
 			<< (uint32_t) GetCode() << " checksum = "
-			<< (uint32_t) GetChecksum() << ")";
+			<< (uint32_t) GetChecksum() << " instance = "
+			<< (uint32_t) m_dio.instance_id << " rank = " << m_dio.rank
+			<< ")";
 }
 
 uint32_t DIOPacket::GetSerializedSize() const {
 
-	return 60;
+	/* header, DIO base object and DAG configuration option */
+	uint32_t size = 4 + 24 + RplOption::DAG_CONF_SIZE;
+	size += RplOption::GetMetricContainerSize(m_dio.mc);
+	if (m_dio.destination_prefix.length > 0) {
+		size += RplOption::GetRouteInfoSize(m_dio.destination_prefix);
+	}
+	if (m_dio.prefix_info.length > 0) {
+		size += RplOption::PREFIX_INFO_SIZE;
+	}
+	return size;
 }
 
 void DIOPacket::Serialize(Buffer::Iterator start) const {
 
-	uint8_t buff_target[16];
-	uint8_t Dag_ID[16];
-	uint16_t checksum = 0;
+	uint8_t buf[16];
 	Buffer::Iterator i = start;
-	uint32_t reserved = m_reserved;
-	std::cout << "RPL: Adding DIO header !!!" << std::endl;
 
 	i.WriteU8(GetType());
 	i.WriteU8(GetCode());
 	i.WriteU16(0);
 
-	if (m_flagR) {
-		reserved |= (uint32_t) (1 << 31);
-	}
+	/* DAG Information Object */
+	i.WriteU8(m_dio.instance_id);
+	i.WriteU8(m_dio.version);
+	i.WriteHtonU16(m_dio.rank);
 
-	if (m_flagS) {
-		reserved |= (uint32_t) (1 << 30);
+	/*|G|0| MOP | Prf | */
+	i.WriteU8((m_dio.grounded ? 0x80 : 0) | ((m_dio.mop & 0x07) << 3)
+			| (m_dio.preference & 0x07));
+	i.WriteU8(m_dio.dtsn);
+	i.WriteU8(0); /* flags */
+	i.WriteU8(0); /* reserved */
+
+	m_dio.dag_id.Serialize(buf);
+	i.Write(buf, 16);
+
+	/* Options, only those the DAG has */
+	if (RplOption::GetMetricContainerSize(m_dio.mc) > 0) {
+		RplOption::WriteMetricContainer(i, m_dio.mc);
+	}
+	if (m_dio.destination_prefix.length > 0) {
+		RplOption::WriteRouteInfo(i, m_dio.destination_prefix);
+	}
+	/* Always add a DAG configuration option. */
+	RplOption::WriteDagConf(i, m_dio);
+	if (m_dio.prefix_info.length > 0) {
+		RplOption::WritePrefixInfo(i, m_dio.prefix_info);
 	}
 
-	if (m_flagO) {
-		reserved |= (uint32_t) (1 << 29);
+	if (m_calcChecksum) {
+		i = start;
+		uint16_t checksum = i.CalculateIpChecksum(i.GetSize(), GetChecksum());
+		i = start;
+		i.Next(2);
+		i.WriteU16(checksum);
 	}
+}
 
-	//	i.WriteHtonU32(reserved);
-	m_target.Serialize(buff_target);
-	i.Write(buff_target, 16);
+uint32_t DIOPacket::Deserialize(Buffer::Iterator start) {
 
-	/*
-	 * Start of DIO message
-	 * */
-	std::cout << "RPL: Before DIO header !!!" << std::endl;
-	rpl_dag_t *dag = this->m_dag;
-	rpl_instance_t *instance = this->m_instance;
+	uint8_t buf[16];
+	Buffer::Iterator i = start;
+	uint32_t left = i.GetRemainingSize();
 
-	std::cout << "RPL: pos = i." << std::endl;
+	/* A DIO shorter than its base object is rejected. */
+	m_dio = rpl_dio_t();
+	if (left < 4 + 24) {
+		return 0;
+	}
 
-	Buffer::Iterator pos = i;
-	dag = instance->current_dag;
+	SetType(i.ReadU8());
+	SetCode(i.ReadU8());
+	m_checksum = i.ReadU16();
 
 	/* DAG Information Object */
-	pos.WriteU8(instance->instance_id);
-	pos.WriteU8(dag->version);
-
-	pos.WriteU16(dag->rank);
+	m_dio.instance_id = i.ReadU8();
+	m_dio.version = i.ReadU8();
+	m_dio.rank = i.ReadNtohU16();
 
 	/*|G|0| MOP | Prf | */
-	uint8_t temp = 0;
-	temp |= 0x80;
-	temp |= instance->mop << 3;
-	temp |= dag->preference & 0x70;
-	pos.WriteU8(temp);
-
-	pos.WriteU8(instance->dtsn_out);
-
-	/* always request new DAO to refresh route */
-	RPL_LOLLIPOP_INCREMENT(instance->dtsn_out);
-
-	/* reserved 2 bytes */
-	pos.WriteU8(0); /* flags */
-	pos.WriteU8(0); /* reserved */
-
-	dag->dag_id.Serialize(Dag_ID);
-	pos.Write(Dag_ID, 16);
-	std::cout << "RPL: Before DIO option header." << std::endl;
-
-//	if (instance->mc.type != RPL_DAG_MC_NONE) {
-//		instance->of->update_metric_container(instance);
-//
-//		pos.WriteU8(2);
-//		pos.WriteU8(6);
-//		pos.WriteU8(instance->mc.type);
-//		pos.WriteU8(instance->mc.flags >> 1);
-//		pos.WriteU8(
-//				((instance->mc.flags & 1) << 7)
-//						| ((instance->mc.aggr << 4) | instance->mc.prec));
-//
-//		if (instance->mc.type == RPL_DAG_MC_ETX) {
-//			pos.WriteU8(2);
-//			pos.WriteU16(instance->mc.obj.etx);
-//		} else if (instance->mc.type == RPL_DAG_MC_ENERGY) {
-//			pos.WriteU8(2);
-//			pos.WriteU8(instance->mc.obj.energy.flags);
-//			pos.WriteU8(instance->mc.obj.energy.energy_est);
-//		} else {
-//			std::cout
-//					<< "RPL: Unable to send DIO because of unhandled DAG MC type %u\n"
-//					<< (unsigned) instance->mc.type << std::endl;
-//			return;
-//		}
-//	}
+	uint8_t temp = i.ReadU8();
+	m_dio.grounded = (temp & 0x80) >> 7;
+	m_dio.mop = (temp >> 3) & 0x07;
+	m_dio.preference = temp & 0x07;
 
-	/* Always add a DAG configuration option. */
-	std::cout << "RPL: Before DAG configuration option." << std::endl;
-	pos.WriteU8(0x04);
-	pos.WriteU8(0x0e);
-	pos.WriteU8(0); /* No Auth, PCS = 0 */
-	pos.WriteU8(instance->dio_intdoubl);
-	pos.WriteU8(instance->dio_intmin);
-	pos.WriteU8(instance->dio_redundancy);
-	pos.WriteU16(instance->max_rankinc);
-	pos.WriteU16(instance->min_hoprankinc);
-
-	/* OCP is in the DAG_CONF option */
-//	pos.WriteU16(instance->of->ocp);
-//	pos.WriteU8(0); /* reserved */
-//	pos.WriteU8(instance->default_lifetime);
-//	pos.WriteU16(instance->lifetime_unit);
-
-	/* Check if we have a prefix to send also. */
-	std::cout << "RPL: Before Check if a prefix to be sent." << std::endl;
-	if (dag->prefix_info.length > 0) {
-		pos.WriteU8(8);
-		pos.WriteU8(30); /* always 30 bytes + 2 long */
-		pos.WriteU8(dag->prefix_info.length);
-		pos.WriteU8(dag->prefix_info.flags);
-		pos.WriteHtonU32(dag->prefix_info.lifetime);
-		pos.WriteHtonU32(dag->prefix_info.lifetime);
-		pos.WriteHtonU32(0); // Not for sure
-
-		dag->prefix_info.prefix.Serialize(Dag_ID);
-		pos.Write(Dag_ID, 16);
-
-		std::cout << "RPL: Sending prefix info in DIO for " << std::endl;
-		std::cout << "&dag->prefix_info.prefix" << std::endl;
-	} else {
-		std::cout << "RPL: No prefix to announce (len = "
-				<< dag->prefix_info.length << " )" << std::endl;
+	m_dio.dtsn = i.ReadU8();
+	i.ReadU8(); /* flags */
+	i.ReadU8(); /* reserved */
+
+	i.Read(buf, 16);
+	m_dio.dag_id.Set(buf);
+	left -= 4 + 24;
+
+	/* Default values can be overridden by the DAG configuration option. */
+	m_dio.dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+	m_dio.dag_intmin = RPL_DIO_INTERVAL_MIN;
+	m_dio.dag_redund = RPL_DIO_REDUNDANCY;
+	m_dio.dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+	m_dio.dag_max_rankinc = RPL_MAX_RANKINC;
+	m_dio.default_lifetime = RPL_DEFAULT_LIFETIME;
+	m_dio.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+
+	/* Options */
+	uint8_t type;
+	uint8_t len;
+	Buffer::Iterator body;
+	while (RplOption::Next(i, left, type, len, body)) {
+		switch (type) {
+		case RPL_OPTION_DAG_METRIC_CONTAINER:
+			RplOption::ReadMetricContainer(body, len, m_dio.mc);
+			break;
+		case RPL_OPTION_ROUTE_INFO:
+			RplOption::ReadRouteInfo(body, len, m_dio.destination_prefix);
+			break;
+		case RPL_OPTION_DAG_CONF:
+			RplOption::ReadDagConf(body, len, m_dio);
+			break;
+		case RPL_OPTION_PREFIX_INFO:
+			RplOption::ReadPrefixInfo(body, len, m_dio.prefix_info);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return i.GetDistanceFrom(start);
+}
+
+/*
+ * DAO Packet of RPL
+ */
+
+NS_OBJECT_ENSURE_REGISTERED(DAOPacket);
+
+TypeId DAOPacket::GetTypeId() {
+	static TypeId tid =
+			TypeId("ns3::DAOPacket").SetParent<Icmpv6Header>().AddConstructor<
+					DAOPacket>();
+	return tid;
+}
+
+TypeId DAOPacket::GetInstanceTypeId() const {
+	return GetTypeId();
+}
+
+DAOPacket::DAOPacket() {
+	SetType(ICMP6_RPL);
+	SetCode(RPL_CODE_DAO);
+	m_checksum = 0;
+	m_instanceID = 0;
+	m_flagK = false;
+	m_flagD = false;
+	m_sequence = 0;
+}
+
+DAOPacket::~DAOPacket() {
+}
+
+uint8_t DAOPacket::GetInstanceID() const {
+	return m_instanceID;
+}
+
+void DAOPacket::SetInstanceID(uint8_t instanceID) {
+	m_instanceID = instanceID;
+}
+
+bool DAOPacket::GetFlagK() const {
+	return m_flagK;
+}
+
+void DAOPacket::SetFlagK(bool k) {
+	m_flagK = k;
+}
+
+uint8_t DAOPacket::GetSequence() const {
+	return m_sequence;
+}
+
+void DAOPacket::SetSequence(uint8_t sequence) {
+	m_sequence = sequence;
+}
+
+void DAOPacket::SetDagID(Ipv6Address dagID) {
+	m_dagID = dagID;
+	m_flagD = true;
+}
+
+Ipv6Address DAOPacket::GetDagID() const {
+	return m_dagID;
+}
+
+bool DAOPacket::GetFlagD() const {
+	return m_flagD;
+}
+
+void DAOPacket::AddTarget(rpl_dao_target_t const & target) {
+	m_targets.push_back(target);
+}
+
+std::vector<rpl_dao_target_t> const & DAOPacket::GetTargets() const {
+	return m_targets;
+}
+
+void DAOPacket::Print(std::ostream& os) const {
+	os << "( type = " << (uint32_t) GetType() << " (DAO) code = "
+			<< (uint32_t) GetCode() << " checksum = "
+			<< (uint32_t) GetChecksum() << " instance = "
+			<< (uint32_t) m_instanceID << " sequence = "
+			<< (uint32_t) m_sequence << " targets = " << m_targets.size()
+			<< ")";
+}
+
+uint32_t DAOPacket::GetSerializedSize() const {
+	uint32_t size = 8 + (m_flagD ? 16 : 0);
+	for (std::vector<rpl_dao_target_t>::const_iterator t = m_targets.begin();
+			t != m_targets.end(); ++t) {
+		size += GetTargetSize(*t);
 	}
+	return size;
+}
 
-	/*
-	 * End of DIO message
-	 * */
+uint32_t DAOPacket::GetTargetSize(rpl_dao_target_t const & target) {
+	/* Target option with the prefix bits only, then a Transit option */
+	return RplOption::GetTargetSize(target) + RplOption::GetTransitSize(target);
+}
+
+void DAOPacket::Serialize(Buffer::Iterator start) const {
+	uint8_t buf[16];
+	Buffer::Iterator i = start;
+
+	i.WriteU8(GetType());
+	i.WriteU8(GetCode());
+	i.WriteU16(0);
+
+	/* DAO base object */
+	i.WriteU8(m_instanceID);
+	i.WriteU8((m_flagK ? RPL_DAO_K_FLAG : 0) | (m_flagD ? RPL_DAO_D_FLAG : 0));
+	i.WriteU8(0); /* reserved */
+	i.WriteU8(m_sequence);
+	if (m_flagD) {
+		m_dagID.Serialize(buf);
+		i.Write(buf, 16);
+	}
+
+	for (std::vector<rpl_dao_target_t>::const_iterator t = m_targets.begin();
+			t != m_targets.end(); ++t) {
+		RplOption::WriteTarget(i, *t);
+		RplOption::WriteTransit(i, *t);
+	}
 
 	if (m_calcChecksum) {
 		i = start;
-		checksum = i.CalculateIpChecksum(i.GetSize(), GetChecksum());
+		uint16_t checksum = i.CalculateIpChecksum(i.GetSize(), GetChecksum());
 		i = start;
 		i.Next(2);
 		i.WriteU16(checksum);
 	}
 }
 
-uint32_t DIOPacket::Deserialize(Buffer::Iterator start) {
-
+uint32_t DAOPacket::Deserialize(Buffer::Iterator start) {
 	uint8_t buf[16];
 	Buffer::Iterator i = start;
+	uint32_t left = i.GetRemainingSize();
+
+	/* A DAO shorter than its base object is rejected. */
+	m_targets.clear();
+	if (left < 4 + 4) {
+		return 0;
+	}
 
 	SetType(i.ReadU8());
 	SetCode(i.ReadU8());
 	m_checksum = i.ReadU16();
-	m_reserved = i.ReadNtohU32();
 
-	m_flagR = false;
-	m_flagS = false;
-	m_flagO = false;
+	m_instanceID = i.ReadU8();
+	uint8_t flags = i.ReadU8();
+	m_flagK = (flags & RPL_DAO_K_FLAG) != 0;
+	m_flagD = (flags & RPL_DAO_D_FLAG) != 0;
+	i.ReadU8(); /* reserved */
+	m_sequence = i.ReadU8();
+	if (m_flagD && left < 4 + 4 + 16) {
+		return 0;
+	}
+	if (m_flagD) {
+		i.Read(buf, 16);
+		m_dagID.Set(buf);
+	}
+	left -= i.GetDistanceFrom(start);
+
+	/* A Transit option applies to all the Target options preceding it. */
+	size_t pending = 0;
+	uint8_t type;
+	uint8_t len;
+	Buffer::Iterator body;
+	while (RplOption::Next(i, left, type, len, body)) {
+		switch (type) {
+		case RPL_OPTION_TARGET: {
+			rpl_dao_target_t target = rpl_dao_target_t();
+			/* a malformed Target is skipped, the next Transit still
+			 applies to the valid ones */
+			if (!RplOption::ReadTarget(body, len, target)) {
+				break;
+			}
+			m_targets.push_back(target);
+			break;
+		}
+		case RPL_OPTION_TRANSIT: {
+			rpl_dao_target_t transit = rpl_dao_target_t();
+			if (!RplOption::ReadTransit(body, len, transit)) {
+				break;
+			}
+			for (; pending < m_targets.size(); ++pending) {
+				m_targets[pending].path_sequence = transit.path_sequence;
+				m_targets[pending].lifetime = transit.lifetime;
+				m_targets[pending].parent = transit.parent;
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	/* Targets without Transit information are invalid. */
+	m_targets.resize(pending);
+
+	return i.GetDistanceFrom(start);
+}
 
-	if (m_reserved & (1 << 31)) {
-		m_flagR = true;
+/*
+ * DAO-ACK Packet of RPL
+ */
+
+NS_OBJECT_ENSURE_REGISTERED(DAOAckPacket);
+
+TypeId DAOAckPacket::GetTypeId() {
+	static TypeId tid =
+			TypeId("ns3::DAOAckPacket").SetParent<Icmpv6Header>().AddConstructor<
+					DAOAckPacket>();
+	return tid;
+}
+
+TypeId DAOAckPacket::GetInstanceTypeId() const {
+	return GetTypeId();
+}
+
+DAOAckPacket::DAOAckPacket() {
+	SetType(ICMP6_RPL);
+	SetCode(RPL_CODE_DAO_ACK);
+	m_checksum = 0;
+	m_instanceID = 0;
+	m_sequence = 0;
+	m_status = 0;
+}
+
+DAOAckPacket::~DAOAckPacket() {
+}
+
+uint8_t DAOAckPacket::GetInstanceID() const {
+	return m_instanceID;
+}
+
+void DAOAckPacket::SetInstanceID(uint8_t instanceID) {
+	m_instanceID = instanceID;
+}
+
+uint8_t DAOAckPacket::GetSequence() const {
+	return m_sequence;
+}
+
+void DAOAckPacket::SetSequence(uint8_t sequence) {
+	m_sequence = sequence;
+}
+
+uint8_t DAOAckPacket::GetStatus() const {
+	return m_status;
+}
+
+void DAOAckPacket::SetStatus(uint8_t status) {
+	m_status = status;
+}
+
+void DAOAckPacket::Print(std::ostream& os) const {
+	os << "( type = " << (uint32_t) GetType() << " (DAO-ACK) code = "
+			<< (uint32_t) GetCode() << " checksum = "
+			<< (uint32_t) GetChecksum() << " sequence = "
+			<< (uint32_t) m_sequence << " status = " << (uint32_t) m_status
+			<< ")";
+}
+
+uint32_t DAOAckPacket::GetSerializedSize() const {
+	return 8;
+}
+
+void DAOAckPacket::Serialize(Buffer::Iterator start) const {
+	Buffer::Iterator i = start;
+
+	i.WriteU8(GetType());
+	i.WriteU8(GetCode());
+	i.WriteU16(0);
+
+	i.WriteU8(m_instanceID);
+	i.WriteU8(0); /* D flag and reserved */
+	i.WriteU8(m_sequence);
+	i.WriteU8(m_status);
+
+	if (m_calcChecksum) {
+		i = start;
+		uint16_t checksum = i.CalculateIpChecksum(i.GetSize(), GetChecksum());
+		i = start;
+		i.Next(2);
+		i.WriteU16(checksum);
 	}
+}
+
+uint32_t DAOAckPacket::Deserialize(Buffer::Iterator start) {
+	Buffer::Iterator i = start;
+
+	SetType(i.ReadU8());
+	SetCode(i.ReadU8());
+	m_checksum = i.ReadU16();
 
-	if (m_reserved & (1 << 30)) {
-		m_flagS = true;
+	m_instanceID = i.ReadU8();
+	i.ReadU8(); /* D flag and reserved */
+	m_sequence = i.ReadU8();
+	m_status = i.ReadU8();
+
+	return i.GetDistanceFrom(start);
+}
+
+/*
+ * Source Routing Header of RPL
+ */
+
+NS_OBJECT_ENSURE_REGISTERED(SourceRoutingHeader);
+
+TypeId SourceRoutingHeader::GetTypeId() {
+	static TypeId tid =
+			TypeId("ns3::rpl::SourceRoutingHeader").SetParent<Header>().AddConstructor<
+					SourceRoutingHeader>();
+	return tid;
+}
+
+TypeId SourceRoutingHeader::GetInstanceTypeId() const {
+	return GetTypeId();
+}
+
+SourceRoutingHeader::SourceRoutingHeader() {
+	m_nextHeader = 0;
+	m_segmentsLeft = 0;
+	m_cmprI = 0;
+	m_cmprE = 0;
+}
+
+SourceRoutingHeader::~SourceRoutingHeader() {
+}
+
+uint8_t SourceRoutingHeader::GetNextHeader() const {
+	return m_nextHeader;
+}
+
+void SourceRoutingHeader::SetNextHeader(uint8_t nextHeader) {
+	m_nextHeader = nextHeader;
+}
+
+uint8_t SourceRoutingHeader::GetSegmentsLeft() const {
+	return m_segmentsLeft;
+}
+
+void SourceRoutingHeader::SetSegmentsLeft(uint8_t segmentsLeft) {
+	m_segmentsLeft = segmentsLeft;
+}
+
+/* Number of leading octets a and b share, at most 15 as CmprI and CmprE
+ are 4 bit wide. */
+static uint8_t srh_common_octets(Ipv6Address a, Ipv6Address b) {
+	uint8_t x[16], y[16];
+	uint8_t n = 0;
+
+	a.GetBytes(x);
+	b.GetBytes(y);
+	while (n < 15 && x[n] == y[n]) {
+		n++;
 	}
+	return n;
+}
 
-	if (m_reserved & (1 << 29)) {
-		m_flagO = true;
+void SourceRoutingHeader::SetRoute(Ipv6Address dst,
+		std::vector<Ipv6Address> const & hops) {
+	NS_ASSERT(!hops.empty() && hops.size() <= 255);
+	size_t n = hops.size();
+
+	/* Addresses[1..n-1] replace the destination one after the other and keep
+	 its first CmprI octets; Address[n] replaces Address[n-1]. */
+	m_cmprI = n > 1 ? 15 : 0;
+	for (size_t k = 0; k + 1 < n; ++k) {
+		uint8_t common = srh_common_octets(dst, hops[k]);
+		if (common < m_cmprI) {
+			m_cmprI = common;
+		}
+	}
+	m_cmprE = srh_common_octets(n > 1 ? hops[n - 2] : dst, hops[n - 1]);
+
+	m_addresses.clear();
+	m_addresses.reserve(n);
+	for (size_t k = 0; k < n; ++k) {
+		uint8_t buf[16];
+		uint8_t cmpr = k + 1 < n ? m_cmprI : m_cmprE;
+		hops[k].GetBytes(buf);
+		memset(buf, 0, cmpr);
+		m_addresses.push_back(Ipv6Address(buf));
 	}
+	m_segmentsLeft = n;
+}
 
-	i.Read(buf, 16);
-	m_target.Set(buf);
+uint32_t SourceRoutingHeader::GetNAddresses() const {
+	return m_addresses.size();
+}
+
+Ipv6Address SourceRoutingHeader::GetAddress(uint32_t index,
+		Ipv6Address dst) const {
+	NS_ASSERT(index >= 1 && index <= m_addresses.size());
+	uint8_t buf[16], prefix[16];
+	uint8_t cmpr = m_cmprI;
+
+	if (index == m_addresses.size()) {
+		/* Address[n] shares its CmprE octets with Address[n-1] */
+		cmpr = m_cmprE;
+		if (index > 1) {
+			dst = GetAddress(index - 1, dst);
+		}
+	}
+	m_addresses[index - 1].GetBytes(buf);
+	dst.GetBytes(prefix);
+	memcpy(buf, prefix, cmpr);
+	return Ipv6Address(buf);
+}
+
+void SourceRoutingHeader::Print(std::ostream& os) const {
+	os << "( next header = " << (uint32_t) m_nextHeader
+			<< " segments left = " << (uint32_t) m_segmentsLeft
+			<< " cmprI = " << (uint32_t) m_cmprI << " cmprE = "
+			<< (uint32_t) m_cmprE << " addresses = " << m_addresses.size()
+			<< ")";
+}
+
+uint32_t SourceRoutingHeader::GetSerializedSize() const {
+	uint32_t size = 0;
+	if (!m_addresses.empty()) {
+		size = (m_addresses.size() - 1) * (16 - m_cmprI) + (16 - m_cmprE);
+	}
+	/* padded to a multiple of 8 octets */
+	return 8 + (size + 7) / 8 * 8;
+}
+
+void SourceRoutingHeader::Serialize(Buffer::Iterator start) const {
+	Buffer::Iterator i = start;
+	uint32_t size = GetSerializedSize();
+	uint32_t pad = size - 8;
+	uint8_t buf[16];
+
+	for (size_t k = 0; k < m_addresses.size(); ++k) {
+		pad -= 16 - (k + 1 < m_addresses.size() ? m_cmprI : m_cmprE);
+	}
+
+	i.WriteU8(m_nextHeader);
+	i.WriteU8((size - 8) / 8);
+	i.WriteU8(RPL_SRH_ROUTING_TYPE);
+	i.WriteU8(m_segmentsLeft);
+	i.WriteU8((m_cmprI << 4) | m_cmprE);
+	i.WriteU8(pad << 4);
+	i.WriteU16(0); /* reserved */
+
+	for (size_t k = 0; k < m_addresses.size(); ++k) {
+		uint8_t cmpr = k + 1 < m_addresses.size() ? m_cmprI : m_cmprE;
+		m_addresses[k].GetBytes(buf);
+		i.Write(buf + cmpr, 16 - cmpr);
+	}
+	if (pad > 0) {
+		i.WriteU8(0, pad);
+	}
+}
+
+uint32_t SourceRoutingHeader::Deserialize(Buffer::Iterator start) {
+	Buffer::Iterator i = start;
+	uint8_t buf[16];
+
+	/* A header shorter than its Hdr Ext Len is rejected. */
+	m_addresses.clear();
+	if (i.GetRemainingSize() < 8) {
+		return 0;
+	}
+	m_nextHeader = i.ReadU8();
+	uint32_t length = i.ReadU8() * 8;
+	if (i.GetRemainingSize() < 6 + length) {
+		return 0;
+	}
+	i.ReadU8(); /* routing type */
+	m_segmentsLeft = i.ReadU8();
+	uint8_t cmpr = i.ReadU8();
+	m_cmprI = cmpr >> 4;
+	m_cmprE = cmpr & 0x0f;
+	uint8_t pad = i.ReadU8() >> 4;
+	i.ReadU16(); /* reserved */
+
+	/* n = ((Hdr Ext Len * 8 - Pad - (16 - CmprE)) / (16 - CmprI)) + 1 */
+	uint32_t consumed = 0;
+	if (length >= pad + 16u - m_cmprE) {
+		uint32_t n = (length - pad - (16 - m_cmprE)) / (16 - m_cmprI) + 1;
+		for (uint32_t k = 0; k < n; ++k) {
+			uint8_t c = k + 1 < n ? m_cmprI : m_cmprE;
+			memset(buf, 0, 16);
+			i.Read(buf + c, 16 - c);
+			consumed += 16 - c;
+			m_addresses.push_back(Ipv6Address(buf));
+		}
+	}
+	i.Next(length - consumed);
+
+	return i.GetDistanceFrom(start);
+}
+
+/*
+ * RPL option of the data packets
+ */
+
+NS_OBJECT_ENSURE_REGISTERED(RplHopByHopHeader);
+
+TypeId RplHopByHopHeader::GetTypeId() {
+	static TypeId tid =
+			TypeId("ns3::rpl::RplHopByHopHeader").SetParent<Header>().AddConstructor<
+					RplHopByHopHeader>();
+	return tid;
+}
+
+TypeId RplHopByHopHeader::GetInstanceTypeId() const {
+	return GetTypeId();
+}
+
+RplHopByHopHeader::RplHopByHopHeader() {
+	m_nextHeader = 0;
+	m_flags = 0;
+	m_instanceID = 0;
+	m_senderRank = 0;
+}
+
+RplHopByHopHeader::~RplHopByHopHeader() {
+}
+
+uint8_t RplHopByHopHeader::GetNextHeader() const {
+	return m_nextHeader;
+}
+
+void RplHopByHopHeader::SetNextHeader(uint8_t nextHeader) {
+	m_nextHeader = nextHeader;
+}
+
+uint8_t RplHopByHopHeader::GetFlags() const {
+	return m_flags;
+}
+
+void RplHopByHopHeader::SetFlags(uint8_t flags) {
+	m_flags = flags;
+}
+
+uint8_t RplHopByHopHeader::GetInstanceID() const {
+	return m_instanceID;
+}
+
+void RplHopByHopHeader::SetInstanceID(uint8_t instanceID) {
+	m_instanceID = instanceID;
+}
+
+uint16_t RplHopByHopHeader::GetSenderRank() const {
+	return m_senderRank;
+}
+
+void RplHopByHopHeader::SetSenderRank(uint16_t senderRank) {
+	m_senderRank = senderRank;
+}
+
+void RplHopByHopHeader::Print(std::ostream& os) const {
+	os << "( next header = " << (uint32_t) m_nextHeader << " down = "
+			<< ((m_flags & RPL_HDR_OPT_DOWN) != 0) << " rank error = "
+			<< ((m_flags & RPL_HDR_OPT_RANK_ERR) != 0)
+			<< " forwarding error = " << ((m_flags & RPL_HDR_OPT_FWD_ERR) != 0)
+			<< " instance = " << (uint32_t) m_instanceID << " sender rank = "
+			<< m_senderRank << ")";
+}
+
+uint32_t RplHopByHopHeader::GetSerializedSize() const {
+	return RPL_HOP_BY_HOP_LEN;
+}
+
+void RplHopByHopHeader::Serialize(Buffer::Iterator start) const {
+	Buffer::Iterator i = start;
+
+	i.WriteU8(m_nextHeader);
+	i.WriteU8((RPL_HOP_BY_HOP_LEN - 8) / 8);
+	i.WriteU8(RPL_HDR_OPT_TYPE);
+	i.WriteU8(RPL_HDR_OPT_LEN);
+	i.WriteU8(m_flags);
+	i.WriteU8(m_instanceID);
+	i.WriteHtonU16(m_senderRank);
+}
+
+uint32_t RplHopByHopHeader::Deserialize(Buffer::Iterator start) {
+	Buffer::Iterator i = start;
+
+	m_nextHeader = i.ReadU8();
+	i.ReadU8(); /* Hdr Ext Len */
+	i.ReadU8(); /* option type */
+	i.ReadU8(); /* option length */
+	m_flags = i.ReadU8();
+	m_instanceID = i.ReadU8();
+	m_senderRank = i.ReadNtohU16();
 
-	return GetSerializedSize();
+	return i.GetDistanceFrom(start);
 }
 }
 }
@@ -33,6 +33,7 @@
 #define RPL_PACKET_H
 
 #include <iostream>
+#include <vector>
 #include "ns3/header.h"
 #include "ns3/icmpv6-header.h"
 #include "ns3/ipv6-address.h"
@@ -95,6 +96,50 @@ private:
 	uint32_t m_dstSeqNo; ///< Destination Sequence Number
 };
 
+/**
+ * \ingroup dsdv
+ * \brief Batch of route updates, sent as a single header
+ *
+ * The destinations share a prefix of PrefixLen octets, written once. Each
+ * record carries the remaining octets of its destination: the IID when the
+ * destinations share a /64, the 16-bit short ID when they share a /112.
+ * Hop counts are varints (7 bits per octet, least significant group first)
+ * and each sequence number is the zigzag varint of its difference with the
+ * sequence number of the previous record, 0 for the first record.
+ * \verbatim
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |  Count (varint)  |   PrefixLen   |  Prefix (PrefixLen octets)  |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |  Suffix (16 - PrefixLen octets)  | HopCount (varint) | SeqDelta |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ .                       Count records                           .
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ */
+class RplUpdateHeader: public Header {
+public:
+	RplUpdateHeader();
+	virtual ~RplUpdateHeader();
+	static TypeId GetTypeId(void);
+	virtual TypeId GetInstanceTypeId(void) const;
+	virtual uint32_t GetSerializedSize() const;
+	virtual void Serialize(Buffer::Iterator start) const;
+	virtual uint32_t Deserialize(Buffer::Iterator start);
+	virtual void Print(std::ostream &os) const;
+
+	/// Append the update of a destination to the batch
+	void AddRecord(RplHeader const & record);
+	std::vector<RplHeader> const & GetRecords() const {
+		return m_records;
+	}
+	uint32_t GetNRecords() const {
+		return m_records.size();
+	}
+private:
+	std::vector<RplHeader> m_records; ///< Updates, in sending order
+	uint8_t m_prefixLen; ///< Octets shared by the destinations of all the records
+};
+
 /**************************************************************/
 struct rpl_metric_object_energy {
 	uint8_t flags;
@@ -127,6 +172,7 @@ struct rpl_parent {
 	uint8_t link_metric;
 	uint8_t dtsn;
 	uint8_t updated;
+	uint8_t used;
 };
 typedef struct rpl_parent rpl_parent_t;
 /*---------------------------------------------------------------------------*/
@@ -152,7 +198,11 @@ struct rpl_dag {
 	rpl_parent_t *preferred_parent;
 	rpl_rank_t rank;
 	struct rpl_instance *instance;
-	//		LIST_STRUCT(parents);
+	/* parents heard in this DAG, linked through rpl_parent::next by
+	 increasing rank; they are allocated from parent_table */
+	rpl_parent_t *parents;
+	rpl_parent_t parent_table[RPL_MAX_PARENTS_PER_DAG];
+	uint8_t parent_count;
 	rpl_prefix_t prefix_info;
 };
 typedef struct rpl_dag rpl_dag_t;
@@ -205,6 +255,17 @@ struct rpl_of {
 };
 typedef struct rpl_of rpl_of_t;
 
+/*---------------------------------------------------------------------------*/
+/* Logical representation of a DAO Target option and of the Transit
+ information option that applies to it. */
+struct rpl_dao_target {
+	Ipv6Address prefix;
+	Ipv6Address parent; /* non-storing mode only, :: when absent */
+	uint8_t prefix_len;
+	uint8_t path_sequence;
+	uint8_t lifetime; /* in lifetime units, RPL_ZERO_LIFETIME for No-Path */
+};
+typedef struct rpl_dao_target rpl_dao_target_t;
 /*---------------------------------------------------------------------------*/
 /* Instance */
 struct rpl_instance {
@@ -212,7 +273,7 @@ struct rpl_instance {
 	rpl_metric_container_t mc;
 	rpl_of_t *of;
 	rpl_dag_t *current_dag;
-	rpl_dag_t dag_table[RPL_MAX_DAG_PER_INSTANCE];
+	rpl_dag_t *dag_table; /* MaxDagsPerInstance DAGs of the routing protocol */
 	/* The current default router - used for routing "upwards" */
 	Ipv6RoutingTableEntry *def_route;
 	uint8_t instance_id;
@@ -234,9 +295,18 @@ struct rpl_instance {
 	uint16_t dio_totsend;
 	uint16_t dio_totrecv;
 #endif /* RPL_CONF_STATS */
-	Timer dio_next_delay; /* delay for completion of dio interval */
+	Time dio_next_delay; /* delay for completion of dio interval */
 	Timer dio_timer;
 	Timer dao_timer;
+	/* deferred repair, see RPL_REPAIR_INTERVAL */
+	Timer repair_timer;
+	Time last_repair;
+	/* detached by a local repair since repair_start */
+	uint8_t repairing;
+	Time repair_start;
+	/* child targets waiting for the next DAO to the preferred parent */
+	rpl_dao_target_t dao_aggregated[RPL_DAO_MAX_AGGREGATED];
+	uint8_t dao_aggregated_count;
 };
 
 /*---------------------------------------------------------------------------*/
@@ -273,47 +343,32 @@ struct rpl_stats {
 	uint16_t malformed_msgs;
 	uint16_t resets;
 	uint16_t parent_switch;
+	uint16_t forward_errors;
+	uint16_t loop_errors;
+	uint16_t loop_warnings;
 };
 typedef struct rpl_stats rpl_stats_t;
 
 extern rpl_stats_t rpl_stats;
 #endif
-/*
-static void reset(rpl_dag_t *);
-static void parent_state_callback(rpl_parent_t *, int, int);
-static rpl_parent_t *best_parent(rpl_parent_t *, rpl_parent_t *);
-static rpl_dag_t *best_dag(rpl_dag_t *, rpl_dag_t *);
-static rpl_rank_t calculate_rank(rpl_parent_t *, rpl_rank_t);
-static void update_metric_container(rpl_instance_t *);
-
-rpl_of_t rpl_of_etx = {
-	  reset,
-	  parent_state_callback,
-	  best_parent,
-	  best_dag,
-	  calculate_rank,
-	  update_metric_container,
-	  1
-};
-*/
 /*---------------------------------------------------------------------------*/
 /* RPL macros. */
 /***************************************************************/
 
 /**
- * DIO packet.
+ * DIS packet (RFC 6550, section 6.2), without options.
  */
-class DIOPacket: public Icmpv6Header {
+class DISPacket: public Icmpv6Header {
 public:
 	/**
 	 * \brief Constructor.
 	 */
-	DIOPacket();
+	DISPacket();
 
 	/**
 	 * \brief Destructor.
 	 */
-	virtual ~DIOPacket();
+	virtual ~DISPacket();
 
 	/**
 	 * \brief Get the UID of this class.
@@ -328,64 +383,139 @@ public:
 	virtual TypeId GetInstanceTypeId() const;
 
 	/**
-	 * \brief Get the reserved field.
-	 * \return reserved value
+	 * \brief Print informations.
+	 * \param os output stream
+	 */
+	virtual void Print(std::ostream& os) const;
+
+	/**
+	 * \brief Get the serialized size.
+	 * \return serialized size
 	 */
-	uint32_t GetReserved() const;
+	virtual uint32_t GetSerializedSize() const;
 
 	/**
-	 * \brief Set the reserved field.
-	 * \param reserved the reserved value
+	 * \brief Serialize the packet.
+	 * \param start start offset
 	 */
-	void SetReserved(uint32_t reserved);
+	virtual void Serialize(Buffer::Iterator start) const;
 
 	/**
-	 * \brief Get the IPv6 target field.
-	 * \return IPv6 address
+	 * \brief Deserialize the packet.
+	 * \param start start offset
+	 * \return length of packet
 	 */
-	Ipv6Address GetIpv6Target() const;
+	virtual uint32_t Deserialize(Buffer::Iterator start);
+};
 
+/**
+ * RPL control message options (RFC 6550, section 6.7).
+ *
+ * The options are written and read in place on the message buffer. A reader
+ * walks the options with Next, which skips the Pad1 and PadN options and
+ * returns an iterator on the body of each option, then decodes the body of
+ * the options it knows. A body shorter than its option requires is rejected
+ * without reading past it.
+ */
+class RplOption {
+public:
 	/**
-	 * \brief Set the IPv6 target field.
-	 * \param target IPv6 address
+	 * \brief Find the next option of a message.
+	 * \param i iterator on the options, moved past the option found
+	 * \param left octets of the message after i, decreased accordingly
+	 * \param type the type of the option found
+	 * \param len the length of its body
+	 * \param body iterator on its body
+	 * \return false at the end of the message, or if the option is truncated
 	 */
-	void SetIpv6Target(Ipv6Address target);
+	static bool Next(Buffer::Iterator &i, uint32_t &left, uint8_t &type,
+			uint8_t &len, Buffer::Iterator &body);
 
 	/**
-	 * \brief Get the R flag.
-	 * \return R flag
+	 * \brief Write n octets of padding, as a Pad1 or a PadN option.
+	 */
+	static void WritePad(Buffer::Iterator &i, uint8_t n);
+
+	/// \return the size of the DAG Metric Container option of mc, 0 if none
+	static uint32_t GetMetricContainerSize(rpl_metric_container_t const & mc);
+	static void WriteMetricContainer(Buffer::Iterator &i,
+			rpl_metric_container_t const & mc);
+	static bool ReadMetricContainer(Buffer::Iterator body, uint8_t len,
+			rpl_metric_container_t &mc);
+
+	/// \return the size of the Route Information option of prefix
+	static uint32_t GetRouteInfoSize(rpl_prefix_t const & prefix);
+	static void WriteRouteInfo(Buffer::Iterator &i, rpl_prefix_t const & prefix);
+	static bool ReadRouteInfo(Buffer::Iterator body, uint8_t len,
+			rpl_prefix_t &prefix);
+
+	/// Size of the DODAG Configuration option
+	static const uint32_t DAG_CONF_SIZE = 16;
+	/**
+	 * \brief Write the DODAG Configuration option.
+	 * \param dio the Trickle, rank increase, OCP and lifetime parameters
+	 */
+	static void WriteDagConf(Buffer::Iterator &i, rpl_dio_t const & dio);
+	static bool ReadDagConf(Buffer::Iterator body, uint8_t len, rpl_dio_t &dio);
+
+	/// Size of the Prefix Information option
+	static const uint32_t PREFIX_INFO_SIZE = 32;
+	static void WritePrefixInfo(Buffer::Iterator &i, rpl_prefix_t const & prefix);
+	static bool ReadPrefixInfo(Buffer::Iterator body, uint8_t len,
+			rpl_prefix_t &prefix);
+
+	/// \return the size of the Target option of target, with the prefix bits only
+	static uint32_t GetTargetSize(rpl_dao_target_t const & target);
+	static void WriteTarget(Buffer::Iterator &i, rpl_dao_target_t const & target);
+	/**
+	 * \brief Read the prefix of a Target option.
+	 * \param target receives the prefix and its length
 	 */
-	bool GetFlagR() const;
+	static bool ReadTarget(Buffer::Iterator body, uint8_t len,
+			rpl_dao_target_t &target);
 
+	/// \return the size of the Transit Information option of target
+	static uint32_t GetTransitSize(rpl_dao_target_t const & target);
+	static void WriteTransit(Buffer::Iterator &i, rpl_dao_target_t const & target);
 	/**
-	 * \brief Set the R flag.
-	 * \param r value
+	 * \brief Read a Transit Information option.
+	 * \param target receives the Path Sequence, the Path Lifetime and the
+	 * parent address, :: when absent
 	 */
-	void SetFlagR(bool r);
+	static bool ReadTransit(Buffer::Iterator body, uint8_t len,
+			rpl_dao_target_t &target);
+};
 
+/**
+ * DIO packet (RFC 6550, section 6.3).
+ *
+ * Besides the DIO base object, the DIO carries a DAG Configuration option,
+ * then a DAG Metric Container, Route Information and Prefix Information
+ * option when the DAG has one.
+ */
+class DIOPacket: public Icmpv6Header {
+public:
 	/**
-	 * \brief Get the S flag.
-	 * \return S flag
+	 * \brief Constructor.
 	 */
-	bool GetFlagS() const;
+	DIOPacket();
 
 	/**
-	 * \brief Set the S flag.
-	 * \param s value
+	 * \brief Destructor.
 	 */
-	void SetFlagS(bool s);
+	virtual ~DIOPacket();
 
 	/**
-	 * \brief Get the O flag.
-	 * \return O flag
+	 * \brief Get the UID of this class.
+	 * \return UID
 	 */
-	bool GetFlagO() const;
+	static TypeId GetTypeId();
 
 	/**
-	 * \brief Set the O flag.
-	 * \param o value
+	 * \brief Get the instance type ID.
+	 * \return instance type ID
 	 */
-	void SetFlagO(bool o);
+	virtual TypeId GetInstanceTypeId() const;
 
 	/**
 	 * \brief Print informations.
@@ -433,43 +563,390 @@ public:
 	Ipv6Address GetDagID() const;
 	void SetDagID(Ipv6Address DagID);
 
-	rpl_instance_t *m_instance;
-	rpl_dag_t *m_dag;
+	/**
+	 * \brief Get the DIO base object and options read by Deserialize.
+	 * \return logical representation of the received DIO
+	 */
+	rpl_dio_t GetDio() const;
+
+	/**
+	 * \brief Set the DIO base object and options to send.
+	 * \param dio logical representation of the DIO; the options whose type
+	 * or length is 0 are omitted
+	 */
+	void SetDio(rpl_dio_t const & dio);
+
+private:
+	/**
+	 * \brief The DIO fields.
+	 */
+	rpl_dio_t m_dio;
+};
+
+/**
+ * DAO packet (RFC 6550, section 6.4), carrying Target options each
+ * followed by the Transit Information option that applies to it.
+ */
+class DAOPacket: public Icmpv6Header {
+public:
+	/**
+	 * \brief Constructor.
+	 */
+	DAOPacket();
+
+	/**
+	 * \brief Destructor.
+	 */
+	virtual ~DAOPacket();
+
+	/**
+	 * \brief Get the UID of this class.
+	 * \return UID
+	 */
+	static TypeId GetTypeId();
+
+	/**
+	 * \brief Get the instance type ID.
+	 * \return instance type ID
+	 */
+	virtual TypeId GetInstanceTypeId() const;
+
+	/**
+	 * \brief Print informations.
+	 * \param os output stream
+	 */
+	virtual void Print(std::ostream& os) const;
+
+	/**
+	 * \brief Get the serialized size.
+	 * \return serialized size
+	 */
+	virtual uint32_t GetSerializedSize() const;
+
+	/**
+	 * \brief Get the size a target adds to a DAO.
+	 * \param target the target
+	 * \return size of the Target and Transit options
+	 */
+	static uint32_t GetTargetSize(rpl_dao_target_t const & target);
+
+	/**
+	 * \brief Serialize the packet.
+	 * \param start start offset
+	 */
+	virtual void Serialize(Buffer::Iterator start) const;
+
+	/**
+	 * \brief Deserialize the packet.
+	 * \param start start offset
+	 * \return length of packet
+	 */
+	virtual uint32_t Deserialize(Buffer::Iterator start);
+
+	uint8_t GetInstanceID() const;
+	void SetInstanceID(uint8_t instanceID);
+
+	/**
+	 * \brief Get the K flag (DAO-ACK requested).
+	 * \return K flag
+	 */
+	bool GetFlagK() const;
+	void SetFlagK(bool k);
+
+	uint8_t GetSequence() const;
+	void SetSequence(uint8_t sequence);
+
+	/**
+	 * \brief Set the DODAG ID, which also sets the D flag.
+	 * \param dagID the DODAG ID
+	 */
+	void SetDagID(Ipv6Address dagID);
+	Ipv6Address GetDagID() const;
+
+	/**
+	 * \brief Get the D flag (DODAG ID present).
+	 * \return D flag
+	 */
+	bool GetFlagD() const;
+
+	/**
+	 * \brief Append a Target option and its Transit information.
+	 * \param target the target
+	 */
+	void AddTarget(rpl_dao_target_t const & target);
+
+	/**
+	 * \brief Get the targets, in the order of the packet.
+	 * \return the targets
+	 */
+	std::vector<rpl_dao_target_t> const & GetTargets() const;
+
+private:
+	uint8_t m_instanceID;
+	bool m_flagK;
+	bool m_flagD;
+	uint8_t m_sequence;
+	Ipv6Address m_dagID;
+	std::vector<rpl_dao_target_t> m_targets;
+};
+
+/**
+ * DAO-ACK packet (RFC 6550, section 6.5).
+ */
+class DAOAckPacket: public Icmpv6Header {
+public:
+	/**
+	 * \brief Constructor.
+	 */
+	DAOAckPacket();
+
+	/**
+	 * \brief Destructor.
+	 */
+	virtual ~DAOAckPacket();
+
+	/**
+	 * \brief Get the UID of this class.
+	 * \return UID
+	 */
+	static TypeId GetTypeId();
+
+	/**
+	 * \brief Get the instance type ID.
+	 * \return instance type ID
+	 */
+	virtual TypeId GetInstanceTypeId() const;
+
+	/**
+	 * \brief Print informations.
+	 * \param os output stream
+	 */
+	virtual void Print(std::ostream& os) const;
+
+	/**
+	 * \brief Get the serialized size.
+	 * \return serialized size
+	 */
+	virtual uint32_t GetSerializedSize() const;
+
+	/**
+	 * \brief Serialize the packet.
+	 * \param start start offset
+	 */
+	virtual void Serialize(Buffer::Iterator start) const;
+
+	/**
+	 * \brief Deserialize the packet.
+	 * \param start start offset
+	 * \return length of packet
+	 */
+	virtual uint32_t Deserialize(Buffer::Iterator start);
+
+	uint8_t GetInstanceID() const;
+	void SetInstanceID(uint8_t instanceID);
+
+	uint8_t GetSequence() const;
+	void SetSequence(uint8_t sequence);
+
+	uint8_t GetStatus() const;
+	void SetStatus(uint8_t status);
+
+private:
+	uint8_t m_instanceID;
+	uint8_t m_sequence;
+	uint8_t m_status;
+};
+
+/**
+ * RPL Source Routing Header (RFC 6554), the routing header of type 3 the
+ * root of a non-storing DODAG inserts in downward packets.
+ *
+ * The octets that an address shares with the IPv6 destination address are
+ * elided: CmprI octets for Addresses[1..n-1] and CmprE octets for Address[n].
+ * An address is restored by taking the elided octets from the destination
+ * of the packet that carries the header.
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+ 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |  Next Header  |  Hdr Ext Len  | Routing Type  | Segments Left |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ | CmprI | CmprE |  Pad  |               Reserved                |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ .                      Addresses[1..n]                          .
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ */
+class SourceRoutingHeader: public Header {
+public:
+	/**
+	 * \brief Constructor.
+	 */
+	SourceRoutingHeader();
+
+	/**
+	 * \brief Destructor.
+	 */
+	virtual ~SourceRoutingHeader();
+
+	/**
+	 * \brief Get the UID of this class.
+	 * \return UID
+	 */
+	static TypeId GetTypeId();
+
+	/**
+	 * \brief Get the instance type ID.
+	 * \return instance type ID
+	 */
+	virtual TypeId GetInstanceTypeId() const;
+
+	/**
+	 * \brief Print informations.
+	 * \param os output stream
+	 */
+	virtual void Print(std::ostream& os) const;
 
+	/**
+	 * \brief Get the serialized size.
+	 * \return serialized size
+	 */
+	virtual uint32_t GetSerializedSize() const;
+
+	/**
+	 * \brief Serialize the packet.
+	 * \param start start offset
+	 */
+	virtual void Serialize(Buffer::Iterator start) const;
+
+	/**
+	 * \brief Deserialize the packet.
+	 * \param start start offset
+	 * \return length of packet
+	 */
+	virtual uint32_t Deserialize(Buffer::Iterator start);
+
+	uint8_t GetNextHeader() const;
+	void SetNextHeader(uint8_t nextHeader);
+
+	uint8_t GetSegmentsLeft() const;
+	void SetSegmentsLeft(uint8_t segmentsLeft);
+
+	/**
+	 * \brief Set the hops following the IPv6 destination address, and choose
+	 * the compression against that destination. Segments Left is reset to
+	 * the number of hops.
+	 * \param dst the IPv6 destination address, i.e. the first hop
+	 * \param hops the next hops, the last one being the final destination
+	 */
+	void SetRoute(Ipv6Address dst, std::vector<Ipv6Address> const & hops);
+
+	/**
+	 * \return the number of addresses n of the header
+	 */
+	uint32_t GetNAddresses() const;
+
+	/**
+	 * \brief Get an address of the header.
+	 * \param index the index of the address, from 1 to n
+	 * \param dst the IPv6 destination address of the packet, which supplies
+	 * the elided octets
+	 * \return the address
+	 */
+	Ipv6Address GetAddress(uint32_t index, Ipv6Address dst) const;
 
 private:
-	uint8_t IntanceID;
-	uint8_t DagVersion;
-	uint16_t Rank;
-	uint8_t Grounded;
-	uint8_t MOP;
-	uint8_t Preference;
-	Ipv6Address DagID;
+	uint8_t m_nextHeader;
+	uint8_t m_segmentsLeft;
+	uint8_t m_cmprI;
+	uint8_t m_cmprE;
+	/* the addresses, with their elided octets zeroed */
+	std::vector<Ipv6Address> m_addresses;
+};
+
+/**
+ * Hop-by-Hop Options header holding the RPL option (RFC 6553) alone, as
+ * inserted in the data packets that travel inside a RPL instance.
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+ 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |  Next Header  |  Hdr Ext Len  |  Option Type  |  Opt Data Len |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |O|R|F|0|0|0|0|0| RPLInstanceID |          SenderRank           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ */
+class RplHopByHopHeader: public Header {
+public:
+	/**
+	 * \brief Constructor.
+	 */
+	RplHopByHopHeader();
 
 	/**
-	 * \brief The R flag.
+	 * \brief Destructor.
 	 */
-	bool m_flagR;
+	virtual ~RplHopByHopHeader();
 
 	/**
-	 * \brief The O flag.
+	 * \brief Get the UID of this class.
+	 * \return UID
 	 */
-	bool m_flagS;
+	static TypeId GetTypeId();
 
 	/**
-	 * \brief The M flag.
+	 * \brief Get the instance type ID.
+	 * \return instance type ID
 	 */
-	bool m_flagO;
+	virtual TypeId GetInstanceTypeId() const;
 
 	/**
-	 * \brief The reserved value.
+	 * \brief Print informations.
+	 * \param os output stream
 	 */
-	uint32_t m_reserved;
+	virtual void Print(std::ostream& os) const;
 
 	/**
-	 * \brief The IPv6 target address.
+	 * \brief Get the serialized size.
+	 * \return serialized size
 	 */
-	Ipv6Address m_target;
+	virtual uint32_t GetSerializedSize() const;
+
+	/**
+	 * \brief Serialize the packet.
+	 * \param start start offset
+	 */
+	virtual void Serialize(Buffer::Iterator start) const;
+
+	/**
+	 * \brief Deserialize the packet.
+	 * \param start start offset
+	 * \return length of packet
+	 */
+	virtual uint32_t Deserialize(Buffer::Iterator start);
+
+	uint8_t GetNextHeader() const;
+	void SetNextHeader(uint8_t nextHeader);
+
+	/**
+	 * \return the RPL_HDR_OPT_DOWN, RPL_HDR_OPT_RANK_ERR and
+	 * RPL_HDR_OPT_FWD_ERR flags
+	 */
+	uint8_t GetFlags() const;
+	void SetFlags(uint8_t flags);
+
+	uint8_t GetInstanceID() const;
+	void SetInstanceID(uint8_t instanceID);
+
+	uint16_t GetSenderRank() const;
+	void SetSenderRank(uint16_t senderRank);
+
+private:
+	uint8_t m_nextHeader;
+	uint8_t m_flags;
+	uint8_t m_instanceID;
+	uint16_t m_senderRank;
 };
 
 static inline std::ostream & operator<<(std::ostream& os,
@@ -0,0 +1,445 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RPL_RADIX_TRIE_H
+#define RPL_RADIX_TRIE_H
+
+#include <cstring>
+#include <stdint.h>
+#include "ns3/ipv6-address.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+namespace rpl {
+
+/**
+ * \ingroup rpl
+ * \brief Path compressed binary trie (Patricia) over IPv6 prefixes
+ *
+ * Each node holds a prefix and its length; only nodes that were inserted
+ * carry a value, the others are branching points. Lookups walk at most one
+ * node per branching bit, so a longest prefix match costs O(128) bit tests
+ * whatever the number of prefixes stored. Iteration visits the prefixes in
+ * address order, a prefix before the longer prefixes it covers.
+ */
+template <typename T>
+class RadixTrie
+{
+  struct Node
+  {
+    uint8_t key[16];
+    uint8_t len;
+    bool used;
+    T value;
+    Node *child[2];
+    Node *parent;
+
+    Node (uint8_t const *k, uint8_t l, Node *p)
+      : len (l),
+        used (false),
+        value (),
+        parent (p)
+    {
+      std::memcpy (key, k, 16);
+      child[0] = child[1] = 0;
+    }
+  };
+
+public:
+  class Iterator;
+  friend class Iterator;
+  /// Iterator over the stored prefixes, in address order
+  class Iterator
+  {
+public:
+    Iterator ()
+      : m_node (0)
+    {
+    }
+    Ipv6Address
+    GetPrefix () const
+    {
+      return Ipv6Address (const_cast<uint8_t *> (m_node->key));
+    }
+    uint8_t
+    GetPrefixLength () const
+    {
+      return m_node->len;
+    }
+    T &
+    operator* () const
+    {
+      return m_node->value;
+    }
+    T *
+    operator-> () const
+    {
+      return &m_node->value;
+    }
+    Iterator &
+    operator++ ()
+    {
+      do
+        {
+          m_node = RadixTrie::Next (m_node);
+        }
+      while (m_node != 0 && !m_node->used);
+      return *this;
+    }
+    bool
+    operator== (Iterator const & o) const
+    {
+      return m_node == o.m_node;
+    }
+    bool
+    operator!= (Iterator const & o) const
+    {
+      return m_node != o.m_node;
+    }
+
+private:
+    friend class RadixTrie;
+    explicit Iterator (Node *n)
+      : m_node (n)
+    {
+    }
+    Node *m_node;
+  };
+
+  RadixTrie ()
+    : m_size (0)
+  {
+    uint8_t zero[16] = { 0 };
+    m_root = new Node (zero, 0, 0);
+  }
+  RadixTrie (RadixTrie const & o)
+    : m_size (0)
+  {
+    uint8_t zero[16] = { 0 };
+    m_root = new Node (zero, 0, 0);
+    CopyFrom (o);
+  }
+  RadixTrie &
+  operator= (RadixTrie const & o)
+  {
+    if (this != &o)
+      {
+        Clear ();
+        CopyFrom (o);
+      }
+    return *this;
+  }
+  ~RadixTrie ()
+  {
+    Clear ();
+    delete m_root;
+  }
+
+  /**
+   * Insert prefix/len, or replace its value if it is already present.
+   * \return the stored value
+   */
+  T &
+  Insert (Ipv6Address prefix, uint8_t len, T const & value)
+  {
+    NS_ASSERT (len <= 128);
+    uint8_t key[16];
+    MaskedKey (prefix, len, key);
+    Node *n = m_root;
+    while (n->len != len)
+      {
+        int b = Bit (key, n->len);
+        Node *c = n->child[b];
+        if (c == 0)
+          {
+            n->child[b] = c = new Node (key, len, n);
+            return Store (c, value);
+          }
+        uint8_t common = CommonLength (c->key, key, c->len < len ? c->len : len);
+        if (common == c->len)
+          {
+            n = c;
+            continue;
+          }
+        // c diverges from the key or is longer: insert a node above it
+        Node *up = new Node (key, common, n);
+        MaskKey (up->key, common);
+        n->child[b] = up;
+        up->child[Bit (c->key, common)] = c;
+        c->parent = up;
+        if (common == len)
+          {
+            return Store (up, value);
+          }
+        Node *leaf = new Node (key, len, up);
+        up->child[Bit (key, common)] = leaf;
+        return Store (leaf, value);
+      }
+    return Store (n, value);
+  }
+  /// \return the value stored for exactly prefix/len, or 0
+  T *
+  Find (Ipv6Address prefix, uint8_t len) const
+  {
+    uint8_t key[16];
+    MaskedKey (prefix, len, key);
+    Node *n = Walk (key, len);
+    return (n != 0 && n->len == len && n->used) ? &n->value : 0;
+  }
+  /**
+   * Longest prefix match of addr.
+   * \param len if not null, receives the length of the matching prefix
+   * \return the value of the longest prefix covering addr, or 0
+   */
+  T *
+  LongestMatch (Ipv6Address addr, uint8_t *len = 0) const
+  {
+    uint8_t key[16];
+    addr.GetBytes (key);
+    Node *best = m_root->used ? m_root : 0;
+    Node *n = m_root;
+    while (n->len < 128)
+      {
+        Node *c = n->child[Bit (key, n->len)];
+        if (c == 0 || CommonLength (c->key, key, c->len) != c->len)
+          {
+            break;
+          }
+        if (c->used)
+          {
+            best = c;
+          }
+        n = c;
+      }
+    if (best == 0)
+      {
+        return 0;
+      }
+    if (len != 0)
+      {
+        *len = best->len;
+      }
+    return &best->value;
+  }
+  /// Remove prefix/len. \return false if it was not present
+  bool
+  Remove (Ipv6Address prefix, uint8_t len)
+  {
+    uint8_t key[16];
+    MaskedKey (prefix, len, key);
+    Node *n = Walk (key, len);
+    if (n == 0 || n->len != len || !n->used)
+      {
+        return false;
+      }
+    Erase (n);
+    return true;
+  }
+  /// Remove the prefix an iterator points to. \return an iterator on the next prefix
+  Iterator
+  Erase (Iterator it)
+  {
+    Iterator next = it;
+    ++next;
+    // erasing only frees n and branching nodes without value, never next
+    Erase (it.m_node);
+    return next;
+  }
+  void
+  Clear ()
+  {
+    Node *c0 = m_root->child[0];
+    Node *c1 = m_root->child[1];
+    Destroy (c0);
+    Destroy (c1);
+    m_root->child[0] = m_root->child[1] = 0;
+    m_root->used = false;
+    m_root->value = T ();
+    m_size = 0;
+  }
+  uint32_t
+  Size () const
+  {
+    return m_size;
+  }
+  bool
+  Empty () const
+  {
+    return m_size == 0;
+  }
+  Iterator
+  Begin () const
+  {
+    Iterator it (m_root);
+    if (!m_root->used)
+      {
+        ++it;
+      }
+    return it;
+  }
+  Iterator
+  End () const
+  {
+    return Iterator ();
+  }
+
+private:
+  static int
+  Bit (uint8_t const *key, uint8_t i)
+  {
+    return (key[i >> 3] >> (7 - (i & 7))) & 1;
+  }
+  static void
+  MaskKey (uint8_t *key, uint8_t len)
+  {
+    for (uint8_t i = 0; i < 16; i++)
+      {
+        if (len >= 8 * (i + 1))
+          {
+            continue;
+          }
+        key[i] &= (len <= 8 * i) ? 0 : (uint8_t)(0xff << (8 - (len - 8 * i)));
+      }
+  }
+  static void
+  MaskedKey (Ipv6Address addr, uint8_t len, uint8_t *key)
+  {
+    addr.GetBytes (key);
+    MaskKey (key, len);
+  }
+  /// \return the number of leading bits a and b share, at most max
+  static uint8_t
+  CommonLength (uint8_t const *a, uint8_t const *b, uint8_t max)
+  {
+    uint8_t l = 0;
+    while (l < max)
+      {
+        uint8_t x = a[l >> 3] ^ b[l >> 3];
+        if (x == 0)
+          {
+            l = (l & ~7) + 8;
+            continue;
+          }
+        while (!(x & (0x80 >> (l & 7))))
+          {
+            l++;
+          }
+        break;
+      }
+    return l < max ? l : max;
+  }
+  /// Pre-order successor of n, 0 after the last node
+  static Node *
+  Next (Node *n)
+  {
+    if (n->child[0] != 0)
+      {
+        return n->child[0];
+      }
+    if (n->child[1] != 0)
+      {
+        return n->child[1];
+      }
+    while (n->parent != 0)
+      {
+        Node *p = n->parent;
+        if (p->child[0] == n && p->child[1] != 0)
+          {
+            return p->child[1];
+          }
+        n = p;
+      }
+    return 0;
+  }
+  /// \return the deepest node whose prefix covers key/len
+  Node *
+  Walk (uint8_t const *key, uint8_t len) const
+  {
+    Node *n = m_root;
+    while (n->len < len)
+      {
+        Node *c = n->child[Bit (key, n->len)];
+        if (c == 0 || c->len > len || CommonLength (c->key, key, c->len) != c->len)
+          {
+            break;
+          }
+        n = c;
+      }
+    return n;
+  }
+  T &
+  Store (Node *n, T const & value)
+  {
+    if (!n->used)
+      {
+        n->used = true;
+        m_size++;
+      }
+    n->value = value;
+    return n->value;
+  }
+  /// Drop the value of n and free the branching nodes that became useless
+  void
+  Erase (Node *n)
+  {
+    n->used = false;
+    n->value = T ();
+    m_size--;
+    while (n != m_root && !n->used)
+      {
+        Node *p = n->parent;
+        Node *only = n->child[0] != 0 ? n->child[0] : n->child[1];
+        if (n->child[0] != 0 && n->child[1] != 0)
+          {
+            break;
+          }
+        p->child[p->child[0] == n ? 0 : 1] = only;
+        if (only != 0)
+          {
+            only->parent = p;
+          }
+        delete n;
+        n = p;
+      }
+  }
+  static void
+  Destroy (Node *n)
+  {
+    if (n == 0)
+      {
+        return;
+      }
+    Destroy (n->child[0]);
+    Destroy (n->child[1]);
+    delete n;
+  }
+  void
+  CopyFrom (RadixTrie const & o)
+  {
+    for (Iterator it = o.Begin (); it != o.End (); ++it)
+      {
+        Insert (it.GetPrefix (), it.GetPrefixLength (), *it);
+      }
+  }
+
+  Node *m_root;
+  uint32_t m_size;
+};
+
+} // namespace rpl
+} // namespace ns3
+
+#endif /* RPL_RADIX_TRIE_H */
@@ -23,10 +23,16 @@
 #include "ns3/inet6-socket-address.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/ipv6-raw-socket-factory.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/ipv6-option.h"
+#include "ns3/ipv6-option-demux.h"
 #include "ns3/wifi-net-device.h"
 #include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/ilive-trace.h"
 
 NS_LOG_COMPONENT_DEFINE("RplRoutingProtocol");
 
@@ -74,6 +80,78 @@ struct DeferredRouteOutputTag: public Tag {
 	}
 };
 
+/**
+ * Tag naming the node a packet was last sent by.
+ *
+ * A router learns from it the neighbor a data packet came from, which the
+ * RPL option processing needs (RFC 6550, section 11.2.2.3): ns-3 hands
+ * RouteInput the IPv6 header and the input device, but not the link-layer
+ * source of the frame. The tag stands for that source address; it is not
+ * carried on the wire.
+ */
+struct PreviousHopTag: public Tag {
+	/// Node the packet was sent by
+	Ipv6Address sender;
+
+	PreviousHopTag(Ipv6Address s = Ipv6Address()) :
+			Tag(), sender(s) {
+	}
+
+	static TypeId GetTypeId() {
+		static TypeId tid =
+				TypeId("ns3::rpl::PreviousHopTag").SetParent<Tag>();
+		return tid;
+	}
+
+	TypeId GetInstanceTypeId() const {
+		return GetTypeId();
+	}
+
+	uint32_t GetSerializedSize() const {
+		return 16;
+	}
+
+	void Serialize(TagBuffer i) const {
+		uint8_t buf[16];
+		sender.Serialize(buf);
+		i.Write(buf, 16);
+	}
+
+	void Deserialize(TagBuffer i) {
+		uint8_t buf[16];
+		i.Read(buf, 16);
+		sender = Ipv6Address::Deserialize(buf);
+	}
+
+	void Print(std::ostream &os) const {
+		os << "PreviousHopTag: sender = " << sender;
+	}
+};
+
+/// Accepts the RPL option (RFC 6553), which RouteInput checks and updates:
+/// the IPv6 stack drops the packets carrying an option type it does not know
+class RplHopByHopOption: public Ipv6Option {
+public:
+	static TypeId GetTypeId() {
+		static TypeId tid =
+				TypeId("ns3::rpl::RplHopByHopOption").SetParent<Ipv6Option>().AddConstructor<
+						RplHopByHopOption>();
+		return tid;
+	}
+
+	uint8_t GetOptionNumber() const {
+		return RPL_HDR_OPT_TYPE;
+	}
+
+	uint8_t Process(Ptr<Packet>, uint8_t, Ipv6Header const &,
+			bool & isDropped) {
+		isDropped = false;
+		return 2 + RPL_HDR_OPT_LEN;
+	}
+};
+
+NS_OBJECT_ENSURE_REGISTERED(RplHopByHopOption);
+
 TypeId RoutingProtocol::GetTypeId(void) {
 	static TypeId tid = TypeId("ns3::rpl::RoutingProtocol")
 			.SetParent<Ipv6RoutingProtocol>()
@@ -103,6 +181,19 @@ TypeId RoutingProtocol::GetTypeId(void) {
 					TimeValue(Seconds(30)),
 					MakeTimeAccessor(&RoutingProtocol::m_maxQueueTime),
 					MakeTimeChecker())
+			.AddAttribute("MaxQueueBytes",
+					"Maximum number of bytes that we allow a routing protocol to buffer.",
+					UintegerValue(0xffffffff),
+					MakeUintegerAccessor(&RoutingProtocol::m_maxQueueBytes),
+					MakeUintegerChecker<uint32_t>())
+			.AddAttribute("QueueDropPolicy",
+					"Packet dropped when the buffer is full: the arriving one, the oldest one, "
+							"or the oldest one of a lower priority than the arriving one.",
+					EnumValue(PacketQueue::DROP_TAIL),
+					MakeEnumAccessor(&RoutingProtocol::m_queueDropPolicy),
+					MakeEnumChecker(PacketQueue::DROP_TAIL, "DropTail",
+							PacketQueue::DROP_HEAD, "DropHead",
+							PacketQueue::DROP_LOWEST_PRIORITY, "DropLowestPriority"))
 			.AddAttribute("EnableBuffering",
 					"Enables buffering of data packets if no route to destination is available",
 					BooleanValue(true),
@@ -137,7 +228,59 @@ TypeId RoutingProtocol::GetTypeId(void) {
 					"Time to aggregate updates before sending them out (in seconds)",
 					TimeValue(Seconds(1)),
 					MakeTimeAccessor(&RoutingProtocol::m_routeAggregationTime),
-					MakeTimeChecker());
+					MakeTimeChecker())
+			.AddAttribute("SettlingTick",
+					"Granularity of the settling times: the updates whose settling time ends in the same tick are sent together",
+					TimeValue(MilliSeconds(500)),
+					MakeTimeAccessor(&RoutingProtocol::m_settlingTick),
+					MakeTimeChecker())
+			.AddAttribute("MaxInstances",
+					"Maximum number of RPL instances the node joins at the same time",
+					UintegerValue(RPL_MAX_INSTANCES),
+					MakeUintegerAccessor(&RoutingProtocol::m_maxInstances),
+					MakeUintegerChecker<uint32_t>(1, 256))
+			.AddAttribute("MaxDagsPerInstance",
+					"Maximum number of DAGs the node tracks in an RPL instance",
+					UintegerValue(RPL_MAX_DAG_PER_INSTANCE),
+					MakeUintegerAccessor(&RoutingProtocol::m_maxDagsPerInstance),
+					MakeUintegerChecker<uint32_t>(1, 255))
+			.AddAttribute("Mop",
+					"Mode of operation of the DODAGs this node roots: downward routes stored by every node, "
+							"by the root only as source routes, or none.",
+					EnumValue(RPL_MOP_DEFAULT),
+					MakeEnumAccessor(&RoutingProtocol::m_mop),
+					MakeEnumChecker(RPL_MOP_STORING_NO_MULTICAST, "Storing",
+							RPL_MOP_NON_STORING, "NonStoring",
+							RPL_MOP_NO_DOWNWARD_ROUTES, "NoDownwardRoutes"))
+			.AddAttribute("MinRepairInterval",
+					"Minimum time between two repairs of an RPL instance, local repairs or DODAG version increments",
+					TimeValue(Seconds(RPL_REPAIR_INTERVAL)),
+					MakeTimeAccessor(&RoutingProtocol::m_minRepairInterval),
+					MakeTimeChecker())
+			.AddTraceSource("ControlTx",
+					"An RPL control message (DIS, DIO, DAO or DAO-ACK) is sent.",
+					MakeTraceSourceAccessor(&RoutingProtocol::m_controlTxTrace))
+			.AddTraceSource("DagJoin",
+					"The node joined a DAG, as a root or through a parent.",
+					MakeTraceSourceAccessor(&RoutingProtocol::m_dagJoinTrace))
+			.AddTraceSource("Reattach",
+					"The node found a parent again after a local repair, in the time given since it detached.",
+					MakeTraceSourceAccessor(&RoutingProtocol::m_reattachTrace))
+			.AddTraceSource("QueueDropTail",
+					"A packet is not buffered as the buffer is full.",
+					MakeTraceSourceAccessor(&RoutingProtocol::m_queueDropTailTrace))
+			.AddTraceSource("QueueDropHead",
+					"The oldest buffered packet is dropped to make room.",
+					MakeTraceSourceAccessor(&RoutingProtocol::m_queueDropHeadTrace))
+			.AddTraceSource("QueueDropPriority",
+					"A buffered packet is dropped to make room for one of a higher priority.",
+					MakeTraceSourceAccessor(&RoutingProtocol::m_queueDropPriorityTrace))
+			.AddTraceSource("QueueDropExpired",
+					"A buffered packet is dropped as it waited for a route longer than MaxQueueTime.",
+					MakeTraceSourceAccessor(&RoutingProtocol::m_queueDropExpiredTrace))
+			.AddTraceSource("QueueDropFlushed",
+					"A buffered packet is dropped as its destination is unreachable.",
+					MakeTraceSourceAccessor(&RoutingProtocol::m_queueDropFlushedTrace));
 	return tid;
 }
 
@@ -147,6 +290,10 @@ void RoutingProtocol::SetEnableBufferFlag(bool f) {
 bool RoutingProtocol::GetEnableBufferFlag() const {
 	return EnableBuffering;
 }
+uint32_t RoutingProtocol::GetNRoutes() {
+	return m_routingTable.RoutingTableSize() + m_daoRoutingTable.Size()
+			+ m_sourceRoutingTable.Size();
+}
 void RoutingProtocol::SetWSTFlag(bool f) {
 	EnableWST = f;
 }
@@ -168,14 +315,38 @@ int64_t RoutingProtocol::AssignStreams(int64_t stream) {
 
 RoutingProtocol::RoutingProtocol() :
 		m_routingTable(), m_advRoutingTable(), m_queue(), m_periodicUpdateTimer(
-				Timer::CANCEL_ON_DESTROY) {
+				Timer::CANCEL_ON_DESTROY), m_routeExpiryTimer(
+				Timer::CANCEL_ON_DESTROY), m_daoExpiryTimer(
+				Timer::CANCEL_ON_DESTROY), m_disTimer(Timer::CANCEL_ON_DESTROY) {
 	m_uniformRandomVariable = CreateObject<UniformRandomVariable>();
+	m_daoSequence = RPL_LOLLIPOP_INIT;
+	m_pathSequence = RPL_LOLLIPOP_INIT;
+	memset(instance_index, 0, sizeof(instance_index));
+	default_instance = NULL;
+	m_dag = NULL;
+	m_advRoutingTable.SetNextHopPool(m_routingTable.GetNextHopPool());
 }
 
 RoutingProtocol::~RoutingProtocol() {
 }
 
 void RoutingProtocol::DoDispose() {
+	for (DisReplyMap::iterator i = m_disReplies.begin(); i != m_disReplies.end();
+			++i) {
+		i->second.Cancel();
+	}
+	m_disReplies.clear();
+	m_settlingWheel.Clear();
+	m_drainPending.clear();
+	for (size_t i = 0; i < instance_table.size(); ++i) {
+		if (instance_table[i].used) {
+			rpl_free_instance(&instance_table[i]);
+		}
+	}
+	if (m_rplSocket != 0) {
+		m_rplSocket->Close();
+		m_rplSocket = 0;
+	}
 	m_ipv6 = 0;
 	for (std::map<Ptr<Socket>, Ipv6InterfaceAddress>::iterator iter =
 			m_socketAddresses.begin(); iter != m_socketAddresses.end();
@@ -190,31 +361,76 @@ void RoutingProtocol::PrintRoutingTable(Ptr<OutputStreamWrapper> stream) const {
 	*stream->GetStream() << "Node: " << m_ipv6->GetObject<Node>()->GetId()
 			<< " Time: " << Simulator::Now().GetSeconds() << "s ";
 	m_routingTable.Print(stream);
+	if (m_daoRoutingTable.Size() > 0) {
+		m_daoRoutingTable.Print(stream);
+	}
+	if (m_sourceRoutingTable.Size() > 0) {
+		m_sourceRoutingTable.Print(stream);
+	}
 }
 
 void RoutingProtocol::Start() {
+	rpl_init();
 	m_queue.SetMaxPacketsPerDst(m_maxQueuedPacketsPerDst);
 	m_queue.SetMaxQueueLen(m_maxQueueLen);
 	m_queue.SetQueueTimeout(m_maxQueueTime);
+	m_queue.SetMaxQueueBytes(m_maxQueueBytes);
+	m_queue.SetDropPolicy(m_queueDropPolicy);
+	m_queue.SetDropCallback(MakeCallback(&RoutingProtocol::QueueDrop, this));
 	m_routingTable.Setholddowntime(Time(Holdtimes * m_periodicUpdateInterval));
 	m_advRoutingTable.Setholddowntime(
 			Time(Holdtimes * m_periodicUpdateInterval));
+	m_settlingWheel.SetTick(m_settlingTick);
+	m_settlingWheel.SetExpireCallback(
+			MakeCallback(&RoutingProtocol::SendTriggeredUpdate, this));
+	m_routingTable.SetRouteArrivalCallback(
+			MakeCallback(&RoutingProtocol::HandleRouteArrival, this));
 //	m_scb = MakeCallback(&RoutingProtocol::Send, this);
 //	m_scb = MakeCallback(&RoutingProtocol::RPLSend, this); //RPL DIO/DAO/DIS sending
 	m_ecb = MakeCallback(&RoutingProtocol::Drop, this);
-//	m_periodicUpdateTimer.SetFunction(&RoutingProtocol::SendPeriodicUpdate, this);
-	m_periodicUpdateTimer.SetFunction(&RoutingProtocol::SendPeriodicDIOPacket, this);
+	m_periodicUpdateTimer.SetFunction(&RoutingProtocol::SendPeriodicUpdate, this);
+	m_routeExpiryTimer.SetFunction(&RoutingProtocol::PurgeExpiredRoutes, this);
+	m_daoExpiryTimer.SetFunction(&RoutingProtocol::PurgeExpiredDaoRoutes,
+			this);
+	m_disTimer.SetFunction(&RoutingProtocol::handle_dis_timer, this);
+	Ptr<Ipv6OptionDemux> options = m_ipv6->GetObject<Ipv6OptionDemux>();
+	if (options != 0 && options->GetOption(RPL_HDR_OPT_TYPE) == 0) {
+		Ptr<RplHopByHopOption> option = CreateObject<RplHopByHopOption>();
+		option->SetNode(m_ipv6->GetObject<Node>());
+		options->Insert(option);
+	}
+	m_linkEstimator.SetLinkMetricCallback(
+			MakeCallback(&RoutingProtocol::rpl_link_neighbor_callback, this));
 	Time t_update_root = Seconds(m_uniformRandomVariable->GetInteger(0, 3));
 	Time t_update_leaf = Seconds(m_uniformRandomVariable->GetInteger(4, 6));
 
+	// DIS/DIO/DAO are ICMPv6 messages, read them from a raw socket
+	m_rplSocket = Socket::CreateSocket(m_ipv6->GetObject<Node>(),
+			Ipv6RawSocketFactory::GetTypeId());
+	NS_ASSERT(m_rplSocket != 0);
+	m_rplSocket->SetAttribute("Protocol",
+			UintegerValue(Ipv6Header::IPV6_ICMPV6));
+	m_rplSocket->Bind(Inet6SocketAddress(Ipv6Address::GetAny(), 0));
+	m_rplSocket->SetRecvCallback(
+			MakeCallback(&RoutingProtocol::RecvRplControl, this));
+
 	if(m_ipv6->GetObject<Node>()->GetId() == 0){
-		std::cout << "RPL: This is the root node" << std::endl;
-		Ipv6Address addr = new Ipv6Address ("2001:1::1");
-		m_dag = this->rpl_set_root(RPL_DEFAULT_INSTANCE, &addr);
+		ILIVE_TRACE_INFO ("RPL: This is the root node");
+		/* DIOs are paced by the Trickle timer started in rpl_set_root. The
+		 DODAG ID is an address of the root, so that the non-storing DAOs
+		 sent to it are delivered here. */
+		NS_ASSERT(m_mainAddress != Ipv6Address());
+		m_dag = this->rpl_set_root(RPL_DEFAULT_INSTANCE, m_mainAddress);
 		m_periodicUpdateTimer.Schedule(t_update_root);
 	}else{
-		std::cout << "RPL: This is not the root node, let it have some delay to start" << std::endl;
+		ILIVE_TRACE_INFO ("RPL: This is not the root node, let it have some delay to start");
 		m_periodicUpdateTimer.Schedule(t_update_leaf);
+#if RPL_DIS_SEND
+		/* Solicit the DIOs of the neighbors instead of waiting for their
+		 Trickle timers. */
+		m_disTimer.Schedule(MilliSeconds(m_uniformRandomVariable->GetInteger(0,
+				RPL_DIS_START_DELAY * 1000)));
+#endif /* RPL_DIS_SEND */
 	}
 }
 
@@ -232,58 +448,42 @@ Ptr<Ipv6Route> RoutingProtocol::RouteOutput(Ptr<Packet> p,
 		Ptr<Ipv6Route> route;
 		return route;
 	}
-	std::map<Ipv6Address, RoutingTableEntry> removedAddresses;
 	sockerr = Socket::ERROR_NOTERROR;
 	Ptr<Ipv6Route> route;
 	Ipv6Address dst = header.GetDestinationAddress();
 	NS_LOG_DEBUG ("Packet Size: " << p->GetSize ()
 			<< ", Packet id: " << p->GetUid () << ", Destination address in Packet: " << dst);
-	RoutingTableEntry rt;
-	m_routingTable.Purge(removedAddresses);
-	for (std::map<Ipv6Address, RoutingTableEntry>::iterator rmItr =
-			removedAddresses.begin(); rmItr != removedAddresses.end();
-			++rmItr) {
-		rmItr->second.SetEntriesChanged(true);
-		rmItr->second.SetSeqNo(rmItr->second.GetSeqNo() + 1);
-		m_advRoutingTable.AddRoute(rmItr->second);
+	// the root of a non-storing DODAG loops its downward packets back to
+	// RouteInput, where the source routing header is inserted
+	std::vector<Ipv6Address> hops;
+	if (LookupSourceRoute(dst, hops)) {
+		return LoopbackRoute(header, oif);
 	}
-	if (!removedAddresses.empty()) {
-		Simulator::Schedule(
-				MicroSeconds(m_uniformRandomVariable->GetInteger(0, 1000)),
-				&RoutingProtocol::SendTriggeredUpdate, this);
+	// expired routes are removed by PurgeExpiredRoutes, not per packet;
+	// the next hop of multi-hop destinations is resolved in the table
+	route = m_daoRoutingTable.LookupRoute(dst);
+	bool down = route != 0;
+	if (route == 0) {
+		route = m_routingTable.LookupResolvedRoute(dst);
 	}
-	if (m_routingTable.LookupRoute(dst, rt)) {
-		if (EnableBuffering) {
-			LookForQueuedPackets();
-		}
-		if (rt.GetHop() == 1) {
-			route = rt.GetRoute();
-			NS_ASSERT(route != 0);
-			NS_LOG_DEBUG ("A route exists from " << route->GetSource ()
-					<< " to neighboring destination "
-					<< route->GetDestination ());
-			if (oif != 0 && route->GetOutputDevice() != oif) {
-				NS_LOG_DEBUG ("Output device doesn't match. Dropped.");
-				sockerr = Socket::ERROR_NOROUTETOHOST;
-				return Ptr<Ipv6Route>();
-			}
-			return route;
-		} else {
-			RoutingTableEntry newrt;
-			if (m_routingTable.LookupRoute(rt.GetNextHop(), newrt)) {
-				route = newrt.GetRoute();
-				NS_ASSERT(route != 0);
-				NS_LOG_DEBUG ("A route exists from " << route->GetSource ()
-						<< " to destination " << dst << " via "
-						<< rt.GetNextHop ());
-				if (oif != 0 && route->GetOutputDevice() != oif) {
-					NS_LOG_DEBUG ("Output device doesn't match. Dropped.");
-					sockerr = Socket::ERROR_NOROUTETOHOST;
-					return Ptr<Ipv6Route>();
-				}
-				return route;
-			}
+	if (route != 0) {
+		NS_LOG_DEBUG ("A route exists from " << route->GetSource ()
+				<< " to destination " << dst << " via "
+				<< route->GetGateway ());
+		if (oif != 0 && route->GetOutputDevice() != oif) {
+			NS_LOG_DEBUG ("Output device doesn't match. Dropped.");
+			sockerr = Socket::ERROR_NOROUTETOHOST;
+			return Ptr<Ipv6Route>();
+		}
+#if RPL_INSERT_HBH_OPTION
+		// the IPv6 header is only built after RouteOutput: the packet is
+		// looped back to RouteInput, which inserts the RPL option
+		if (IsDodagRoute(route, down)) {
+			return LoopbackRoute(header, oif);
 		}
+#endif /* RPL_INSERT_HBH_OPTION */
+		SetNextHop(p, route->GetGateway());
+		return route;
 	}
 
 	if (EnableBuffering) {
@@ -305,6 +505,12 @@ void RoutingProtocol::DeferredRouteOutput(Ptr<const Packet> p,
 	bool result = m_queue.Enqueue(newEntry);
 	if (result) {
 		NS_LOG_DEBUG ("Added packet " << p->GetUid () << " to queue.");
+		// the route may have arrived since RouteOutput
+		Ipv6Address dst = header.GetDestinationAddress();
+		if (m_daoRoutingTable.LookupRoute(dst) != 0
+				|| m_routingTable.LookupResolvedRoute(dst) != 0) {
+			ScheduleDrain(dst);
+		}
 	}
 }
 
@@ -333,6 +539,19 @@ bool RoutingProtocol::RouteInput(Ptr<const Packet> p, const Ipv6Header &header,
 		return false;
 	}
 
+	// Downward packet of a non-storing DODAG
+	uint8_t routing[3];
+	if (header.GetNextHeader() == Ipv6Header::IPV6_EXT_ROUTING
+			&& m_ipv6->GetInterfaceForAddress(dst) >= 0
+			&& p->CopyData(routing, 3) == 3
+			&& routing[2] == RPL_SRH_ROUTING_TYPE) {
+		ForwardSourceRoute(p, header, iif, ucb, lcb, ecb);
+		return true;
+	}
+	if (SourceRouteOutput(p, header, idev == m_lo, ucb)) {
+		return true;
+	}
+
 	// Deferred route request
 	if (EnableBuffering == true && idev == m_lo) {
 		DeferredRouteOutputTag tag;
@@ -341,6 +560,11 @@ bool RoutingProtocol::RouteInput(Ptr<const Packet> p, const Ipv6Header &header,
 			return true;
 		}
 	}
+	// Our packets, looped back by RouteOutput to receive the RPL option
+	if (idev == m_lo && m_ipv6->GetInterfaceForAddress(dst) < 0
+			&& UnicastForward(p, header, true, ucb, ecb)) {
+		return true;
+	}
 	for (std::map<Ptr<Socket>, Ipv6InterfaceAddress>::const_iterator j =
 			m_socketAddresses.begin(); j != m_socketAddresses.end(); ++j) {
 		Ipv6InterfaceAddress iface = j->second;
@@ -388,23 +612,122 @@ bool RoutingProtocol::RouteInput(Ptr<const Packet> p, const Ipv6Header &header,
 		}
 		return true;
 	}
-	RoutingTableEntry toDst;
-	if (m_routingTable.LookupRoute(dst, toDst)) {
-		RoutingTableEntry ne;
-		if (m_routingTable.LookupRoute(toDst.GetNextHop(), ne)) {
-			Ptr<Ipv6Route> route = ne.GetRoute();
-			NS_LOG_LOGIC (m_mainAddress << " is forwarding packet " << p->GetUid ()
-					<< " to " << dst
-					<< " from " << header.GetSourceAddress()
-					<< " via nexthop neighbor " << toDst.GetNextHop ());
-			ucb(route, p, header);
-			return true;
-		}
-	}NS_LOG_LOGIC ("Drop packet " << p->GetUid ()
+	if (UnicastForward(p, header, false, ucb, ecb)) {
+		return true;
+	}
+	NS_LOG_LOGIC ("Drop packet " << p->GetUid ()
 			<< " as there is no route to forward it.");
 	return false;
 }
 
+bool RoutingProtocol::UnicastForward(Ptr<const Packet> p,
+		const Ipv6Header & header, bool looped, UnicastForwardCallback ucb,
+		ErrorCallback ecb) {
+	Ipv6Address dst = header.GetDestinationAddress();
+	Ptr<Ipv6Route> route = m_daoRoutingTable.LookupRoute(dst);
+	bool down = route != 0;
+	if (route == 0) {
+		route = m_routingTable.LookupResolvedRoute(dst);
+	}
+	if (route == 0) {
+		return false;
+	}
+	Ptr<Packet> packet = p->Copy();
+	Ipv6Header forward = header;
+	if (looped) {
+		// compensate extra TTL decrement by fake loopback routing
+		forward.SetHopLimit(header.GetHopLimit() + 1);
+	}
+	if (!RplOptionForward(packet, forward, route, down)) {
+		NS_LOG_LOGIC ("Drop packet " << p->GetUid ()
+				<< " on an error of its RPL option");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return true;
+	}
+	NS_LOG_LOGIC (m_mainAddress << " is forwarding packet " << p->GetUid ()
+			<< " to " << dst
+			<< " from " << header.GetSourceAddress()
+			<< " via nexthop neighbor " << route->GetGateway ());
+	SetNextHop(packet, route->GetGateway());
+	ucb(route, packet, forward);
+	return true;
+}
+
+void RoutingProtocol::SetNextHop(Ptr<Packet> packet, Ipv6Address nextHop) {
+	PreviousHopTag previous;
+	packet->RemovePacketTag(previous);
+	packet->AddPacketTag(PreviousHopTag(m_mainAddress));
+	LinkEstimator::SetNextHop(packet, nextHop);
+}
+
+bool RoutingProtocol::IsDodagRoute(Ptr<Ipv6Route> route, bool down) const {
+	rpl_instance_t *instance = default_instance;
+	if (instance == NULL || instance->current_dag == NULL
+			|| !instance->current_dag->joined) {
+		return false;
+	}
+	if (down) {
+		return true;
+	}
+	rpl_parent_t *parent = instance->current_dag->preferred_parent;
+	return parent != NULL && route->GetGateway() == parent->addr;
+}
+
+bool RoutingProtocol::HasRplOption(Ptr<const Packet> p,
+		const Ipv6Header & header) {
+	uint8_t buf[4];
+	return header.GetNextHeader() == Ipv6Header::IPV6_EXT_HOP_BY_HOP
+			&& p->CopyData(buf, 4) == 4 && buf[1] == 0
+			&& buf[2] == RPL_HDR_OPT_TYPE && buf[3] == RPL_HDR_OPT_LEN;
+}
+
+bool RoutingProtocol::RplOptionForward(Ptr<Packet> packet,
+		Ipv6Header & header, Ptr<Ipv6Route> & route, bool down) {
+	bool present = HasRplOption(packet, header);
+	if (!IsDodagRoute(route, down)) {
+		// the packet leaves the DODAG, or is sent to a neighbor
+		if (present) {
+			rpl_remove_header(packet, header);
+		}
+		return true;
+	}
+
+	// only the 8 octets of the option are edited, the rest of the packet
+	// and its IPv6 header are left alone
+	RplHopByHopHeader option;
+	PreviousHopTag previous;
+	bool known = packet->PeekPacketTag(previous)
+			&& previous.sender != Ipv6Address::GetAny();
+	Ipv6Address from = previous.sender;
+	if (present) {
+		packet->RemoveHeader(option);
+		if (rpl_verify_header(option, header.GetDestinationAddress(),
+				known ? from : Ipv6Address::GetAny())) {
+			return false;
+		}
+	} else {
+#if RPL_INSERT_HBH_OPTION
+		if (rpl_update_header_empty(option, header)) {
+			return true;
+		}
+#else
+		return true;
+#endif /* RPL_INSERT_HBH_OPTION */
+	}
+	int error = rpl_update_header_final(option, down);
+	if (error == 0 && (option.GetFlags() & RPL_HDR_OPT_FWD_ERR)) {
+		/* Send the packet back to the node that sent it down, whose route
+		 is stale (section 11.2.2.3). */
+		if (!known) {
+			NS_LOG_DEBUG ("RPL: Forwarding error, the sender is unknown");
+			return false;
+		}
+		route = NeighborRoute(from);
+	}
+	packet->AddHeader(option);
+	return error == 0;
+}
+
 Ptr<Ipv6Route> RoutingProtocol::LoopbackRoute(const Ipv6Header & hdr,
 		Ptr<NetDevice> oif) const {
 	NS_ASSERT(m_lo != 0);
@@ -451,7 +774,6 @@ Ptr<Ipv6Route> RoutingProtocol::LoopbackRoute(const Ipv6Header & hdr,
 
 void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 	Address sourceAddress;
-	Ptr<Packet> advpacket = Create<Packet>();
 	Ptr<Packet> packet = socket->RecvFrom(sourceAddress);
 	Inet6SocketAddress inetSourceAddr = Inet6SocketAddress::ConvertFrom(
 			sourceAddress);
@@ -459,14 +781,18 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 	Ipv6Address receiver = m_socketAddresses[socket].GetAddress();
 	Ptr<NetDevice> dev = m_ipv6->GetNetDevice(
 			m_ipv6->GetInterfaceForAddress(receiver));
-	uint32_t packetSize = packet->GetSize();
-	NS_LOG_FUNCTION (m_mainAddress << " received rpl packet of size: " << packetSize
+	NS_LOG_FUNCTION (m_mainAddress << " received rpl packet of size: " << packet->GetSize ()
 			<< " and packet id: " << packet->GetUid ());
+	RplUpdateHeader update;
+	if (packet->RemoveHeader(update) == 0) {
+		NS_LOG_DEBUG ("Discarding a malformed update from " << sender);
+		return;
+	}
 	uint32_t count = 0;
-	for (; packetSize > 0; packetSize = packetSize - 12) {
+	for (std::vector<RplHeader>::const_iterator r = update.GetRecords().begin();
+			r != update.GetRecords().end(); ++r) {
 		count = 0;
-		RplHeader rplHeader, temprplHeader;
-		packet->RemoveHeader(rplHeader);
+		RplHeader const & rplHeader = *r;
 		NS_LOG_DEBUG ("Processing new update for " << rplHeader.GetDst ());
 		/*Verifying if the packets sent by me were returned back to me. If yes, discarding them!*/
 		for (std::map<Ptr<Socket>, Ipv6InterfaceAddress>::const_iterator j =
@@ -490,7 +816,6 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 				<< sender << " to " << receiver << ". Details are: Destination: " << rplHeader.GetDst () << ", Seq No: "
 				<< rplHeader.GetDstSeqno () << ", HopCount: " << rplHeader.GetHopCount ());
 		RoutingTableEntry fwdTableEntry, advTableEntry;
-		EventId event;
 		bool permanentTableVerifier = m_routingTable.LookupRoute(
 				rplHeader.GetDst(), fwdTableEntry);
 		if (permanentTableVerifier == false) {
@@ -519,13 +844,6 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 		} else {
 			if (!m_advRoutingTable.LookupRoute(rplHeader.GetDst(),
 					advTableEntry)) {
-				RoutingTableEntry tr;
-				std::map<Ipv6Address, RoutingTableEntry> allRoutes;
-				m_advRoutingTable.GetListOfAllRoutes(allRoutes);
-				for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator i =
-						allRoutes.begin(); i != allRoutes.end(); ++i) {
-					NS_LOG_DEBUG ("ADV table routes are:" << i->second.GetDestination ());
-				}
 				// present in fwd table and not in advtable
 				m_advRoutingTable.AddRoute(fwdTableEntry);
 				m_advRoutingTable.LookupRoute(rplHeader.GetDst(),
@@ -534,8 +852,7 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 			if (rplHeader.GetDstSeqno() % 2 != 1) {
 				if (rplHeader.GetDstSeqno() > advTableEntry.GetSeqNo()) {
 					// Received update with better seq number. Clear any old events that are running
-					if (m_advRoutingTable.ForceDeleteIpv6Event(
-							rplHeader.GetDst())) {
+					if (m_settlingWheel.Cancel(rplHeader.GetDst())) {
 						NS_LOG_DEBUG ("Canceling the timer to update route with better seq number");
 					}
 					// if its a changed metric *nomatter* where the update came from, wait  for WST
@@ -552,11 +869,8 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 						advTableEntry.SetSettlingTime(tempSettlingtime);
 						NS_LOG_DEBUG ("Added Settling Time:" << tempSettlingtime.GetSeconds ()
 								<< "s as there is no event running for this route");
-						event = Simulator::Schedule(tempSettlingtime,
-								&RoutingProtocol::SendTriggeredUpdate, this);
-						m_advRoutingTable.AddIpv6Event(rplHeader.GetDst(),
-								event);
-						NS_LOG_DEBUG ("EventCreated EventUID: " << event.GetUid ());
+						m_settlingWheel.Schedule(rplHeader.GetDst(),
+								tempSettlingtime);
 						// if received changed metric, use it but adv it only after wst
 						m_routingTable.Update(advTableEntry);
 						m_advRoutingTable.Update(advTableEntry);
@@ -579,8 +893,7 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 						 */
 						NS_LOG_DEBUG ("Canceling any existing timer to update route with same sequence number "
 								"and better hop count");
-						m_advRoutingTable.ForceDeleteIpv6Event(
-								rplHeader.GetDst());
+						m_settlingWheel.Cancel(rplHeader.GetDst());
 						advTableEntry.SetSeqNo(rplHeader.GetDstSeqno());
 						advTableEntry.SetLifeTime(Simulator::Now());
 						advTableEntry.SetFlag(VALID);
@@ -592,11 +905,8 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 						advTableEntry.SetSettlingTime(tempSettlingtime);
 						NS_LOG_DEBUG ("Added Settling Time," << tempSettlingtime.GetSeconds ()
 								<< " as there is no current event running for this route");
-						event = Simulator::Schedule(tempSettlingtime,
-								&RoutingProtocol::SendTriggeredUpdate, this);
-						m_advRoutingTable.AddIpv6Event(rplHeader.GetDst(),
-								event);
-						NS_LOG_DEBUG ("EventCreated EventUID: " << event.GetUid ());
+						m_settlingWheel.Schedule(rplHeader.GetDst(),
+								tempSettlingtime);
 						// if received changed metric, use it but adv it only after wst
 						m_routingTable.Update(advTableEntry);
 						m_advRoutingTable.Update(advTableEntry);
@@ -604,7 +914,7 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 						/*Received update with same seq number but with same or greater hop count.
 						 * Discard that update.
 						 */
-						if (not m_advRoutingTable.AnyRunningEvent(
+						if (not m_settlingWheel.IsPending(
 								rplHeader.GetDst())) {
 							/*update the timer only if nexthop address matches thus discarding
 							 * updates to that destination from other nodes.
@@ -619,7 +929,7 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 					}
 				} else {
 					// Received update with an old sequence number. Discard the update
-					if (not m_advRoutingTable.AnyRunningEvent(
+					if (not m_settlingWheel.IsPending(
 							rplHeader.GetDst())) {
 						m_advRoutingTable.DeleteRoute(rplHeader.GetDst());
 					}NS_LOG_DEBUG (rplHeader.GetDst () << " : Received update with old seq number. Discarding the update.");
@@ -646,7 +956,7 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 						m_routingTable.DeleteRoute(i->second.GetDestination());
 					}
 				} else {
-					if (not m_advRoutingTable.AnyRunningEvent(
+					if (not m_settlingWheel.IsPending(
 							rplHeader.GetDst())) {
 						m_advRoutingTable.DeleteRoute(rplHeader.GetDst());
 					}NS_LOG_DEBUG (rplHeader.GetDst () <<
@@ -656,9 +966,9 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 			}
 		}
 	}
-	std::map<Ipv6Address, RoutingTableEntry> allRoutes;
-	m_advRoutingTable.GetListOfAllRoutes(allRoutes);
-	if (EnableRouteAggregation && allRoutes.size() > 0) {
+	ScheduleRouteExpiry();
+	if (EnableRouteAggregation
+			&& m_advRoutingTable.Begin() != m_advRoutingTable.End()) {
 		Simulator::Schedule(m_routeAggregationTime,
 				&RoutingProtocol::SendTriggeredUpdate, this);
 	} else {
@@ -668,123 +978,195 @@ void RoutingProtocol::Recvrpl(Ptr<Socket> socket) {
 	}
 }
 
+void RoutingProtocol::PurgeExpiredRoutes() {
+	NS_LOG_FUNCTION (this);
+	std::map<Ipv6Address, RoutingTableEntry> removedAddresses;
+	m_routingTable.Purge(removedAddresses);
+	for (std::map<Ipv6Address, RoutingTableEntry>::iterator rmItr =
+			removedAddresses.begin(); rmItr != removedAddresses.end();
+			++rmItr) {
+		rmItr->second.SetEntriesChanged(true);
+		rmItr->second.SetSeqNo(rmItr->second.GetSeqNo() + 1);
+		m_advRoutingTable.AddRoute(rmItr->second);
+	}
+	if (!removedAddresses.empty()) {
+		Simulator::Schedule(
+				MicroSeconds(m_uniformRandomVariable->GetInteger(0, 1000)),
+				&RoutingProtocol::SendTriggeredUpdate, this);
+	}
+	ScheduleRouteExpiry();
+}
+
+void RoutingProtocol::PurgeExpiredDaoRoutes() {
+	NS_LOG_FUNCTION (this);
+	std::vector<DaoRoutingTableEntry> removed;
+	m_daoRoutingTable.Purge(removed);
+	m_sourceRoutingTable.Purge();
+	for (std::vector<DaoRoutingTableEntry>::const_iterator i = removed.begin();
+			i != removed.end(); ++i) {
+		if (i->GetPrefixLength() < 128) {
+			m_routingTable.DeleteRoute(i->GetTarget(), i->GetPrefixLength());
+		}
+	}
+	ScheduleDaoExpiry();
+}
+
+void RoutingProtocol::ScheduleDaoExpiry() {
+	Time expiry, parentExpiry;
+	bool routes = m_daoRoutingTable.GetNextExpiry(expiry);
+	bool parents = m_sourceRoutingTable.GetNextExpiry(parentExpiry);
+	if (!routes && !parents) {
+		return;
+	}
+	if (!routes || (parents && parentExpiry < expiry)) {
+		expiry = parentExpiry;
+	}
+	Time delay = expiry - Simulator::Now();
+	if (delay < Seconds(0)) {
+		delay = Seconds(0);
+	}
+	if (m_daoExpiryTimer.IsRunning()) {
+		if (m_daoExpiryTimer.GetDelayLeft() <= delay) {
+			return;
+		}
+		m_daoExpiryTimer.Cancel();
+	}
+	m_daoExpiryTimer.Schedule(delay);
+}
+
+void RoutingProtocol::ScheduleRouteExpiry() {
+	Time expiry;
+	if (!m_routingTable.GetNextExpiry(expiry)) {
+		return;
+	}
+	Time delay = expiry - Simulator::Now();
+	if (delay < Seconds(0)) {
+		delay = Seconds(0);
+	}
+	if (m_routeExpiryTimer.IsRunning()) {
+		if (m_routeExpiryTimer.GetDelayLeft() <= delay) {
+			return;
+		}
+		m_routeExpiryTimer.Cancel();
+	}
+	m_routeExpiryTimer.Schedule(delay);
+}
+
 void RoutingProtocol::SendTriggeredUpdate() {
 	NS_LOG_FUNCTION (m_mainAddress << " is sending a triggered update");
-	std::map<Ipv6Address, RoutingTableEntry> allRoutes;
-	m_advRoutingTable.GetListOfAllRoutes(allRoutes);
+	RplHeader rplHeader;
+	RplUpdateHeader update;
+	/* The changed routes leave the advertised table as they are added to the
+	 update, which every interface sends. */
+	for (RoutingTable::ChangedIterator i = m_advRoutingTable.BeginChanged();
+			i != m_advRoutingTable.EndChanged();) {
+		RoutingTableEntry temp = *i;
+		++i;
+		NS_LOG_LOGIC ("Destination: " << temp.GetDestination ()
+				<< " SeqNo:" << temp.GetSeqNo () << " HopCount:"
+				<< temp.GetHop () + 1);
+		if (m_settlingWheel.IsPending(temp.GetDestination())) {
+			NS_LOG_DEBUG ("Settling time of " << temp.GetDestination ()
+					<< " has not expired, waiting in adv table");
+			continue;
+		}
+		rplHeader.SetDst(temp.GetDestination());
+		rplHeader.SetDstSeqno(temp.GetSeqNo());
+		rplHeader.SetHopCount(temp.GetHop() + 1);
+		temp.SetFlag(VALID);
+		temp.SetEntriesChanged(false);
+		if (!(temp.GetSeqNo() % 2)) {
+			m_routingTable.Update(temp);
+		}
+		update.AddRecord(rplHeader);
+		m_advRoutingTable.DeleteRoute(temp.GetDestination());
+		NS_LOG_DEBUG ("Deleted this route from the advertised table");
+	}
+	if (update.GetNRecords() == 0) {
+		NS_LOG_FUNCTION ("Update not sent as there are no updates to be triggered");
+		return;
+	}
+	RoutingTableEntry temp2;
+	m_routingTable.LookupRoute(m_ipv6->GetAddress(1, 0).GetAddress(), temp2);
+	rplHeader.SetDst(m_ipv6->GetAddress(1, 0).GetAddress());
+	rplHeader.SetDstSeqno(temp2.GetSeqNo());
+	rplHeader.SetHopCount(temp2.GetHop() + 1);
+	NS_LOG_DEBUG ("Adding my update as well to the packet");
+	update.AddRecord(rplHeader);
 	for (std::map<Ptr<Socket>, Ipv6InterfaceAddress>::const_iterator j =
 			m_socketAddresses.begin(); j != m_socketAddresses.end(); ++j) {
-		RplHeader rplHeader;
 		Ptr<Socket> socket = j->first;
 		Ipv6InterfaceAddress iface = j->second;
 		Ptr<Packet> packet = Create<Packet>();
-		for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator i =
-				allRoutes.begin(); i != allRoutes.end(); ++i) {
-			NS_LOG_LOGIC ("Destination: " << i->second.GetDestination ()
-					<< " SeqNo:" << i->second.GetSeqNo () << " HopCount:"
-					<< i->second.GetHop () + 1);
-			RoutingTableEntry temp = i->second;
-			if ((i->second.GetEntriesChanged() == true)
-					&& (not m_advRoutingTable.AnyRunningEvent(
-							temp.GetDestination()))) {
-				rplHeader.SetDst(i->second.GetDestination());
-				rplHeader.SetDstSeqno(i->second.GetSeqNo());
-				rplHeader.SetHopCount(i->second.GetHop() + 1);
-				temp.SetFlag(VALID);
-				temp.SetEntriesChanged(false);
-				m_advRoutingTable.DeleteIpv6Event(temp.GetDestination());
-				if (!(temp.GetSeqNo() % 2)) {
-					m_routingTable.Update(temp);
-				}
-				packet->AddHeader(rplHeader);
-				m_advRoutingTable.DeleteRoute(temp.GetDestination());
-				NS_LOG_DEBUG ("Deleted this route from the advertised table");
-			} else {
-				EventId event = m_advRoutingTable.GetEventId(
-						temp.GetDestination());
-				NS_ASSERT(event.GetUid () != 0);
-				NS_LOG_DEBUG ("EventID " << event.GetUid () << " associated with "
-						<< temp.GetDestination () << " has not expired, waiting in adv table");
-			}
-		}
-		if (packet->GetSize() >= 12) {
-			RoutingTableEntry temp2;
-			m_routingTable.LookupRoute(m_ipv6->GetAddress(1, 0).GetAddress(),
-					temp2);
-			rplHeader.SetDst(m_ipv6->GetAddress(1, 0).GetAddress());
-			rplHeader.SetDstSeqno(temp2.GetSeqNo());
-			rplHeader.SetHopCount(temp2.GetHop() + 1);
-			NS_LOG_DEBUG ("Adding my update as well to the packet");
-			packet->AddHeader(rplHeader);
-			// Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-			Ipv6Address destination;
-			if (iface.GetPrefix() == Ipv6Prefix::GetOnes()) {
-				destination = Ipv6Address("255.255.255.255");
-			} else {
-				destination = iface.GetAddress();
-			}
-			socket->SendTo(packet, 0,
-					Inet6SocketAddress(destination, RPL_PORT));
-			NS_LOG_FUNCTION ("Sent Triggered Update from "
-					<< rplHeader.GetDst ()
-					<< " with packet id : " << packet->GetUid () << " and packet Size: " << packet->GetSize ());
+		packet->AddHeader(update);
+		// Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
+		Ipv6Address destination;
+		if (iface.GetPrefix() == Ipv6Prefix::GetOnes()) {
+			destination = Ipv6Address("255.255.255.255");
 		} else {
-			NS_LOG_FUNCTION ("Update not sent as there are no updates to be triggered");
+			destination = iface.GetAddress();
 		}
+		socket->SendTo(packet, 0, Inet6SocketAddress(destination, RPL_PORT));
+		NS_LOG_FUNCTION ("Sent Triggered Update from "
+				<< rplHeader.GetDst ()
+				<< " with packet id : " << packet->GetUid () << " and packet Size: " << packet->GetSize ());
 	}
 }
 
 void RoutingProtocol::SendPeriodicUpdate() {
-	std::map<Ipv6Address, RoutingTableEntry> removedAddresses, allRoutes;
+	std::map<Ipv6Address, RoutingTableEntry> removedAddresses;
 	m_routingTable.Purge(removedAddresses); // Purge = clean
 	MergeTriggerPeriodicUpdates();
-	m_routingTable.GetListOfAllRoutes(allRoutes);
-	if (allRoutes.empty()) {
+	if (m_routingTable.Begin() == m_routingTable.End()) {
 		return;
 	}NS_LOG_FUNCTION (m_mainAddress << " is sending out its periodic update");
 
+	/* The update is built once from the table itself, then sent on every
+	 interface. */
+	RplUpdateHeader update;
+	for (RoutingTable::ConstIterator i = m_routingTable.Begin();
+			i != m_routingTable.End(); ++i) {
+		RplHeader rplHeader;
+		if (i->GetHop() == 0) {
+			RoutingTableEntry ownEntry;
+			rplHeader.SetDst(m_ipv6->GetAddress(1, 0).GetAddress());
+			rplHeader.SetDstSeqno(i->GetSeqNo() + 2);
+			rplHeader.SetHopCount(i->GetHop() + 1);
+			m_routingTable.LookupRoute(m_ipv6->GetAddress(1, 0).GetAddress(),
+					ownEntry);
+			ownEntry.SetSeqNo(rplHeader.GetDstSeqno());
+			m_routingTable.Update(ownEntry);
+		} else {
+			rplHeader.SetDst(i->GetDestination());
+			rplHeader.SetDstSeqno((i->GetSeqNo()));
+			rplHeader.SetHopCount(i->GetHop() + 1);
+		}
+		update.AddRecord(rplHeader);
+		NS_LOG_DEBUG ("Forwarding the update for " << i->GetDestination ());
+		NS_LOG_DEBUG ("Forwarding details are, Destination: " << rplHeader.GetDst ()
+				<< ", SeqNo:" << rplHeader.GetDstSeqno ()
+				<< ", HopCount:" << rplHeader.GetHopCount ()
+				<< ", LifeTime: " << i->GetLifeTime ().GetSeconds ());
+	}
+	for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator rmItr =
+			removedAddresses.begin(); rmItr != removedAddresses.end();
+			++rmItr) {
+		RplHeader removedHeader;
+		removedHeader.SetDst(rmItr->second.GetDestination());
+		removedHeader.SetDstSeqno(rmItr->second.GetSeqNo() + 1);
+		removedHeader.SetHopCount(rmItr->second.GetHop() + 1);
+		update.AddRecord(removedHeader);
+		NS_LOG_DEBUG ("Update for removed record is: Destination: " << removedHeader.GetDst ()
+				<< " SeqNo:" << removedHeader.GetDstSeqno ()
+				<< " HopCount:" << removedHeader.GetHopCount ());
+	}
+
 	for (std::map<Ptr<Socket>, Ipv6InterfaceAddress>::const_iterator j =
 			m_socketAddresses.begin(); j != m_socketAddresses.end(); ++j) {
 		Ptr<Socket> socket = j->first;
 		Ipv6InterfaceAddress iface = j->second;
 		Ptr<Packet> packet = Create<Packet>();
-		for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator i =
-				allRoutes.begin(); i != allRoutes.end(); ++i) {
-			RplHeader rplHeader;
-			if (i->second.GetHop() == 0) {
-				RoutingTableEntry ownEntry;
-				rplHeader.SetDst(m_ipv6->GetAddress(1, 0).GetAddress());
-				rplHeader.SetDstSeqno(i->second.GetSeqNo() + 2);
-				rplHeader.SetHopCount(i->second.GetHop() + 1);
-				m_routingTable.LookupRoute(
-						m_ipv6->GetAddress(1, 0).GetAddress(), ownEntry);
-				ownEntry.SetSeqNo(rplHeader.GetDstSeqno());
-				m_routingTable.Update(ownEntry);
-				packet->AddHeader(rplHeader);
-			} else {
-				rplHeader.SetDst(i->second.GetDestination());
-				rplHeader.SetDstSeqno((i->second.GetSeqNo()));
-				rplHeader.SetHopCount(i->second.GetHop() + 1);
-				packet->AddHeader(rplHeader);
-			}
-			NS_LOG_DEBUG ("Forwarding the update for " << i->first);
-			NS_LOG_DEBUG ("Forwarding details are, Destination: " << rplHeader.GetDst ()
-					<< ", SeqNo:" << rplHeader.GetDstSeqno ()
-					<< ", HopCount:" << rplHeader.GetHopCount ()
-					<< ", LifeTime: " << i->second.GetLifeTime ().GetSeconds ());
-		}
-		for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator rmItr =
-				removedAddresses.begin(); rmItr != removedAddresses.end();
-				++rmItr) {
-			RplHeader removedHeader;
-			removedHeader.SetDst(rmItr->second.GetDestination());
-			removedHeader.SetDstSeqno(rmItr->second.GetSeqNo() + 1);
-			removedHeader.SetHopCount(rmItr->second.GetHop() + 1);
-			packet->AddHeader(removedHeader);
-			NS_LOG_DEBUG ("Update for removed record is: Destination: " << removedHeader.GetDst ()
-					<< " SeqNo:" << removedHeader.GetDstSeqno ()
-					<< " HopCount:" << removedHeader.GetHopCount ());
-		}
+		packet->AddHeader(update);
 		socket->Send(packet);
 		// Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
 		Ipv6Address destination;
@@ -802,76 +1184,252 @@ void RoutingProtocol::SendPeriodicUpdate() {
 							25 * m_uniformRandomVariable->GetInteger(0, 1000)));
 }
 
-void RoutingProtocol::SendPeriodicDIOPacket(Ipv6Address src, Ipv6Address dst, Address* hardwareAddress, uint8_t flags, rpl_instance_t *instance) {
-	NS_LOG_FUNCTION (m_mainAddress << " is sending out its periodic update");
-
-	NS_LOG_FUNCTION (this << src << dst << hardwareAddress << static_cast<uint32_t> (flags));
+void RoutingProtocol::dio_output(rpl_instance_t *instance, Ipv6Address uc_addr) {
+	NS_LOG_FUNCTION (this << (uint32_t) instance->instance_id << uc_addr);
+	rpl_dag_t *dag = instance->current_dag;
 	Ptr<Packet> p = Create<Packet>();
-	Ptr<Address> addr =
-	Ipv6InterfaceAddress iface = this->;
 	DIOPacket dio;
+	Ipv6Address src = m_mainAddress;
+	Ipv6Address dst = uc_addr;
 
-	std::cout << "RPL: Sending Period DIO !!!" << std::endl;
-
-	dst = dst.GetAllNodesMulticast();
-	src = this->GetObject();
-//	src = Ipv6Address::GetAny ();
-	instance = default_instance;
-	std::cout << "Send DIO ( from " << src << " to " << dst << " target " << src << ")"<< std::endl;
-	dio.SetIpv6Target(Ipv6Address::GetAllNodesMulticast());
-
-	if ((flags & 1)) {
-		dio.SetFlagO(true);
+	/* Unicast requests get unicast replies! */
+	if (dst == Ipv6Address::GetAny()) {
+		dst = Ipv6Address::GetAllNodesMulticast();
 	}
-	if ((flags & 2) && src != Ipv6Address::GetAny()) {
-		dio.SetFlagS(true);
+
+#if RPL_LEAF_ONLY
+	/* In leaf mode, we only send DIO messages as unicasts in response to
+	 unicast DIS messages. */
+	if (dst.IsMulticast()) {
+		return;
 	}
-	if ((flags & 4)) {
-		dio.SetFlagR(true);
+#endif /* RPL_LEAF_ONLY */
+
+	rpl_dio_t info = rpl_dio_t();
+	info.instance_id = instance->instance_id;
+	info.version = dag->version;
+	info.rank = dag->rank;
+	info.grounded = dag->grounded;
+	info.mop = instance->mop;
+	info.preference = dag->preference;
+	info.dtsn = instance->dtsn_out;
+	info.dag_id = dag->dag_id;
+	info.dag_intdoubl = instance->dio_intdoubl;
+	info.dag_intmin = instance->dio_intmin;
+	info.dag_redund = instance->dio_redundancy;
+	info.dag_max_rankinc = instance->max_rankinc;
+	info.dag_min_hoprankinc = instance->min_hoprankinc;
+	/* OCP is in the DAG_CONF option */
+	info.ocp = instance->of != NULL ? instance->of->ocp : 0;
+	info.default_lifetime = instance->default_lifetime;
+	info.lifetime_unit = instance->lifetime_unit;
+	info.prefix_info = dag->prefix_info;
+	if (instance->mc.type != RPL_DAG_MC_NONE) {
+		instance->of->update_metric_container(instance);
+		info.mc = instance->mc;
 	}
+	dio.SetDio(info);
+
+	/* The DTSN only moves on a repair, a parent switch or a new DTSN of
+	 the preferred parent: advertising it again requests no new DAOs. The
+	 children refresh their routes on their own DAO timer. */
 
 	dio.CalculatePseudoHeaderChecksum(src, dst,
 			p->GetSize() + dio.GetSerializedSize(), 58);
-
-	dio.m_instance = this->default_instance;
-	dio.m_dag = this->m_dag;
-
 	p->AddHeader(dio);
 
-	std::cout << "RPL: Finish adding DIO Header" << std::endl;
+	if (dst.IsMulticast()) {
+		NS_LOG_DEBUG ("RPL: Sending a multicast-DIO with rank " << dag->rank);
+		/* The nodes waiting for a reply to their DIS receive this DIO. */
+		cancel_dis_replies(instance->instance_id);
+		RPLSend(p, src, dst, 255);
+	} else {
+		NS_LOG_DEBUG ("RPL: Sending unicast-DIO with rank " << dag->rank
+				<< " to " << dst);
+		RPLSend(p, src, dst, 255, NeighborRoute(dst));
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::dis_input(Ipv6Address from, Ptr<Packet> packet,
+		bool multicast) {
+	DISPacket dis;
+	rpl_instance_t *instance, *end;
+	DisReplyMap::key_type key;
 
-	m_periodicUpdateTimer.Schedule(
-				m_periodicUpdateInterval
-						+ Seconds(
-								m_uniformRandomVariable->GetInteger(10, 12)));
+	packet->RemoveHeader(dis);
+	NS_LOG_DEBUG ("RPL: Received a " << (multicast ? "multicast" : "unicast")
+			<< " DIS from " << from);
 
-	/* Unicast requests get unicast replies! */
-	if (dst.IsAllNodesMulticast()) {
-		std::cout << "RPL: Sending a multicast-DIO with rank = "
-				<< (unsigned) instance->current_dag->rank << std::endl;
+	for (instance = &instance_table[0], end = instance + instance_table.size();
+			instance < end; ++instance) {
+		if (!instance->used || instance->current_dag == NULL
+				|| !instance->current_dag->joined) {
+			continue;
+		}
+		if (!multicast) {
+			/* A unicast DIS asks this node only, reply at once. */
+			dio_output(instance, from);
+			continue;
+		}
+#if RPL_LEAF_ONLY
+		NS_LOG_DEBUG ("RPL: LEAF ONLY Multicast DIS will NOT reset DIO timer");
+#else /* !RPL_LEAF_ONLY */
+		if (instance->dio_redundancy != 0
+				&& instance->dio_counter >= instance->dio_redundancy) {
+			/* Enough neighbors advertise the DAG: let Trickle elect the
+			 few of them that answer with a multicast DIO. */
+			NS_LOG_DEBUG ("RPL: Multicast DIS reset DIO timer");
+			rpl_reset_dio_timer(instance);
+			continue;
+		}
+		key = std::make_pair(instance->instance_id, from);
+		if (m_disReplies.find(key) != m_disReplies.end()) {
+			NS_LOG_DEBUG ("RPL: DIS from " << from << " already answered");
+			continue;
+		}
+		m_disReplies[key] = Simulator::Schedule(
+				MilliSeconds(m_uniformRandomVariable->GetInteger(0,
+						RPL_DIS_REPLY_DELAY)), &RoutingProtocol::dis_reply,
+				this, instance->instance_id, from);
+#endif /* !RPL_LEAF_ONLY */
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::dis_reply(uint8_t instance_id, Ipv6Address to) {
+	rpl_instance_t *instance;
 
-//		uip_create_linklocal_rplnodes_mcast(&addr);
-		//uip_icmp6_send(&addr, ICMP6_RPL, RPL_CODE_DIO, pos);
-		RPLSend(p, src, dst, 255);
+	m_disReplies.erase(std::make_pair(instance_id, to));
+	instance = rpl_get_instance(instance_id);
+	if (instance == NULL || instance->current_dag == NULL
+			|| !instance->current_dag->joined) {
+		return;
+	}
+	dio_output(instance, to);
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::cancel_dis_replies(uint8_t instance_id) {
+	DisReplyMap::iterator i;
+
+	for (i = m_disReplies.begin(); i != m_disReplies.end();) {
+		if (i->first.first == instance_id) {
+			i->second.Cancel();
+			m_disReplies.erase(i++);
+		} else {
+			++i;
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::dis_output(Ipv6Address addr) {
+	Ptr<Packet> p = Create<Packet>();
+	Ptr<Ipv6Route> route;
+	DISPacket dis;
+	Ipv6Address dst = addr;
 
+	if (dst == Ipv6Address::GetAny()) {
+		dst = Ipv6Address::GetAllNodesMulticast();
 	} else {
-		NS_LOG_DEBUG (this << "RPL: Sending unicast-DIO with rank %u to " <<
-				(unsigned) instance->current_dag->rank);
-		NS_LOG_DEBUG (dst);
+		route = NeighborRoute(dst);
 	}
 
+	dis.CalculatePseudoHeaderChecksum(m_mainAddress, dst,
+			dis.GetSerializedSize(), 58);
+	p->AddHeader(dis);
 
+	NS_LOG_DEBUG ("RPL: Sending a DIS to " << dst);
+	RPLSend(p, m_mainAddress, dst, 255, route);
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::handle_dis_timer() {
+	if (rpl_get_any_dag() == NULL) {
+		dis_output(Ipv6Address::GetAny());
+	}
+	m_disTimer.Schedule(Seconds(RPL_DIS_INTERVAL));
 }
 
-void RoutingProtocol::SetIpv6(Ptr<Ipv6> ipv6) {
-	NS_ASSERT(ipv6 != 0);
-	NS_ASSERT(m_ipv6 == 0);
-	m_ipv6 = ipv6;
-	// Create lo route. It is asserted that the only one interface up for now is loopback
-//	NS_ASSERT(m_ipv6->GetNInterfaces () == 1 && m_ipv6->GetAddress (0, 0) == Ipv6Address ("fe80::1"));
-	m_lo = m_ipv6->GetNetDevice(0);
-	NS_ASSERT(m_lo != 0);
-	// Remember lo route
+void RoutingProtocol::dio_input(Ipv6Address from, Ipv6Address to,
+		Ptr<Packet> packet) {
+	DIOPacket dioHeader;
+	rpl_instance_t *instance;
+	rpl_dag_t *dag;
+
+	if (packet->RemoveHeader(dioHeader) == 0) {
+		RPL_STAT(rpl_stats.malformed_msgs++);
+		NS_LOG_DEBUG ("RPL: Discarding a malformed DIO from " << from);
+		return;
+	}
+	rpl_dio_t dio = dioHeader.GetDio();
+
+	NS_LOG_DEBUG ("RPL: Received a DIO from " << from << ", instance "
+			<< (uint32_t) dio.instance_id << ", version "
+			<< (uint32_t) dio.version << ", rank " << dio.rank);
+
+	/* A neighbor advertised our DAG to the nodes around us, among them
+	 those whose DIS we were about to answer: our replies would be
+	 redundant. */
+	instance = rpl_get_instance(dio.instance_id);
+	dag = instance != NULL ? instance->current_dag : NULL;
+	if (to.IsMulticast() && dag != NULL && dag->joined
+			&& dag->dag_id == dio.dag_id && dag->version == dio.version) {
+		cancel_dis_replies(dio.instance_id);
+	}
+
+	rpl_process_dio(from, &dio);
+}
+
+void RoutingProtocol::RecvRplControl(Ptr<Socket> socket) {
+	Address sourceAddress;
+	Ptr<Packet> packet = socket->RecvFrom(sourceAddress);
+	Ipv6Header ipHeader;
+	packet->RemoveHeader(ipHeader);
+	Ipv6Address from = ipHeader.GetSourceAddress();
+
+	/* Our own multicast DIOs are not of interest. */
+	for (std::map<Ptr<Socket>, Ipv6InterfaceAddress>::const_iterator j =
+			m_socketAddresses.begin(); j != m_socketAddresses.end(); ++j) {
+		if (from == j->second.GetAddress()) {
+			return;
+		}
+	}
+	if (from == m_mainAddress) {
+		return;
+	}
+
+	Icmpv6Header icmpHeader;
+	packet->PeekHeader(icmpHeader);
+	if (icmpHeader.GetType() != ICMP6_RPL) {
+		return;
+	}
+
+	switch (icmpHeader.GetCode()) {
+	case RPL_CODE_DIS:
+		dis_input(from, packet, ipHeader.GetDestinationAddress().IsMulticast());
+		break;
+	case RPL_CODE_DIO:
+		dio_input(from, ipHeader.GetDestinationAddress(), packet);
+		break;
+	case RPL_CODE_DAO:
+		dao_input(from, packet);
+		break;
+	case RPL_CODE_DAO_ACK:
+		dao_ack_input(from, packet);
+		break;
+	default:
+		NS_LOG_DEBUG ("RPL: received an unknown ICMP6 code ("
+				<< (uint32_t) icmpHeader.GetCode() << ")");
+		break;
+	}
+}
+
+void RoutingProtocol::SetIpv6(Ptr<Ipv6> ipv6) {
+	NS_ASSERT(ipv6 != 0);
+	NS_ASSERT(m_ipv6 == 0);
+	m_ipv6 = ipv6;
+	// Create lo route. It is asserted that the only one interface up for now is loopback
+//	NS_ASSERT(m_ipv6->GetNInterfaces () == 1 && m_ipv6->GetAddress (0, 0) == Ipv6Address ("fe80::1"));
+	m_lo = m_ipv6->GetNetDevice(0);
+	NS_ASSERT(m_lo != 0);
+	// Remember lo route
 	RoutingTableEntry rt(
 			/*device=*/m_lo,
 			/*dst=*/Ipv6Address::GetLoopback(),
@@ -907,6 +1465,9 @@ void RoutingProtocol::NotifyInterfaceUp(uint32_t i) {
 			/*lifetime=*/Simulator::GetMaximumSimulationTime()
 	);
 	m_routingTable.AddRoute(rt);
+	if (dev != m_lo) {
+		m_linkEstimator.Attach(dev);
+	}
 
 	if (m_mainAddress == Ipv6Address()) {
 		m_mainAddress = iface.GetAddress();
@@ -1020,7 +1581,8 @@ void RoutingProtocol::Send(Ptr<Ipv6Route> route, Ptr<const Packet> packet,
 			header.GetTrafficClass(), route);
 }
 
-void RoutingProtocol::RPLSend(Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, uint8_t ttl) {
+void RoutingProtocol::RPLSend(Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, uint8_t ttl,
+		Ptr<Ipv6Route> route) {
 
 	NS_LOG_DEBUG ("Send DIO " << packet );
 	Ptr<Ipv6L3Protocol> l3 = m_ipv6->GetObject<Ipv6L3Protocol>();
@@ -1030,9 +1592,140 @@ void RoutingProtocol::RPLSend(Ptr<Packet> packet, Ipv6Address src, Ipv6Address d
 
 	tag.SetTtl(ttl);
 	packet->AddPacketTag(tag);
-	Ptr<Packet> p = packet->Copy();
+	if (route != 0) {
+		SetNextHop(packet, route->GetGateway());
+	}
+	m_controlTxTrace(packet);
+
+	l3->Send(packet, src, dst, 58, route);
+}
+
+Ptr<Ipv6Route> RoutingProtocol::NeighborRoute(Ipv6Address neighbor) const {
+	int32_t interface = m_ipv6->GetInterfaceForAddress(m_mainAddress);
+	NS_ASSERT(interface >= 0);
+	Ptr<Ipv6Route> route = Create<Ipv6Route>();
+	route->SetDestination(neighbor);
+	route->SetGateway(neighbor);
+	route->SetSource(m_mainAddress);
+	route->SetOutputDevice(m_ipv6->GetNetDevice(interface));
+	return route;
+}
+
+bool RoutingProtocol::LookupSourceRoute(Ipv6Address dst,
+		std::vector<Ipv6Address> & hops) const {
+	rpl_instance_t *instance = default_instance;
+	if (instance == NULL || instance->mop != RPL_MOP_NON_STORING
+			|| instance->current_dag == NULL
+			|| instance->current_dag->rank != ROOT_RANK(instance)) {
+		return false;
+	}
+	return m_sourceRoutingTable.LookupRoute(m_mainAddress, dst, hops);
+}
+
+bool RoutingProtocol::SourceRouteOutput(Ptr<const Packet> p,
+		const Ipv6Header & header, bool looped, UnicastForwardCallback ucb) {
+	std::vector<Ipv6Address> hops;
+	if (!LookupSourceRoute(header.GetDestinationAddress(), hops)) {
+		return false;
+	}
+
+	Ptr<Packet> packet = p->Copy();
+	DeferredRouteOutputTag tag;
+	packet->RemovePacketTag(tag);
+	// compensate extra TTL decrement by fake loopback routing
+	uint8_t hopLimit = header.GetHopLimit() + (looped ? 1 : 0);
+	Ipv6Address first = hops.front();
+	Ptr<Ipv6Route> route = NeighborRoute(first);
+
+	SetNextHop(packet, first);
+	if (hops.size() == 1) {
+		// children of the root are reached without routing header
+		Ipv6Header direct = header;
+		direct.SetHopLimit(hopLimit);
+		ucb(route, packet, direct);
+		return true;
+	}
+
+	// IPv6-in-IPv6 from the root to the destination, through the hops
+	// listed by the routing header
+	hops.erase(hops.begin());
+	SourceRoutingHeader srh;
+	srh.SetNextHeader(Ipv6Header::IPV6_IPV6);
+	srh.SetRoute(first, hops);
+	packet->AddHeader(header);
+	packet->AddHeader(srh);
+
+	Ipv6Header outer;
+	outer.SetSourceAddress(m_mainAddress);
+	outer.SetDestinationAddress(first);
+	outer.SetNextHeader(Ipv6Header::IPV6_EXT_ROUTING);
+	outer.SetHopLimit(hopLimit);
+	outer.SetPayloadLength(packet->GetSize());
+	NS_LOG_LOGIC (m_mainAddress << " is source routing packet " << p->GetUid ()
+			<< " to " << header.GetDestinationAddress() << " via " << first
+			<< " and " << hops.size() << " more hops");
+	ucb(route, packet, outer);
+	return true;
+}
+
+void RoutingProtocol::ForwardSourceRoute(Ptr<const Packet> p,
+		const Ipv6Header & header, int32_t iif, UnicastForwardCallback ucb,
+		LocalDeliverCallback lcb, ErrorCallback ecb) {
+	Ptr<Packet> packet = p->Copy();
+	SourceRoutingHeader srh;
+	if (packet->RemoveHeader(srh) == 0) {
+		NS_LOG_DEBUG ("Truncated source routing header. Drop packet " << p->GetUid ());
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return;
+	}
+	Ipv6Address dst = header.GetDestinationAddress();
+
+	if (srh.GetSegmentsLeft() == 0) {
+		// last hop: deliver what the root encapsulated
+		if (srh.GetNextHeader() == Ipv6Header::IPV6_IPV6) {
+			Ipv6Header inner;
+			packet->RemoveHeader(inner);
+			lcb(packet, inner, iif);
+		} else {
+			Ipv6Header local = header;
+			local.SetNextHeader(srh.GetNextHeader());
+			local.SetPayloadLength(packet->GetSize());
+			lcb(packet, local, iif);
+		}
+		return;
+	}
 
-	l3->Send(packet, src, dst, 58, 0);
+	// RFC 6554, section 4.2
+	uint32_t n = srh.GetNAddresses();
+	if (srh.GetSegmentsLeft() > n) {
+		NS_LOG_DEBUG ("Malformed source routing header. Drop packet " << p->GetUid ());
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return;
+	}
+	srh.SetSegmentsLeft(srh.GetSegmentsLeft() - 1);
+	uint32_t i = n - srh.GetSegmentsLeft();
+	Ipv6Address next = srh.GetAddress(i, dst);
+	if (next.IsMulticast()) {
+		NS_LOG_DEBUG ("Multicast address in source route. Drop packet " << p->GetUid ());
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return;
+	}
+	// one of our addresses further in the route reveals a loop
+	for (uint32_t j = i + 1; j <= n; ++j) {
+		if (m_ipv6->GetInterfaceForAddress(srh.GetAddress(j, dst)) >= 0) {
+			NS_LOG_DEBUG ("Loop in source route. Drop packet " << p->GetUid ());
+			ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+			return;
+		}
+	}
+	packet->AddHeader(srh);
+
+	Ipv6Header outer = header;
+	outer.SetDestinationAddress(next);
+	NS_LOG_LOGIC (m_mainAddress << " is forwarding source routed packet "
+			<< p->GetUid () << " to " << next);
+	SetNextHop(packet, next);
+	ucb(NeighborRoute(next), packet, outer);
 }
 /*
 void Icmpv6L4Protocol::SendMessage (Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, uint8_t ttl)
@@ -1054,33 +1747,59 @@ void RoutingProtocol::Drop(Ptr<const Packet> packet, const Ipv6Header & header,
 			<< header.GetDestinationAddress() << " from queue. Error " << err);
 }
 
-void RoutingProtocol::LookForQueuedPackets() {
-	NS_LOG_FUNCTION (this);
-	Ptr<Ipv6Route> route;
-	std::map<Ipv6Address, RoutingTableEntry> allRoutes;
-	m_routingTable.GetListOfAllRoutes(allRoutes);
-	for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator i =
-			allRoutes.begin(); i != allRoutes.end(); ++i) {
-		RoutingTableEntry rt;
-		rt = i->second;
-		if (m_queue.Find(rt.GetDestination())) {
-			if (rt.GetHop() == 1) {
-				route = rt.GetRoute();
-				NS_LOG_LOGIC ("A route exists from " << route->GetSource ()
-						<< " to neighboring destination "
-						<< route->GetDestination ());
-				NS_ASSERT(route != 0);
-			} else {
-				RoutingTableEntry newrt;
-				m_routingTable.LookupRoute(rt.GetNextHop(), newrt);
-				route = newrt.GetRoute();
-				NS_LOG_LOGIC ("A route exists from " << route->GetSource ()
-						<< " to destination " << route->GetDestination () << " via "
-						<< rt.GetNextHop ());
-				NS_ASSERT(route != 0);
-			}
-			SendPacketFromQueue(rt.GetDestination(), route);
-		}
+void RoutingProtocol::HandleRouteArrival(Ipv6Address dst) {
+	if (EnableBuffering && m_queue.Find(dst)) {
+		NS_LOG_LOGIC ("Route to " << dst << " arrived, draining its queued packets");
+		ScheduleDrain(dst);
+	}
+}
+
+void RoutingProtocol::ScheduleDrain(Ipv6Address dst) {
+	if (!m_drainPending.insert(dst).second) {
+		return;
+	}
+	Simulator::Schedule(
+			MilliSeconds(m_uniformRandomVariable->GetInteger(0, 100)),
+			&RoutingProtocol::DrainQueue, this, dst);
+}
+
+void RoutingProtocol::DrainQueue(Ipv6Address dst) {
+	m_drainPending.erase(dst);
+	Ptr<Ipv6Route> route = m_daoRoutingTable.LookupRoute(dst);
+	if (route == 0) {
+		route = m_routingTable.LookupResolvedRoute(dst);
+	}
+	if (route == 0) {
+		NS_LOG_LOGIC ("Route to " << dst << " lost, its packets stay queued");
+		return;
+	}
+	NS_LOG_LOGIC ("A route exists from " << route->GetSource ()
+			<< " to destination " << dst << " via "
+			<< route->GetGateway ());
+	SendPacketFromQueue(dst, route);
+	if (m_queue.Find(dst)) {
+		ScheduleDrain(dst);
+	}
+}
+
+void RoutingProtocol::QueueDrop(QueueEntry const & entry,
+		PacketQueue::DropReason reason) {
+	switch (reason) {
+	case PacketQueue::DROP_REASON_TAIL:
+		m_queueDropTailTrace(entry.GetPacket(), entry.GetIpv6Header());
+		break;
+	case PacketQueue::DROP_REASON_HEAD:
+		m_queueDropHeadTrace(entry.GetPacket(), entry.GetIpv6Header());
+		break;
+	case PacketQueue::DROP_REASON_PRIORITY:
+		m_queueDropPriorityTrace(entry.GetPacket(), entry.GetIpv6Header());
+		break;
+	case PacketQueue::DROP_REASON_EXPIRED:
+		m_queueDropExpiredTrace(entry.GetPacket(), entry.GetIpv6Header());
+		break;
+	case PacketQueue::DROP_REASON_FLUSHED:
+		m_queueDropFlushedTrace(entry.GetPacket(), entry.GetIpv6Header());
+		break;
 	}
 }
 
@@ -1104,12 +1823,13 @@ void RoutingProtocol::SendPacketFromQueue(Ipv6Address dst,
 		Ipv6Header header = queueEntry.GetIpv6Header();
 		header.SetSourceAddress(route->GetSource());
 		header.SetHopLimit(header.GetHopLimit() + 1); // compensate extra TTL decrement by fake loopback routing
-		ucb(route, p, header);
-		if (m_queue.GetSize() != 0 && m_queue.Find(dst)) {
-			Simulator::Schedule(
-					MilliSeconds(m_uniformRandomVariable->GetInteger(0, 100)),
-					&RoutingProtocol::SendPacketFromQueue, this, dst, route);
+		bool down = m_daoRoutingTable.LookupRoute(dst) != 0;
+		if (!RplOptionForward(p, header, route, down)) {
+			NS_LOG_DEBUG ("RPL option error. Dropped.");
+			return;
 		}
+		SetNextHop(p, route->GetGateway());
+		ucb(route, p, header);
 	}
 }
 
@@ -1137,77 +1857,131 @@ Time RoutingProtocol::GetSettlingTime(Ipv6Address address) {
 
 void RoutingProtocol::MergeTriggerPeriodicUpdates() {
 	NS_LOG_FUNCTION ("Merging advertised table changes with main table before sending out periodic update");
-	std::map<Ipv6Address, RoutingTableEntry> allRoutes;
-	m_advRoutingTable.GetListOfAllRoutes(allRoutes);
-	if (allRoutes.size() > 0) {
-		for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator i =
-				allRoutes.begin(); i != allRoutes.end(); ++i) {
-			RoutingTableEntry advEntry = i->second;
-			if ((advEntry.GetEntriesChanged() == true)
-					&& (not m_advRoutingTable.AnyRunningEvent(
-							advEntry.GetDestination()))) {
-				if (!(advEntry.GetSeqNo() % 2)) {
-					advEntry.SetFlag(VALID);
-					advEntry.SetEntriesChanged(false);
-					m_routingTable.Update(advEntry);
-					NS_LOG_DEBUG ("Merged update for " << advEntry.GetDestination () << " with main routing Table");
-				}
-				m_advRoutingTable.DeleteRoute(advEntry.GetDestination());
-			} else {
-				NS_LOG_DEBUG ("Event currently running. Cannot Merge Routing Tables");
+	for (RoutingTable::ChangedIterator i = m_advRoutingTable.BeginChanged();
+			i != m_advRoutingTable.EndChanged();) {
+		RoutingTableEntry advEntry = *i;
+		++i;
+		if (not m_settlingWheel.IsPending(advEntry.GetDestination())) {
+			if (!(advEntry.GetSeqNo() % 2)) {
+				advEntry.SetFlag(VALID);
+				advEntry.SetEntriesChanged(false);
+				m_routingTable.Update(advEntry);
+				NS_LOG_DEBUG ("Merged update for " << advEntry.GetDestination () << " with main routing Table");
 			}
+			m_advRoutingTable.DeleteRoute(advEntry.GetDestination());
+		} else {
+			NS_LOG_DEBUG ("Event currently running. Cannot Merge Routing Tables");
 		}
 	}
 }
 
 /*----------Code from Contiki-----------------*/
 /*---------------------------------------------------------------------------*/
-rpl_instance_t *
-RoutingProtocol::rpl_get_instance(uint8_t instance_id) {
-	int i;
+/* Size the instance and DAG tables from the MaxInstances and
+ MaxDagsPerInstance attributes, once they are set. */
+void RoutingProtocol::rpl_init(void) {
+	uint32_t i;
+
+	instance_table.resize(m_maxInstances);
+	dag_storage.resize(m_maxInstances * m_maxDagsPerInstance);
+	dag_index.resize(m_maxInstances);
+	for (i = 0; i < m_maxInstances; ++i) {
+		instance_table[i].used = 0;
+		instance_table[i].dag_table = &dag_storage[i * m_maxDagsPerInstance];
+	}
+	for (i = 0; i < dag_storage.size(); ++i) {
+		dag_storage[i].used = 0;
+	}
+}
+/*---------------------------------------------------------------------------*/
+rpl_dag_t *
+RoutingProtocol::rpl_get_any_dag(void) {
+	size_t i;
 
-	for (i = 0; i < RPL_MAX_INSTANCES; ++i) {
-		if (instance_table[i].used
-				&& instance_table[i].instance_id == instance_id) {
-			return &instance_table[i];
+	for (i = 0; i < instance_table.size(); ++i) {
+		if (instance_table[i].used && instance_table[i].current_dag != NULL
+				&& instance_table[i].current_dag->joined) {
+			return instance_table[i].current_dag;
 		}
 	}
 	return NULL;
 }
 /*---------------------------------------------------------------------------*/
+rpl_instance_t *
+RoutingProtocol::rpl_get_instance(uint8_t instance_id) {
+	return instance_index[instance_id];
+}
+/*---------------------------------------------------------------------------*/
 rpl_dag_t *
 RoutingProtocol::get_dag(uint8_t instance_id, Ipv6Address dag_id) {
 	rpl_instance_t *instance;
-	rpl_dag_t *dag;
-	int i;
+	DagIndex::const_iterator i;
 
 	instance = this->rpl_get_instance(instance_id);
 	if (instance == NULL) {
 		return NULL;
 	}
 
-	for (i = 0; i < RPL_MAX_DAG_PER_INSTANCE; ++i) {
-		dag = &instance->dag_table[i];
-		if (dag->used && (dag->dag_id == dag_id)) {
-			return dag;
-		}
+	DagIndex const & dags = dag_index[instance - &instance_table[0]];
+	i = dags.find(dag_id);
+	if (i == dags.end()) {
+		return NULL;
 	}
-
-	return NULL;
+	return i->second;
 }
 /*---------------------------------------------------------------------------*/
 rpl_instance_t *
 RoutingProtocol::rpl_alloc_instance(uint8_t instance_id) {
 	rpl_instance_t *instance, *end;
 
-	for (instance = &instance_table[0], end = instance + RPL_MAX_INSTANCES;
+	for (instance = &instance_table[0], end = instance + instance_table.size();
 			instance < end; ++instance) {
 		if (instance->used == 0) {
-			memset(instance, 0, sizeof(*instance));
-			instance->instance_id = instance_id;
+			/* Reset the state field by field: the timers of a reused slot
+			 keep their implementation and are only cancelled. */
+			instance->mc = rpl_metric_container_t();
+			instance->of = NULL;
+			instance->current_dag = NULL;
 			instance->def_route = NULL;
+			instance->instance_id = instance_id;
+			instance->dtsn_out = 0;
+			instance->mop = 0;
+			instance->dio_intdoubl = 0;
+			instance->dio_intmin = 0;
+			instance->dio_redundancy = 0;
+			instance->default_lifetime = 0;
+			instance->dio_intcurrent = 0;
+			instance->dio_send = 0;
+			instance->dio_counter = 0;
+			instance->max_rankinc = 0;
+			instance->min_hoprankinc = 0;
+			instance->lifetime_unit = 0;
+#if RPL_CONF_STATS
+			instance->dio_totint = 0;
+			instance->dio_totsend = 0;
+			instance->dio_totrecv = 0;
+#endif /* RPL_CONF_STATS */
+			instance->dio_next_delay = Time();
+			instance->repairing = 0;
+			instance->repair_start = Time();
+			instance->dao_aggregated_count = 0;
+			instance->dio_timer.Cancel();
+			instance->dao_timer.Cancel();
+			instance->repair_timer.Cancel();
+			instance->dio_timer.SetFunction(&RoutingProtocol::handle_dio_timer,
+					this);
+			instance->dio_timer.SetArguments(instance);
+			instance->dao_timer.SetFunction(&RoutingProtocol::handle_dao_timer,
+					this);
+			instance->dao_timer.SetArguments(instance);
+			instance->repair_timer.SetFunction(
+					&RoutingProtocol::handle_repair_timer, this);
+			instance->repair_timer.SetArguments(instance);
+			/* The first repair is not held off. */
+			instance->last_repair = Simulator::Now() - m_minRepairInterval;
 			instance->used = 1;
-			std::cout << "RPL: Return a allocated instance." << std::endl;
+			instance_index[instance_id] = instance;
+			ILIVE_TRACE_DEBUG ("RPL: Return a allocated instance.");
 			return instance;
 		}
 	}
@@ -1225,21 +1999,22 @@ RoutingProtocol::rpl_alloc_dag(uint8_t instance_id, Ipv6Address dag_id) {
 		instance = rpl_alloc_instance(instance_id);
 		if (instance == NULL) {
 			RPL_STAT(rpl_stats.mem_overflows++);
-			std::cout << "RPL: NULL." << std::endl;
+			ILIVE_TRACE_ERROR ("RPL: Failed to allocate instance " << (uint32_t) instance_id << ".");
 			return NULL;
 		}
 	}
 
-	for (dag = &instance->dag_table[0], end = dag + RPL_MAX_DAG_PER_INSTANCE; dag < end; ++dag)
+	for (dag = &instance->dag_table[0], end = dag + m_maxDagsPerInstance; dag < end; ++dag)
 	{
 		if (!dag->used) {
-			memset(dag, 0, sizeof(*dag));
-			parents_list.push_back(*dag);
+			*dag = rpl_dag_t();
 			dag->used = 1;
 			dag->rank = INFINITE_RANK;
 			dag->min_rank = INFINITE_RANK;
 			dag->instance = instance;
-			std::cout << "RPL: Return a DAG." << std::endl;
+			dag->dag_id = dag_id;
+			dag_index[instance - &instance_table[0]][dag_id] = dag;
+			ILIVE_TRACE_DEBUG ("RPL: Return a DAG.");
 			return dag;
 		}
 	}
@@ -1261,7 +2036,7 @@ RoutingProtocol::rpl_set_root(uint8_t instance_id, Ipv6Address dag_id) {
 
 	dag = rpl_alloc_dag(instance_id, dag_id);
 	if (dag == NULL) {
-		std::cout << "RPL: Failed to allocate a DAG." << std::endl;
+		ILIVE_TRACE_ERROR ("RPL: Failed to allocate a DAG.");
 		return NULL;
 	}
 
@@ -1269,14 +2044,12 @@ RoutingProtocol::rpl_set_root(uint8_t instance_id, Ipv6Address dag_id) {
 
 	dag->version = version;
 	dag->joined = 1;
+	m_dagJoinTrace(instance_id, dag_id);
 	dag->grounded = 0;
-	instance->mop = RPL_MOP_DEFAULT;
-//	instance->of = &RPL_OF;
-	instance->of = NULL; // pretty bad
+	instance->mop = m_mop;
+	instance->of = &RPL_OF;
 	dag->preferred_parent = NULL;
 
-	dag->dag_id = dag_id;
-
 	instance->dio_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
 	instance->dio_intmin = RPL_DIO_INTERVAL_MIN;
 	/* The current interval must differ from the minimum interval in order to
@@ -1293,23 +2066,1290 @@ RoutingProtocol::rpl_set_root(uint8_t instance_id, Ipv6Address dag_id) {
 	if (instance->current_dag != dag && instance->current_dag != NULL) {
 		/* Remove routes installed by DAOs. */
 //		rpl_remove_routes(instance->current_dag);
-		std::cout << "RPL: Enter into a strange place." << std::endl;
+		ILIVE_TRACE_ERROR ("RPL: Enter into a strange place.");
 		instance->current_dag->joined = 0;
 	}
 
 	instance->current_dag = dag;
 	instance->dtsn_out = RPL_LOLLIPOP_INIT;
-//	instance->of->update_metric_container(instance);
+	instance->of->update_metric_container(instance);
 	default_instance = instance;
 
-	std::cout << "RPL: Node set to be a DAG root with DAG ID: " << std::endl;
-	std::cout << dag->dag_id << std::endl;
+	ILIVE_TRACE_INFO ("RPL: Node set to be a DAG root with DAG ID: " << dag->dag_id);
+
+	rpl_reset_dio_timer(instance);
+
+	return dag;
+}
+/*---------------------------------------------------------------------------*/
+int RoutingProtocol::rpl_set_prefix(rpl_dag_t *dag, Ipv6Address prefix,
+		unsigned len) {
+	if (len > 128) {
+		return 0;
+	}
+
+	dag->prefix_info.prefix = prefix.CombinePrefix(Ipv6Prefix((uint8_t) len));
+	dag->prefix_info.length = len;
+	dag->prefix_info.flags = RPL_PREFIX_FLAG_AUTONOMOUS;
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+bool RoutingProtocol::rpl_add_route(rpl_dag_t *dag, Ipv6Address prefix,
+		int prefix_len, Ipv6Address next_hop) {
+	int32_t interface = m_ipv6->GetInterfaceForAddress(m_mainAddress);
+	if (prefix_len < 0 || prefix_len > 128 || interface < 0) {
+		return false;
+	}
+
+	RoutingTableEntry rt(
+	/*device=*/m_ipv6->GetNetDevice(interface),
+	/*dst=*/prefix.CombinePrefix(Ipv6Prefix((uint8_t) prefix_len)),
+	/*seqno=*/0,
+	/*iface=*/m_ipv6->GetAddress(interface, 0),
+	/*hops=*/1,
+	/*next hop=*/next_hop,
+	/*lifetime=*/Simulator::Now());
+	rt.SetPrefixLength(prefix_len);
+	if (!m_routingTable.AddRoute(rt)) {
+		m_routingTable.Update(rt);
+	}
+
+	NS_LOG_DEBUG ("RPL: Added a route to " << rt.GetDestination () << "/"
+			<< prefix_len << " via " << next_hop);
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::rpl_free_dag(rpl_dag_t *dag) {
+	rpl_parent_t *p;
+
+	if (dag->joined) {
+		NS_LOG_DEBUG ("RPL: Leaving the DAG " << dag->dag_id);
+		rpl_remove_routes(dag);
+		dag->joined = 0;
+	}
+
+	while ((p = dag->parents) != NULL) {
+		rpl_remove_parent(dag, p);
+	}
+	dag_index[dag->instance - &instance_table[0]].erase(dag->dag_id);
+	dag->used = 0;
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::rpl_free_instance(rpl_instance_t *instance) {
+	rpl_dag_t *dag, *end;
+
+	NS_LOG_DEBUG ("RPL: Leaving the instance " << (uint32_t) instance->instance_id);
+
+	/* Remove any DAG inside this instance */
+	for (dag = &instance->dag_table[0], end = dag + m_maxDagsPerInstance;
+			dag < end; ++dag) {
+		if (dag->used) {
+			rpl_free_dag(dag);
+		}
+	}
+
+	rpl_set_default_route(instance, Ipv6Address::GetAny());
+
+	instance->dio_timer.Cancel();
+	instance->dao_timer.Cancel();
+	instance->repair_timer.Cancel();
+
+	if (default_instance == instance) {
+		default_instance = NULL;
+	}
+
+	instance_index[instance->instance_id] = NULL;
+	instance->used = 0;
+}
+/*---------------------------------------------------------------------------*/
+rpl_parent_t *
+RoutingProtocol::rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio,
+		Ipv6Address addr) {
+	rpl_parent_t *p, *end, *worst;
+
+	for (p = &dag->parent_table[0], end = p + RPL_MAX_PARENTS_PER_DAG;
+			p < end; ++p) {
+		if (!p->used) {
+			break;
+		}
+	}
+	if (p == end) {
+		/* The table is full: the new parent takes the place of the one with
+		 the highest rank, unless it is the preferred parent. */
+		worst = NULL;
+		for (p = dag->parents; p != NULL; p = p->next) {
+			if (p != dag->preferred_parent) {
+				worst = p;
+			}
+		}
+		if (worst == NULL || dio->rank >= worst->rank) {
+			RPL_STAT(rpl_stats.mem_overflows++);
+			NS_LOG_DEBUG ("RPL: Parent table full, ignoring " << addr);
+			return NULL;
+		}
+		rpl_remove_parent(dag, worst);
+		p = worst;
+	}
+
+	*p = rpl_parent_t();
+	p->used = 1;
+	p->addr = addr;
+	p->dag = dag;
+	p->rank = dio->rank;
+	p->dtsn = dio->dtsn;
+	if (!m_linkEstimator.Lookup(addr, p->link_metric)) {
+		p->link_metric = RPL_INIT_LINK_METRIC;
+	}
+	p->mc = dio->mc;
+	dag->parent_count++;
+	rpl_sort_parent(dag, p);
+	return p;
+}
+/*---------------------------------------------------------------------------*/
+/* (Re)link p in the parent list of dag, after the parents of lower or equal
+ rank. */
+void RoutingProtocol::rpl_sort_parent(rpl_dag_t *dag, rpl_parent_t *p) {
+	rpl_parent_t **pp;
+
+	for (pp = &dag->parents; *pp != NULL; pp = &(*pp)->next) {
+		if (*pp == p) {
+			*pp = p->next;
+			break;
+		}
+	}
+	for (pp = &dag->parents; *pp != NULL && (*pp)->rank <= p->rank;
+			pp = &(*pp)->next) {
+	}
+	p->next = *pp;
+	*pp = p;
+}
+/*---------------------------------------------------------------------------*/
+rpl_parent_t *
+RoutingProtocol::rpl_find_parent(rpl_dag_t *dag, Ipv6Address addr) {
+	rpl_parent_t *p;
+
+	for (p = dag->parents; p != NULL; p = p->next) {
+		if (p->addr == addr) {
+			return p;
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+rpl_parent_t *
+RoutingProtocol::rpl_find_parent_any_dag(rpl_instance_t *instance,
+		Ipv6Address addr) {
+	rpl_dag_t *dag, *end;
+	rpl_parent_t *p;
+
+	for (dag = &instance->dag_table[0], end = dag + m_maxDagsPerInstance;
+			dag < end; ++dag) {
+		if (dag->used) {
+			p = rpl_find_parent(dag, addr);
+			if (p != NULL) {
+				return p;
+			}
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::rpl_remove_parent(rpl_dag_t *dag, rpl_parent_t *parent) {
+	rpl_parent_t **pp;
+
+	NS_LOG_DEBUG ("RPL: Removing parent " << parent->addr);
+
+	if (parent == dag->preferred_parent) {
+		dag->preferred_parent = NULL;
+		if (dag->joined) {
+			rpl_set_default_route(dag->instance, Ipv6Address::GetAny());
+		}
+	}
+	rpl_remove_routes_by_nexthop(parent->addr, dag);
+
+	for (pp = &dag->parents; *pp != NULL; pp = &(*pp)->next) {
+		if (*pp == parent) {
+			*pp = parent->next;
+			break;
+		}
+	}
+	parent->used = 0;
+	dag->parent_count--;
+}
+/*---------------------------------------------------------------------------*/
+/* Stop routing through parent if it is the preferred parent of dag: the
+ node withdraws its routes from it and has no rank until it selects another
+ parent. */
+void RoutingProtocol::rpl_nullify_parent(rpl_dag_t *dag, rpl_parent_t *parent) {
+	if (parent != dag->preferred_parent) {
+		return;
+	}
+
+	NS_LOG_DEBUG ("RPL: Nullifying preferred parent " << parent->addr);
+	dag->preferred_parent = NULL;
+	dag->rank = INFINITE_RANK;
+	if (dag->joined) {
+		rpl_set_default_route(dag->instance, Ipv6Address::GetAny());
+		if (dag->instance->mop != RPL_MOP_NO_DOWNWARD_ROUTES
+				&& dag->instance->mop != RPL_MOP_NON_STORING) {
+			dao_output(parent, RPL_ZERO_LIFETIME);
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+/* Detach from dag: the node advertises INFINITE_RANK, so that its children
+ stop routing through it, and drops the parents but exception with the
+ routes through them. */
+void RoutingProtocol::rpl_poison_routes(rpl_dag_t *dag, rpl_parent_t *exception) {
+	rpl_parent_t *p, *next;
+
+	NS_LOG_DEBUG ("RPL: Poisoning routes");
+	dag->rank = INFINITE_RANK;
+	for (p = dag->parents; p != NULL; p = next) {
+		next = p->next;
+		if (p != exception) {
+			rpl_remove_parent(dag, p);
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+rpl_parent_t *
+RoutingProtocol::rpl_select_parent(rpl_dag_t *dag) {
+	rpl_parent_t *p, *best;
+
+	best = NULL;
+	for (p = dag->parents; p != NULL; p = p->next) {
+		if (p->rank == INFINITE_RANK) {
+			/* ignore this neighbor */
+		} else if (best == NULL) {
+			best = p;
+		} else {
+			best = dag->instance->of->best_parent(best, p);
+		}
+	}
 
-//	rpl_reset_dio_timer(instance);
+	if (best != NULL) {
+		dag->preferred_parent = best;
+	}
+	return best;
+}
+/*---------------------------------------------------------------------------*/
+/* A rank is acceptable unless it exceeds the lowest rank the node had in
+ this DODAG version by more than MaxRankIncrease (RFC 6550, 8.2.2.4). A node
+ detached by a local repair starts over from any rank. */
+static int acceptable_rank(rpl_dag_t *dag, rpl_rank_t rank) {
+	rpl_instance_t *instance = dag->instance;
+
+	return rank != INFINITE_RANK
+			&& (instance->max_rankinc == 0
+					|| DAG_RANK(rank, instance)
+							<= DAG_RANK(dag->min_rank + instance->max_rankinc,
+									instance));
+}
+/*---------------------------------------------------------------------------*/
+rpl_dag_t *
+RoutingProtocol::rpl_select_dag(rpl_instance_t *instance, rpl_parent_t *p) {
+	rpl_dag_t *dag = p->dag;
+	rpl_parent_t *best, *last_parent;
+	rpl_rank_t rank;
+
+	last_parent = dag->preferred_parent;
+	best = rpl_select_parent(dag);
+	if (best == NULL) {
+		/* No parent found: the calling function handle this problem. */
+		return NULL;
+	}
 
+	rank = instance->of->calculate_rank(best, 0);
+	if (last_parent == NULL || rank < dag->min_rank) {
+		dag->min_rank = rank;
+	} else if (!acceptable_rank(dag, rank)) {
+		NS_LOG_DEBUG ("RPL: New rank " << rank << " unacceptable");
+		dag->preferred_parent = last_parent;
+		return NULL;
+	}
+	dag->rank = rank;
+	instance->of->update_metric_container(instance);
 	return dag;
 }
 /*---------------------------------------------------------------------------*/
+int RoutingProtocol::rpl_process_parent_event(rpl_instance_t *instance,
+		rpl_parent_t *p) {
+	rpl_rank_t old_rank;
+	rpl_parent_t *last_parent;
+
+	old_rank = instance->current_dag->rank;
+	last_parent = instance->current_dag->preferred_parent;
+
+	if (rpl_select_dag(instance, p) == NULL) {
+		if (last_parent != NULL) {
+			/* No suitable parent; trigger a local repair. */
+			NS_LOG_DEBUG ("RPL: No parents found in any DAG");
+			rpl_local_repair(instance);
+		}
+		return 0;
+	}
+
+	if (instance->repairing) {
+		instance->repairing = 0;
+		NS_LOG_DEBUG ("RPL: Reattached after "
+				<< (Simulator::Now() - instance->repair_start).GetSeconds() << " s");
+		m_reattachTrace(instance->instance_id,
+				Simulator::Now() - instance->repair_start);
+	}
+
+	if (DAG_RANK(old_rank, instance)
+			!= DAG_RANK(instance->current_dag->rank, instance)
+			|| last_parent != instance->current_dag->preferred_parent) {
+		NS_LOG_DEBUG ("RPL: Moving in the instance from rank " << old_rank
+				<< " to " << instance->current_dag->rank);
+		/* Our advertised DODAG information changed: this is an inconsistency. */
+		rpl_reset_dio_timer(instance);
+	}
+
+	if (last_parent != instance->current_dag->preferred_parent) {
+		rpl_set_default_route(instance,
+				instance->current_dag->preferred_parent->addr);
+		if (instance->mop == RPL_MOP_NON_STORING) {
+			/* The root learns our new parent from our next DAO; the routes
+			 of our children are kept by the root and remain valid. */
+			rpl_schedule_dao(instance);
+		} else if (instance->mop != RPL_MOP_NO_DOWNWARD_ROUTES) {
+			/* Withdraw our routes from the old parent and advertise them
+			 to the new one; children refresh theirs on the new DTSN. */
+			if (last_parent != NULL) {
+				dao_output(last_parent, RPL_ZERO_LIFETIME);
+			}
+			RPL_LOLLIPOP_INCREMENT(instance->dtsn_out);
+			rpl_schedule_dao(instance);
+		}
+	}
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* The link estimator reports a new ETX for the link to addr: the OF updates
+ the parent, and the preferred parent and rank are reconsidered. */
+void RoutingProtocol::rpl_link_neighbor_callback(Ipv6Address addr,
+		uint8_t etx) {
+	rpl_instance_t *instance, *end;
+	rpl_parent_t *parent;
+
+	for (instance = &instance_table[0], end = instance + instance_table.size();
+			instance < end; ++instance) {
+		if (!instance->used || instance->current_dag == NULL) {
+			continue;
+		}
+		parent = rpl_find_parent_any_dag(instance, addr);
+		if (parent == NULL) {
+			continue;
+		}
+		instance->of->parent_state_callback(parent, 1, etx);
+		parent->updated = 1;
+	}
+	rpl_recalculate_ranks();
+}
+/*---------------------------------------------------------------------------*/
+/* Reconsider the preferred parent and rank of the instances whose parents
+ were updated by the link estimator. A parent event may trigger a local
+ repair, which drops parents: the list is scanned again after each event. */
+void RoutingProtocol::rpl_recalculate_ranks(void) {
+	rpl_instance_t *instance, *end;
+	rpl_dag_t *dag;
+	rpl_parent_t *p;
+
+	for (instance = &instance_table[0], end = instance + instance_table.size();
+			instance < end; ++instance) {
+		dag = instance->current_dag;
+		if (!instance->used || dag == NULL) {
+			continue;
+		}
+		if (dag->rank == ROOT_RANK(instance)) {
+			for (p = dag->parents; p != NULL; p = p->next) {
+				p->updated = 0;
+			}
+			continue;
+		}
+		do {
+			for (p = dag->parents; p != NULL && !p->updated; p = p->next) {
+			}
+			if (p != NULL) {
+				p->updated = 0;
+				rpl_process_parent_event(instance, p);
+			}
+		} while (p != NULL);
+	}
+}
+/*---------------------------------------------------------------------------*/
+/* The node lost its last acceptable parent: it detaches from the DAGs of
+ the instance and poisons its sub-DODAG, then rejoins through the first
+ parent of acceptable rank it hears from, which it solicits with a DIS. */
+void RoutingProtocol::rpl_local_repair(rpl_instance_t *instance) {
+	rpl_dag_t *dag, *end;
+
+	if (instance == NULL) {
+		return;
+	}
+
+	NS_LOG_DEBUG ("RPL: Starting a local instance repair");
+	for (dag = &instance->dag_table[0], end = dag + m_maxDagsPerInstance;
+			dag < end; ++dag) {
+		if (dag->used) {
+			if (dag->preferred_parent != NULL) {
+				rpl_nullify_parent(dag, dag->preferred_parent);
+			}
+			rpl_poison_routes(dag, NULL);
+		}
+	}
+	if (!instance->repairing) {
+		instance->repairing = 1;
+		instance->repair_start = Simulator::Now();
+	}
+	RPL_STAT(rpl_stats.local_repairs++);
+
+	/* The poisoning DIOs and the DIS are rate limited, the detachment is not. */
+	if (!repair_held_off(instance)) {
+		rpl_reset_dio_timer(instance);
+		dis_output(Ipv6Address::GetAny());
+	}
+}
+/*---------------------------------------------------------------------------*/
+/* A DIO of dag carries a newer DODAG version: the node drops its parents
+ and rejoins the new version through the sender. */
+void RoutingProtocol::rpl_global_repair(Ipv6Address from, rpl_dag_t *dag,
+		rpl_dio_t *dio) {
+	rpl_instance_t *instance = dag->instance;
+	rpl_parent_t *p;
+
+	rpl_poison_routes(dag, NULL);
+	dag->version = dio->version;
+	instance->of->reset(dag);
+	dag->min_rank = INFINITE_RANK;
+	RPL_LOLLIPOP_INCREMENT(instance->dtsn_out);
+
+	p = rpl_add_parent(dag, dio, from);
+	if (p == NULL) {
+		NS_LOG_DEBUG ("RPL: Failed to add a parent during the global repair");
+	} else {
+		rpl_process_parent_event(instance, p);
+	}
+	NS_LOG_DEBUG ("RPL: Participating in a global repair (version="
+			<< (uint32_t) dag->version << ", rank=" << dag->rank << ")");
+	RPL_STAT(rpl_stats.global_repairs++);
+	rpl_reset_dio_timer(instance);
+}
+/*---------------------------------------------------------------------------*/
+/* The root starts a global repair: the new DODAG version rebuilds the
+ DODAG from scratch. */
+int RoutingProtocol::rpl_repair_root(uint8_t instance_id) {
+	rpl_instance_t *instance;
+
+	instance = rpl_get_instance(instance_id);
+	if (instance == NULL || instance->current_dag == NULL
+			|| instance->current_dag->rank != ROOT_RANK(instance)) {
+		NS_LOG_DEBUG ("RPL: rpl_repair_root triggered but not root");
+		return 0;
+	}
+	if (repair_held_off(instance)) {
+		return 1;
+	}
+
+	RPL_STAT(rpl_stats.global_repairs++);
+	RPL_LOLLIPOP_INCREMENT(instance->current_dag->version);
+	RPL_LOLLIPOP_INCREMENT(instance->dtsn_out);
+	NS_LOG_DEBUG ("RPL: rpl_repair_root initiating global repair with version "
+			<< (uint32_t) instance->current_dag->version);
+	rpl_reset_dio_timer(instance);
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+bool RoutingProtocol::repair_held_off(rpl_instance_t *instance) {
+	Time next = instance->last_repair + m_minRepairInterval;
+
+	if (Simulator::Now() >= next) {
+		instance->last_repair = Simulator::Now();
+		return false;
+	}
+	if (!instance->repair_timer.IsRunning()) {
+		NS_LOG_DEBUG ("RPL: Repair held off for "
+				<< (next - Simulator::Now()).GetSeconds() << " s");
+		instance->repair_timer.Schedule(next - Simulator::Now());
+	}
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::handle_repair_timer(rpl_instance_t *instance) {
+	rpl_dag_t *dag = instance->current_dag;
+
+	if (dag == NULL) {
+		return;
+	}
+	if (dag->rank == ROOT_RANK(instance)) {
+		rpl_repair_root(instance->instance_id);
+	} else if (instance->repairing && !repair_held_off(instance)) {
+		rpl_reset_dio_timer(instance);
+		dis_output(Ipv6Address::GetAny());
+	}
+}
+/*---------------------------------------------------------------------------*/
+rpl_of_t *
+RoutingProtocol::rpl_find_of(rpl_ocp_t ocp) {
+	rpl_of_t **of;
+
+	for (of = &rpl_objective_functions[0]; *of != NULL; ++of) {
+		if ((*of)->ocp == ocp) {
+			return *of;
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::rpl_join_instance(Ipv6Address from, rpl_dio_t *dio) {
+	rpl_instance_t *instance;
+	rpl_dag_t *dag;
+	rpl_parent_t *p;
+	rpl_of_t *of;
+
+	if (dio->rank == INFINITE_RANK) {
+		NS_LOG_DEBUG ("RPL: Ignoring a DIO with infinite rank from " << from);
+		return;
+	}
+
+	of = rpl_find_of(dio->ocp);
+	if (of == NULL) {
+		NS_LOG_DEBUG ("RPL: DIO for DAG instance " << (uint32_t) dio->instance_id
+				<< " does not specify a supported OF (OCP " << dio->ocp << ")");
+		return;
+	}
+
+	dag = rpl_alloc_dag(dio->instance_id, dio->dag_id);
+	if (dag == NULL) {
+		NS_LOG_DEBUG ("RPL: Failed to allocate a DAG object!");
+		return;
+	}
+
+	instance = dag->instance;
+
+	p = rpl_add_parent(dag, dio, from);
+	NS_LOG_DEBUG ("RPL: Adding " << from << " as a parent");
+
+	instance->mop = dio->mop;
+	instance->of = of;
+	instance->current_dag = dag;
+	instance->dtsn_out = RPL_LOLLIPOP_INIT;
+
+	instance->max_rankinc = dio->dag_max_rankinc;
+	instance->min_hoprankinc = dio->dag_min_hoprankinc;
+	instance->dio_intdoubl = dio->dag_intdoubl;
+	instance->dio_intmin = dio->dag_intmin;
+	instance->dio_intcurrent = instance->dio_intmin + instance->dio_intdoubl;
+	instance->dio_redundancy = dio->dag_redund;
+	instance->default_lifetime = dio->default_lifetime;
+	instance->lifetime_unit = dio->lifetime_unit;
+
+	dag->version = dio->version;
+	dag->grounded = dio->grounded;
+	dag->preference = dio->preference;
+	dag->prefix_info = dio->prefix_info;
+	dag->joined = 1;
+	dag->preferred_parent = p;
+	dag->rank = instance->of->calculate_rank(p, 0);
+	/* So far this is the lowest rank we are aware of. */
+	dag->min_rank = dag->rank;
+	instance->of->update_metric_container(instance);
+
+	if (default_instance == NULL) {
+		default_instance = instance;
+	}
+	m_dag = dag;
+
+	NS_LOG_DEBUG ("RPL: Joined DAG with instance ID " << (uint32_t) dio->instance_id
+			<< ", rank " << dag->rank << ", DAG ID " << dag->dag_id);
+	m_dagJoinTrace(dio->instance_id, dag->dag_id);
+
+	rpl_set_default_route(instance, from);
+
+	rpl_reset_dio_timer(instance);
+	if (instance->mop != RPL_MOP_NO_DOWNWARD_ROUTES) {
+		rpl_schedule_dao(instance);
+	}
+}
+/*---------------------------------------------------------------------------*/
+/* Lollipop counter comparison of RFC 6550, section 7.2. */
+static int lollipop_greater_than(int a, int b) {
+	/* Check if we are comparing an initial value with an old value */
+	if (a > RPL_LOLLIPOP_CIRCULAR_REGION && b <= RPL_LOLLIPOP_CIRCULAR_REGION) {
+		return (RPL_LOLLIPOP_MAX_VALUE + 1 + b - a)
+				> RPL_LOLLIPOP_SEQUENCE_WINDOWS;
+	}
+	/* Otherwise check if a > b and comparable => ok, or
+	 if they have wrapped and are still comparable */
+	return (a > b && (a - b) < RPL_LOLLIPOP_SEQUENCE_WINDOWS)
+			|| (a < b
+					&& (b - a)
+							> (RPL_LOLLIPOP_CIRCULAR_REGION + 1
+									- RPL_LOLLIPOP_SEQUENCE_WINDOWS));
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::rpl_process_dio(Ipv6Address from, rpl_dio_t *dio) {
+	rpl_instance_t *instance;
+	rpl_dag_t *dag;
+	rpl_parent_t *p;
+
+	instance = rpl_get_instance(dio->instance_id);
+	dag = get_dag(dio->instance_id, dio->dag_id);
+
+	if (dag != NULL && instance != NULL) {
+		if (lollipop_greater_than(dio->version, dag->version)) {
+			if (dag->rank == ROOT_RANK(instance)) {
+				NS_LOG_DEBUG ("RPL: Root received inconsistent DIO version number");
+				dag->version = dio->version;
+				RPL_LOLLIPOP_INCREMENT(dag->version);
+				rpl_reset_dio_timer(instance);
+			} else {
+				NS_LOG_DEBUG ("RPL: Global repair to DODAG version "
+						<< (uint32_t) dio->version);
+				rpl_global_repair(from, dag, dio);
+			}
+			return;
+		}
+
+		if (lollipop_greater_than(dag->version, dio->version)) {
+			/* The DIO sender is on an older version of the DAG. */
+			NS_LOG_DEBUG ("RPL: old version received => inconsistency detected");
+			if (dag->joined) {
+				rpl_reset_dio_timer(instance);
+				return;
+			}
+		}
+	}
+
+	if (instance == NULL) {
+		NS_LOG_DEBUG ("RPL: New instance detected: Joining...");
+		rpl_join_instance(from, dio);
+		return;
+	}
+
+	if (dag == NULL) {
+		NS_LOG_DEBUG ("RPL: DIO for another DAG of instance "
+				<< (uint32_t) dio->instance_id << " ignored");
+		return;
+	}
+
+	if (dio->rank < ROOT_RANK(instance)) {
+		NS_LOG_DEBUG ("RPL: Ignoring DIO with too low rank: " << dio->rank);
+		return;
+	} else if (dio->rank == INFINITE_RANK && dag->joined) {
+		rpl_reset_dio_timer(instance);
+	}
+
+	if (dag->rank == ROOT_RANK(instance)) {
+		if (dio->rank != INFINITE_RANK) {
+			/* A consistent transmission (RFC 6206, 4.2 step 3). */
+			instance->dio_counter++;
+		}
+		return;
+	}
+
+	/*
+	 * At this point, we know that this DIO pertains to a DAG that
+	 * we are already part of. We consider the sender of the DIO to be
+	 * a candidate parent, and let rpl_process_parent_event decide
+	 * whether to keep it in the set.
+	 */
+	p = rpl_find_parent(dag, from);
+	if (p == NULL) {
+		p = rpl_add_parent(dag, dio, from);
+		if (p == NULL) {
+			return;
+		}
+		NS_LOG_DEBUG ("RPL: New candidate parent with rank " << p->rank
+				<< ": " << from);
+	} else if (p->rank == dio->rank) {
+		NS_LOG_DEBUG ("RPL: Received consistent DIO");
+		if (dag->joined) {
+			instance->dio_counter++;
+		}
+	} else {
+		p->rank = dio->rank;
+		rpl_sort_parent(dag, p);
+	}
+	/* The metric container of a known parent may have changed too. */
+	p->mc = dio->mc;
+
+	rpl_process_parent_event(instance, p);
+
+	/* A new DTSN from our preferred parent requests fresh DAOs. */
+	if (p == dag->preferred_parent && instance->mop != RPL_MOP_NO_DOWNWARD_ROUTES
+			&& lollipop_greater_than(dio->dtsn, p->dtsn)) {
+		RPL_LOLLIPOP_INCREMENT(instance->dtsn_out);
+		rpl_schedule_dao(instance);
+	}
+	p->dtsn = dio->dtsn;
+}
+/*---------------------------------------------------------------------------*/
+int RoutingProtocol::rpl_set_default_route(rpl_instance_t *instance,
+		Ipv6Address from) {
+	/* The default route is the ::/0 prefix route towards the preferred parent. */
+	m_routingTable.DeleteRoute(Ipv6Address::GetAny(), 0);
+	if (from != Ipv6Address::GetAny()) {
+		NS_LOG_DEBUG ("RPL: Adding default route through " << from);
+		if (!rpl_add_route(instance->current_dag, Ipv6Address::GetAny(), 0,
+				from)) {
+			NS_LOG_DEBUG ("RPL: Failed to add a default route");
+			return 0;
+		}
+	}
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* The DAO routing table is shared by the DAGs of the node, which only
+ joins one DAG at a time: removing the routes of a DAG removes them all. */
+void RoutingProtocol::rpl_remove_routes(rpl_dag_t *dag) {
+	std::vector<DaoRoutingTableEntry> routes;
+
+	m_daoRoutingTable.GetListOfAllRoutes(routes);
+	for (std::vector<DaoRoutingTableEntry>::const_iterator r = routes.begin();
+			r != routes.end(); ++r) {
+		if (r->GetPrefixLength() < 128) {
+			m_routingTable.DeleteRoute(r->GetTarget(), r->GetPrefixLength());
+		}
+	}
+	m_daoRoutingTable.Clear();
+	m_sourceRoutingTable.Clear();
+	m_daoExpiryTimer.Cancel();
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::rpl_remove_routes_by_nexthop(Ipv6Address nexthop,
+		rpl_dag_t *dag) {
+	std::vector<DaoRoutingTableEntry> removed;
+
+	m_daoRoutingTable.DeleteRoutesWithNextHop(nexthop, removed);
+	for (std::vector<DaoRoutingTableEntry>::const_iterator r = removed.begin();
+			r != removed.end(); ++r) {
+		NS_LOG_DEBUG ("RPL: Removed downward route to " << r->GetTarget ()
+				<< " via " << nexthop);
+		if (r->GetPrefixLength() < 128) {
+			m_routingTable.DeleteRoute(r->GetTarget(), r->GetPrefixLength());
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::dao_input(Ipv6Address from, Ptr<Packet> packet) {
+	DAOPacket dao;
+	rpl_instance_t *instance;
+	rpl_dag_t *dag;
+	std::vector<rpl_dao_target_t> accepted;
+
+	if (packet->RemoveHeader(dao) == 0) {
+		RPL_STAT(rpl_stats.malformed_msgs++);
+		NS_LOG_DEBUG ("RPL: Discarding a malformed DAO from " << from);
+		return;
+	}
+
+	instance = rpl_get_instance(dao.GetInstanceID());
+	if (instance == NULL || instance->current_dag == NULL) {
+		NS_LOG_DEBUG ("RPL: Ignoring a DAO for a DAG we are not part of");
+		return;
+	}
+	dag = instance->current_dag;
+	if (dao.GetFlagD() && dao.GetDagID() != dag->dag_id) {
+		NS_LOG_DEBUG ("RPL: Ignoring a DAO for another DAG " << dao.GetDagID());
+		return;
+	}
+	if (instance->mop == RPL_MOP_NO_DOWNWARD_ROUTES) {
+		NS_LOG_DEBUG ("RPL: Ignoring a DAO in a DAG without downward routes");
+		return;
+	}
+
+	NS_LOG_DEBUG ("RPL: Received a DAO with sequence number "
+			<< (uint32_t) dao.GetSequence() << " and "
+			<< dao.GetTargets().size() << " targets from " << from);
+
+	if (instance->mop == RPL_MOP_NON_STORING) {
+		dao_input_nonstoring(instance, from, dao);
+		return;
+	}
+
+	int32_t interface = m_ipv6->GetInterfaceForAddress(m_mainAddress);
+	std::vector<rpl_dao_target_t> const & targets = dao.GetTargets();
+	for (std::vector<rpl_dao_target_t>::const_iterator t = targets.begin();
+			t != targets.end(); ++t) {
+		DaoRoutingTableEntry rt;
+		bool known = m_daoRoutingTable.LookupRoute(t->prefix, rt);
+
+		if (t->lifetime == RPL_ZERO_LIFETIME) {
+			/* No-Path DAO: only the next hop in use may withdraw the route. */
+			if (known && rt.GetNextHop() == from) {
+				NS_LOG_DEBUG ("RPL: Removing downward route to " << t->prefix);
+				m_daoRoutingTable.DeleteRoute(t->prefix);
+				if (rt.GetPrefixLength() < 128) {
+					m_routingTable.DeleteRoute(t->prefix, rt.GetPrefixLength());
+				}
+				accepted.push_back(*t);
+			}
+			continue;
+		}
+
+		if (known && lollipop_greater_than(rt.GetPathSequence(),
+				t->path_sequence)) {
+			NS_LOG_DEBUG ("RPL: Ignoring a stale DAO for " << t->prefix
+					<< " (path sequence " << (uint32_t) t->path_sequence
+					<< " older than " << (uint32_t) rt.GetPathSequence() << ")");
+			continue;
+		}
+
+		Time expire = Simulator::GetMaximumSimulationTime();
+		if (t->lifetime != RPL_INFINITE_LIFETIME) {
+			expire = Simulator::Now()
+					+ Seconds(RPL_LIFETIME(instance, t->lifetime));
+		}
+		DaoRoutingTableEntry route(
+		/*device=*/m_ipv6->GetNetDevice(interface),
+		/*target=*/t->prefix,
+		/*prefix length=*/t->prefix_len,
+		/*source=*/m_mainAddress,
+		/*next hop=*/from,
+		/*path sequence=*/t->path_sequence,
+		/*expire=*/expire);
+		m_daoRoutingTable.Update(route);
+		HandleRouteArrival(t->prefix);
+		if (t->prefix_len < 128) {
+			rpl_add_route(dag, t->prefix, t->prefix_len, from);
+		}
+		NS_LOG_DEBUG ("RPL: Added a downward route to " << t->prefix << "/"
+				<< (uint32_t) t->prefix_len << " via " << from);
+		accepted.push_back(*t);
+	}
+	ScheduleDaoExpiry();
+
+	if (dao.GetFlagK()) {
+		dao_ack_output(instance, from, dao.GetSequence());
+	}
+
+	/* Storing mode: our parent learns the targets through us, in the DAO
+	 that aggregates the targets of our children for RPL_DAO_LATENCY. */
+	if (!accepted.empty() && dag->rank != ROOT_RANK(instance)
+			&& dag->preferred_parent != NULL) {
+		for (std::vector<rpl_dao_target_t>::const_iterator t =
+				accepted.begin(); t != accepted.end(); ++t) {
+			dao_aggregate(instance, *t);
+		}
+		rpl_schedule_dao(instance);
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::dao_aggregate(rpl_instance_t *instance,
+		rpl_dao_target_t const & target) {
+	rpl_dao_target_t *t, *end;
+
+	/* A newer DAO for a target replaces the one waiting. */
+	for (t = &instance->dao_aggregated[0], end = t
+			+ instance->dao_aggregated_count; t < end; ++t) {
+		if (t->prefix == target.prefix && t->prefix_len == target.prefix_len) {
+			*t = target;
+			return;
+		}
+	}
+
+	if (instance->dao_aggregated_count == RPL_DAO_MAX_AGGREGATED) {
+		NS_LOG_DEBUG ("RPL: DAO aggregation full, sending it early");
+		instance->dao_timer.Cancel();
+		handle_dao_timer(instance);
+		if (instance->dao_aggregated_count == RPL_DAO_MAX_AGGREGATED) {
+			/* no parent to send them to */
+			return;
+		}
+	}
+	instance->dao_aggregated[instance->dao_aggregated_count++] = target;
+}
+/*---------------------------------------------------------------------------*/
+/* Non-storing mode: DAOs are addressed to the root, which records the parent
+ of each target to source route the downward packets. */
+void RoutingProtocol::dao_input_nonstoring(rpl_instance_t *instance,
+		Ipv6Address from, DAOPacket const & dao) {
+	rpl_dag_t *dag = instance->current_dag;
+
+	if (dag->rank != ROOT_RANK(instance)) {
+		NS_LOG_DEBUG ("RPL: Ignoring a non-storing DAO, only the root keeps downward routes");
+		return;
+	}
+
+	std::vector<rpl_dao_target_t> const & targets = dao.GetTargets();
+	for (std::vector<rpl_dao_target_t>::const_iterator t = targets.begin();
+			t != targets.end(); ++t) {
+		Ipv6Address parent;
+		uint8_t sequence;
+
+		if (t->prefix_len != 128 || t->parent == Ipv6Address::GetAny()) {
+			NS_LOG_DEBUG ("RPL: Ignoring target " << t->prefix << "/"
+					<< (uint32_t) t->prefix_len << " without parent address");
+			continue;
+		}
+		if (m_sourceRoutingTable.LookupParent(t->prefix, parent, sequence)
+				&& lollipop_greater_than(sequence, t->path_sequence)) {
+			NS_LOG_DEBUG ("RPL: Ignoring a stale DAO for " << t->prefix);
+			continue;
+		}
+		if (t->lifetime == RPL_ZERO_LIFETIME) {
+			NS_LOG_DEBUG ("RPL: Removing the DAO parent of " << t->prefix);
+			m_sourceRoutingTable.DeleteRoute(t->prefix);
+			continue;
+		}
+
+		Time expire = Simulator::GetMaximumSimulationTime();
+		if (t->lifetime != RPL_INFINITE_LIFETIME) {
+			expire = Simulator::Now()
+					+ Seconds(RPL_LIFETIME(instance, t->lifetime));
+		}
+		m_sourceRoutingTable.Update(t->prefix, t->parent, t->path_sequence,
+				expire);
+		NS_LOG_DEBUG ("RPL: " << t->prefix << " has DAO parent " << t->parent);
+	}
+	ScheduleDaoExpiry();
+
+	if (dao.GetFlagK()) {
+		dao_ack_output(instance, from, dao.GetSequence());
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::dao_output(rpl_parent_t *parent, uint8_t lifetime) {
+	rpl_dao_target_t target = rpl_dao_target_t();
+	rpl_instance_t *instance;
+	Ipv6Address dest;
+
+	if (parent == NULL) {
+		NS_LOG_DEBUG ("RPL: dao_output: no parent");
+		return;
+	}
+	instance = parent->dag->instance;
+	dest = parent->addr;
+
+	RPL_LOLLIPOP_INCREMENT(m_pathSequence);
+	target.prefix = m_mainAddress;
+	target.prefix_len = 128;
+	target.path_sequence = m_pathSequence;
+	target.lifetime = lifetime;
+
+	if (instance->mop == RPL_MOP_NON_STORING) {
+		/* The root is told who our parent is. */
+		target.parent = parent->addr;
+		dest = parent->dag->dag_id;
+	}
+
+	std::vector<rpl_dao_target_t> targets(1, target);
+	if (lifetime != RPL_ZERO_LIFETIME) {
+		/* The No-Path DAO to a former parent does not carry the child targets. */
+		targets.insert(targets.end(), &instance->dao_aggregated[0],
+				&instance->dao_aggregated[instance->dao_aggregated_count]);
+		instance->dao_aggregated_count = 0;
+	}
+	SendDao(instance, dest, targets);
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::SendDao(rpl_instance_t *instance, Ipv6Address dest,
+		std::vector<rpl_dao_target_t> const & targets) {
+	std::vector<rpl_dao_target_t>::const_iterator t = targets.begin();
+	Ptr<Ipv6Route> route;
+
+	/* Non-storing DAOs travel up to the root along the default route. */
+	if (instance->mop != RPL_MOP_NON_STORING) {
+		route = NeighborRoute(dest);
+	}
+
+	while (t != targets.end()) {
+		Ptr<Packet> p = Create<Packet>();
+		DAOPacket dao;
+
+		dao.SetInstanceID(instance->instance_id);
+		RPL_LOLLIPOP_INCREMENT(m_daoSequence);
+		dao.SetSequence(m_daoSequence);
+#if RPL_DAO_SPECIFY_DAG
+		dao.SetDagID(instance->current_dag->dag_id);
+#endif /* RPL_DAO_SPECIFY_DAG */
+		/* pack the targets up to the MTU, at least one per DAO */
+		uint32_t size = dao.GetSerializedSize();
+		do {
+			dao.AddTarget(*t);
+			size += DAOPacket::GetTargetSize(*t);
+			++t;
+		} while (t != targets.end()
+				&& size + DAOPacket::GetTargetSize(*t) <= RPL_DAO_MAX_SIZE);
+
+		dao.CalculatePseudoHeaderChecksum(m_mainAddress, dest, size, 58);
+		p->AddHeader(dao);
+
+		NS_LOG_DEBUG ("RPL: Sending a DAO with " << dao.GetTargets().size()
+				<< " targets to " << dest);
+		RPLSend(p, m_mainAddress, dest, 255, route);
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::dao_ack_input(Ipv6Address from, Ptr<Packet> packet) {
+	DAOAckPacket ack;
+
+	packet->RemoveHeader(ack);
+	NS_LOG_DEBUG ("RPL: Received a DAO ACK with sequence number "
+			<< (uint32_t) ack.GetSequence() << " and status "
+			<< (uint32_t) ack.GetStatus() << " from " << from);
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::dao_ack_output(rpl_instance_t *instance, Ipv6Address dest,
+		uint8_t sequence) {
+	Ptr<Packet> p = Create<Packet>();
+	Ptr<Ipv6Route> route;
+	DAOAckPacket ack;
+
+	ack.SetInstanceID(instance->instance_id);
+	ack.SetSequence(sequence);
+	ack.SetStatus(0);
+
+	ack.CalculatePseudoHeaderChecksum(m_mainAddress, dest,
+			ack.GetSerializedSize(), 58);
+	p->AddHeader(ack);
+
+	/* In non-storing mode, the root source routes the ACK. */
+	if (instance->mop != RPL_MOP_NON_STORING) {
+		route = NeighborRoute(dest);
+	}
+	NS_LOG_DEBUG ("RPL: Sending a DAO ACK with sequence number "
+			<< (uint32_t) sequence << " to " << dest);
+	RPLSend(p, m_mainAddress, dest, 255, route);
+}
+/*---------------------------------------------------------------------------*/
+/* Trickle timer for DIO transmissions (RFC 6206), after ContikiRPL's
+ rpl-timers.c. dio_intcurrent holds the current interval I as a power of two
+ in milliseconds, dio_counter the consistency counter c and dio_redundancy
+ the redundancy constant k. */
+void RoutingProtocol::new_dio_interval(rpl_instance_t *instance) {
+	uint32_t time;
+	uint32_t ticks;
+
+	time = 1UL << instance->dio_intcurrent;
+
+	/* random number between I/2 and I */
+	ticks = time / 2;
+	if (ticks > 0) {
+		ticks += m_uniformRandomVariable->GetInteger(0, ticks - 1);
+	}
+
+	/*
+	 * The intervals must be equally long among the nodes for Trickle to
+	 * operate efficiently. Therefore we need to calculate the delay between
+	 * the randomized time and the start time of the next interval.
+	 */
+	instance->dio_next_delay = MilliSeconds(time - ticks);
+	instance->dio_send = 1;
+
+#if RPL_CONF_STATS
+	/* keep some stats */
+	instance->dio_totint++;
+	instance->dio_totrecv += instance->dio_counter;
+#endif /* RPL_CONF_STATS */
+
+	/* reset the redundancy counter */
+	instance->dio_counter = 0;
+
+	/* schedule the timer */
+	NS_LOG_DEBUG ("RPL: Scheduling DIO timer " << ticks << " ms in future");
+	instance->dio_timer.Cancel();
+	instance->dio_timer.Schedule(MilliSeconds(ticks));
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::handle_dio_timer(rpl_instance_t *instance) {
+	if (instance->dio_send) {
+		/* send DIO if counter is less than desired redundancy, a redundancy
+		 constant of 0 disables suppression */
+		if (instance->dio_redundancy == 0
+				|| instance->dio_counter < instance->dio_redundancy) {
+#if RPL_CONF_STATS
+			instance->dio_totsend++;
+#endif /* RPL_CONF_STATS */
+			dio_output(instance, Ipv6Address::GetAny());
+		} else {
+			NS_LOG_DEBUG ("RPL: Suppressing DIO transmission (" << (uint32_t) instance->dio_counter
+					<< " >= " << (uint32_t) instance->dio_redundancy << ")");
+		}
+		instance->dio_send = 0;
+		NS_LOG_DEBUG ("RPL: Scheduling DIO timer " << instance->dio_next_delay.GetMilliSeconds ()
+				<< " ms in future");
+		instance->dio_timer.Schedule(instance->dio_next_delay);
+	} else {
+		/* check if we need to double interval */
+		if (instance->dio_intcurrent
+				< instance->dio_intmin + instance->dio_intdoubl) {
+			instance->dio_intcurrent++;
+			NS_LOG_DEBUG ("RPL: DIO Timer interval doubled " << (uint32_t) instance->dio_intcurrent);
+		}
+		new_dio_interval(instance);
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::rpl_reset_dio_timer(rpl_instance_t *instance) {
+#if !RPL_LEAF_ONLY
+	/* Do not reset if we are already on the minimum interval,
+	 unless forced to do so. */
+	if (instance->dio_intcurrent > instance->dio_intmin) {
+		instance->dio_counter = 0;
+		instance->dio_intcurrent = instance->dio_intmin;
+		new_dio_interval(instance);
+	}
+#endif /* RPL_LEAF_ONLY */
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::handle_dao_timer(rpl_instance_t *instance) {
+	if (instance->current_dag == NULL
+			|| instance->current_dag->preferred_parent == NULL) {
+		NS_LOG_DEBUG ("RPL: No suitable DAO parent");
+		return;
+	}
+
+	dao_output(instance->current_dag->preferred_parent,
+			instance->default_lifetime);
+
+	if (instance->default_lifetime != RPL_INFINITE_LIFETIME) {
+		/* Refresh the downward routes before they expire along the path. */
+		instance->dao_timer.Schedule(
+				Seconds(RPL_LIFETIME(instance, instance->default_lifetime) / 2.0));
+	}
+}
+/*---------------------------------------------------------------------------*/
+void RoutingProtocol::rpl_schedule_dao(rpl_instance_t *instance) {
+	int64_t latency = Time(RPL_DAO_LATENCY).GetMilliSeconds();
+	Time expiration = MilliSeconds(
+			latency / 2 + m_uniformRandomVariable->GetInteger(0, latency - 1));
+
+	if (instance->dao_timer.IsRunning()
+			&& instance->dao_timer.GetDelayLeft() <= expiration) {
+		NS_LOG_DEBUG ("RPL: DAO timer already scheduled");
+		return;
+	}
+
+	NS_LOG_DEBUG ("RPL: Scheduling DAO timer " << expiration.GetMilliSeconds ()
+			<< " ms in the future");
+	instance->dao_timer.Cancel();
+	instance->dao_timer.Schedule(expiration);
+}
+/*---------------------------------------------------------------------------*/
+/* Fill a new RPL option of the default instance in, for a packet whose
+ IPv6 header is updated to carry it. */
+int RoutingProtocol::rpl_update_header_empty(RplHopByHopHeader &option,
+		Ipv6Header &header) {
+	rpl_instance_t *instance = default_instance;
+
+	if (instance == NULL || !instance->used || instance->current_dag == NULL
+			|| !instance->current_dag->joined) {
+		NS_LOG_DEBUG ("RPL: Unable to add the RPL option, not joined");
+		return 1;
+	}
+
+	option.SetNextHeader(header.GetNextHeader());
+	option.SetFlags(0);
+	option.SetInstanceID(instance->instance_id);
+	header.SetNextHeader(Ipv6Header::IPV6_EXT_HOP_BY_HOP);
+	header.SetPayloadLength(
+			header.GetPayloadLength() + option.GetSerializedSize());
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Set the direction and the sender rank of the RPL option of a packet sent
+ along a downward route if down, upward otherwise. */
+int RoutingProtocol::rpl_update_header_final(RplHopByHopHeader &option,
+		bool down) {
+	rpl_instance_t *instance = rpl_get_instance(option.GetInstanceID());
+	uint8_t flags = option.GetFlags();
+
+	if (instance == NULL || instance->current_dag == NULL
+			|| !instance->current_dag->joined) {
+		return 1;
+	}
+
+	if ((flags & RPL_HDR_OPT_DOWN) && !down) {
+		/* A packet going down should not go up again (section 11.2.2.3):
+		 it goes back with the F flag to the node that sent it down, which
+		 removes its stale route. */
+		NS_LOG_DEBUG ("RPL: Forwarding error, no downward route");
+		RPL_STAT(rpl_stats.forward_errors++);
+		flags |= RPL_HDR_OPT_FWD_ERR;
+	} else if (down) {
+		flags |= RPL_HDR_OPT_DOWN;
+	} else {
+		flags &= ~RPL_HDR_OPT_DOWN;
+	}
+	option.SetFlags(flags);
+	option.SetSenderRank(instance->current_dag->rank);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Check the RPL option of a packet to forward to dst. Return 1 if the
+ packet must be dropped; a first rank inconsistency is only flagged in the
+ option. */
+int RoutingProtocol::rpl_verify_header(RplHopByHopHeader &option,
+		Ipv6Address dst, Ipv6Address from) {
+	rpl_instance_t *instance = rpl_get_instance(option.GetInstanceID());
+	int down, sender_closer;
+	rpl_rank_t sender_rank;
+
+	if (instance == NULL) {
+		NS_LOG_DEBUG ("RPL: Unknown instance: "
+				<< (uint32_t) option.GetInstanceID());
+		return 1;
+	}
+
+	if (option.GetFlags() & RPL_HDR_OPT_FWD_ERR) {
+		/* The child we sent the packet to has no route to dst: remove our
+		 downward route through it, and drop the packet which is not
+		 routable. Only that child may remove the route. */
+		DaoRoutingTableEntry rt;
+		NS_LOG_DEBUG ("RPL: Forwarding error to " << dst << " from " << from);
+		if (m_daoRoutingTable.LookupRoute(dst, rt) && rt.GetNextHop() == from) {
+			m_daoRoutingTable.DeleteRoute(dst);
+			if (rt.GetPrefixLength() < 128) {
+				m_routingTable.DeleteRoute(dst, rt.GetPrefixLength());
+			}
+		}
+		rpl_reset_dio_timer(instance);
+		return 1;
+	}
+
+	if (instance->current_dag == NULL || !instance->current_dag->joined) {
+		NS_LOG_DEBUG ("RPL: No DAG in the instance");
+		return 1;
+	}
+
+	down = (option.GetFlags() & RPL_HDR_OPT_DOWN) != 0;
+	sender_rank = option.GetSenderRank();
+	sender_closer = sender_rank < instance->current_dag->rank;
+
+	if ((down && !sender_closer) || (!down && sender_closer)) {
+		NS_LOG_DEBUG ("RPL: Loop detected - sender rank: " << sender_rank
+				<< " my rank: " << instance->current_dag->rank
+				<< " sender closer: " << sender_closer);
+		if (option.GetFlags() & RPL_HDR_OPT_RANK_ERR) {
+			/* A second inconsistency on the path: the loop is real, the
+			 Trickle reset repairs it (section 11.2.2.2). */
+			NS_LOG_DEBUG ("RPL: Rank error signalled in RPL option");
+			RPL_STAT(rpl_stats.loop_errors++);
+			rpl_reset_dio_timer(instance);
+			return 1;
+		}
+		NS_LOG_DEBUG ("RPL: Single error tolerated");
+		RPL_STAT(rpl_stats.loop_warnings++);
+		option.SetFlags(option.GetFlags() | RPL_HDR_OPT_RANK_ERR);
+	}
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Remove the RPL option of a packet leaving the DODAG. */
+void RoutingProtocol::rpl_remove_header(Ptr<Packet> packet,
+		Ipv6Header &header) {
+	RplHopByHopHeader option;
+
+	packet->RemoveHeader(option);
+	header.SetNextHeader(option.GetNextHeader());
+	header.SetPayloadLength(
+			header.GetPayloadLength() - option.GetSerializedSize());
+}
+/*---------------------------------------------------------------------------*/
 /*----------Code from Contiki-----------------*/
 
 }
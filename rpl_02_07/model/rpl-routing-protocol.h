@@ -22,8 +22,12 @@
 #define RPL_ROUTING_PROTOCOL_H
 
 #include "rpl-rtable.h"
+#include "rpl-dao-table.h"
 #include "rpl-packet-queue.h"
 #include "rpl-packet.h"
+#include "rpl-of.h"
+#include "rpl-link-estimator.h"
+#include "rpl-timer-wheel.h"
 #include "rpl-conf.h"
 #include "ns3/node.h"
 #include "ns3/random-variable-stream.h"
@@ -34,6 +38,7 @@
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6-routing-table-entry.h"
 #include "ns3/timer.h"
+#include "ns3/traced-callback.h"
 
 namespace ns3 {
 namespace rpl {
@@ -89,6 +94,9 @@ public:
 	bool GetEnableRAFlag() const;
 	// \}
 
+	/// \return the number of upward, downward and source routes of the node
+	uint32_t GetNRoutes();
+
 	/**
 	 * Assign a fixed random variable stream number to the random variables
 	 * used by this model.  Return the number of streams (possibly zero) that
@@ -108,16 +116,17 @@ public:
 	void rpl_init(void);
 	void uip_rpl_input(void);
 	rpl_dag_t *rpl_set_root(uint8_t instance_id, Ipv6Address dag_id);
-	int rpl_set_prefix(rpl_dag_t *dag, Ipv6Prefix prefix, unsigned len);
+	int rpl_set_prefix(rpl_dag_t *dag, Ipv6Address prefix, unsigned len);
 	int rpl_repair_root(uint8_t instance_id);
 	int rpl_set_default_route(rpl_instance_t *instance, Ipv6Address from);
 	rpl_dag_t *rpl_get_any_dag(void);
 	rpl_instance_t *rpl_get_instance(uint8_t instance_id);
-	void rpl_update_header_empty(void);
-	int rpl_update_header_final(Ipv6Address addr);
-	int rpl_verify_header(int);
-	void rpl_remove_header(void);
-	uint8_t rpl_invert_header(void);
+	/* RPL option of the data packets (RFC 6553). */
+	int rpl_update_header_empty(RplHopByHopHeader &option, Ipv6Header &header);
+	int rpl_update_header_final(RplHopByHopHeader &option, bool down);
+	int rpl_verify_header(RplHopByHopHeader &option, Ipv6Address dst,
+			Ipv6Address from);
+	void rpl_remove_header(Ptr<Packet> packet, Ipv6Header &header);
 	/*---------------------------------------------------------------------------*/
 
 #if RPL_CONF_STATS
@@ -127,23 +136,38 @@ public:
 #endif /* RPL_CONF_STATS */
 	/*---------------------------------------------------------------------------*/
 	/* Instances */
-	rpl_instance_t instance_table[RPL_MAX_INSTANCES];
+	std::vector<rpl_instance_t> instance_table;
 	rpl_instance_t *default_instance;
-	std::list<rpl_dag_t> parents_list;
+	/* instance_table entry of each instance ID, NULL if not joined */
+	rpl_instance_t *instance_index[256];
+	/* storage of the DAGs of the instances */
+	std::vector<rpl_dag_t> dag_storage;
+	/* DAGs of each instance_table entry by DAG ID */
+	typedef sgi::hash_map<Ipv6Address, rpl_dag_t *, Ipv6AddressHash> DagIndex;
+	std::vector<DagIndex> dag_index;
 	rpl_dag_t *m_dag;
 
 	/* ICMPv6 functions for RPL. */
+	void dis_input(Ipv6Address from, Ptr<Packet> packet, bool multicast);
 	void dis_output(Ipv6Address addr);
+	void dio_input(Ipv6Address from, Ipv6Address to, Ptr<Packet> packet);
 	void dio_output(rpl_instance_t *, Ipv6Address uc_addr);
+	void dao_input(Ipv6Address from, Ptr<Packet> packet);
+	void dao_input_nonstoring(rpl_instance_t *, Ipv6Address from,
+			DAOPacket const & dao);
 	void dao_output(rpl_parent_t *, uint8_t lifetime);
+	void dao_aggregate(rpl_instance_t *, rpl_dao_target_t const & target);
+	void dao_ack_input(Ipv6Address from, Ptr<Packet> packet);
 	void dao_ack_output(rpl_instance_t *, Ipv6Address , uint8_t);
 
 	/* RPL logic functions. */
 	void rpl_join_dag(Ipv6Address from, rpl_dio_t *dio);
 	void rpl_join_instance(Ipv6Address from, rpl_dio_t *dio);
 	void rpl_local_repair(rpl_instance_t *instance);
+	void rpl_global_repair(Ipv6Address from, rpl_dag_t *dag, rpl_dio_t *dio);
 	void rpl_process_dio(Ipv6Address , rpl_dio_t *);
 	int rpl_process_parent_event(rpl_instance_t *, rpl_parent_t *);
+	void rpl_link_neighbor_callback(Ipv6Address addr, uint8_t etx);
 
 	/* DAG object management. */
 	rpl_dag_t *rpl_alloc_dag(uint8_t, Ipv6Address);
@@ -158,6 +182,7 @@ public:
 			Ipv6Address addr);
 	void rpl_nullify_parent(rpl_dag_t *, rpl_parent_t *);
 	void rpl_remove_parent(rpl_dag_t *, rpl_parent_t *);
+	void rpl_sort_parent(rpl_dag_t *, rpl_parent_t *);
 	void rpl_move_parent(rpl_dag_t *dag_src, rpl_dag_t *dag_dst,
 			rpl_parent_t *parent);
 	rpl_parent_t *rpl_select_parent(rpl_dag_t *dag);
@@ -167,8 +192,8 @@ public:
 	/* RPL routing table functions. */
 	void rpl_remove_routes(rpl_dag_t *dag);
 	void rpl_remove_routes_by_nexthop(Ipv6Address nexthop, rpl_dag_t *dag);
-	Ipv6RoutingTableEntry *rpl_add_route(rpl_dag_t *dag, Ipv6Prefix prefix,
-			int prefix_len, Ipv6Address next_hop);
+	bool rpl_add_route(rpl_dag_t *dag, Ipv6Address prefix, int prefix_len,
+			Ipv6Address next_hop);
 	void rpl_purge_routes(void);
 
 	/* Objective function. */
@@ -214,14 +239,38 @@ private:
 	RoutingTable m_routingTable;
 	/// Advertised Routing table for the node
 	RoutingTable m_advRoutingTable;
+	/// Downward routes learned from DAOs (storing mode)
+	DaoRoutingTable m_daoRoutingTable;
+	/// DAO parent graph of the DODAG root (non-storing mode)
+	SourceRoutingTable m_sourceRoutingTable;
+	/// ETX of the links to the neighbors
+	LinkEstimator m_linkEstimator;
+	/// Sequence number of the DAOs sent by this node
+	uint8_t m_daoSequence;
+	/// Path Sequence of the Transit option advertising this node
+	uint8_t m_pathSequence;
+	/// Number of RPL instances the node can join
+	uint32_t m_maxInstances;
+	/// Number of DAGs of an instance the node can track
+	uint32_t m_maxDagsPerInstance;
+	/// Mode of operation of the DAGs rooted here, one of RPL_MOP_*
+	uint8_t m_mop;
+	/// Minimum time between two repairs of an instance
+	Time m_minRepairInterval;
 	/// The maximum number of packets that we allow a routing protocol to buffer.
 	uint32_t m_maxQueueLen;
 	/// The maximum number of packets that we allow per destination to buffer.
 	uint32_t m_maxQueuedPacketsPerDst;
 	/// The maximum period of time that a routing protocol is allowed to buffer a packet for.
 	Time m_maxQueueTime;
-	/// A "drop front on full" queue used by the routing layer to buffer packets to which it does not have a route.
+	/// The maximum number of bytes that we allow a routing protocol to buffer.
+	uint32_t m_maxQueueBytes;
+	/// What to drop when the buffer is full
+	PacketQueue::DropPolicy m_queueDropPolicy;
+	/// Queue used by the routing layer to buffer packets to which it does not have a route, dropping by m_queueDropPolicy when full.
 	PacketQueue m_queue;
+	/// Destinations whose DrainQueue is scheduled
+	std::set<Ipv6Address> m_drainPending;
 	/// Flag that is used to enable or disable buffering
 	bool EnableBuffering;
 	/// Flag that is used to enable or disable Weighted Settling Time
@@ -233,6 +282,10 @@ private:
 	bool EnableRouteAggregation;
 	/// Parameter that holds the route aggregation time interval
 	Time m_routeAggregationTime;
+	/// Duration of a tick of the settling time wheel
+	Time m_settlingTick;
+	/// Settling times of the routes waiting in the advertised table
+	TimerWheel m_settlingWheel;
 	/// Unicast callback for own packets
 	UnicastForwardCallback m_scb;
 	/// Multicast callback for own packets
@@ -249,9 +302,18 @@ private:
 	void
 	DeferredRouteOutput(Ptr<const Packet> p, const Ipv6Header & header,
 			UnicastForwardCallback ucb, ErrorCallback ecb);
-	/// Look for any queued packets to send them out
+	/// Drain the queued packets of dst, if any, now that a route to dst arrived
+	void
+	HandleRouteArrival(Ipv6Address dst);
+	/// Schedule a jittered DrainQueue of dst, unless one is pending
+	void
+	ScheduleDrain(Ipv6Address dst);
+	/// Send the first queued packet of dst through its current route, then schedule the next one
+	void
+	DrainQueue(Ipv6Address dst);
+	/// Fire the drop trace matching the reason a queued packet was dropped
 	void
-	LookForQueuedPackets(void);
+	QueueDrop(QueueEntry const & entry, PacketQueue::DropReason reason);
 	/**
 	 * Send packet from queue
 	 * \param dst - destination address to which we are sending the packet to
@@ -270,11 +332,96 @@ private:
 	// \}
 	void
 	Send(Ptr<Ipv6Route>, Ptr<const Packet>, const Ipv6Header &);
+	/// Send a RPL control message, through route if it is given
+	void
+	RPLSend(Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, uint8_t ttl,
+			Ptr<Ipv6Route> route = 0);
+	/// Create a route to an on-link neighbor, for unicast control messages
+	Ptr<Ipv6Route>
+	NeighborRoute(Ipv6Address neighbor) const;
+	/**
+	 * Build the source route to dst, if this node is the root of a
+	 * non-storing DODAG.
+	 * \param dst the destination address
+	 * \param hops receives the hops from the first one to dst
+	 * \return true if dst is reachable by source routing
+	 */
+	bool
+	LookupSourceRoute(Ipv6Address dst, std::vector<Ipv6Address> & hops) const;
+	/**
+	 * Source route a downward packet from the root of a non-storing DODAG:
+	 * the packet is encapsulated behind a Source Routing Header (RFC 6554)
+	 * and sent to the first hop.
+	 * \param p the packet
+	 * \param header its IPv6 header
+	 * \param looped true if the packet was looped back by RouteOutput
+	 * \param ucb the forwarding callback
+	 * \return false if the destination is not reachable by source routing
+	 */
+	bool
+	SourceRouteOutput(Ptr<const Packet> p, const Ipv6Header & header,
+			bool looped, UnicastForwardCallback ucb);
+	/**
+	 * Process the Source Routing Header of a packet addressed to this node:
+	 * forward the packet to the next address, or decapsulate it if this node
+	 * is the last one.
+	 */
 	void
-	RPLSend(Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, uint8_t ttl);
+	ForwardSourceRoute(Ptr<const Packet> p, const Ipv6Header & header,
+			int32_t iif, UnicastForwardCallback ucb, LocalDeliverCallback lcb,
+			ErrorCallback ecb);
 	/// Create loopback route for given header
 	Ptr<Ipv6Route>
 	LoopbackRoute(const Ipv6Header & header, Ptr<NetDevice> oif) const;
+	/**
+	 * Forward a unicast packet along the route to its destination.
+	 * \param p the packet
+	 * \param header its IPv6 header
+	 * \param looped whether the packet is ours, looped back by RouteOutput
+	 * \param ucb the unicast forward callback
+	 * \param ecb the error callback, called if the packet is dropped
+	 * \return false if there is no route to the destination
+	 */
+	bool
+	UnicastForward(Ptr<const Packet> p, const Ipv6Header & header, bool looped,
+			UnicastForwardCallback ucb, ErrorCallback ecb);
+	/**
+	 * Mark a packet as sent by this node to a neighbor, for the link
+	 * estimator and for the neighbor, which learns where it came from.
+	 * \param packet the packet
+	 * \param nextHop the neighbor
+	 */
+	void
+	SetNextHop(Ptr<Packet> packet, Ipv6Address nextHop);
+	/**
+	 * Tell whether a route follows the DODAG of the default instance, so
+	 * that the packets sent along it carry the RPL option.
+	 * \param route the route
+	 * \param down whether the route is a downward route learned from a DAO
+	 */
+	bool
+	IsDodagRoute(Ptr<Ipv6Route> route, bool down) const;
+	/**
+	 * \return true if the packet starts with a Hop-by-Hop Options header
+	 * holding the RPL option alone
+	 */
+	static bool
+	HasRplOption(Ptr<const Packet> p, const Ipv6Header & header);
+	/**
+	 * Check and update the RPL option of a packet sent along a route. The
+	 * option is inserted in the packets entering the DODAG and removed from
+	 * those leaving it.
+	 * \param packet the packet, whose option is edited in place
+	 * \param header its IPv6 header, changed when the option is inserted or
+	 * removed
+	 * \param route the route, replaced by the route back to the sender of a
+	 * packet going down which has no downward route here
+	 * \param down whether the route is a downward route learned from a DAO
+	 * \return false if the packet must be dropped
+	 */
+	bool
+	RplOptionForward(Ptr<Packet> packet, Ipv6Header & header,
+			Ptr<Ipv6Route> & route, bool down);
 	/**
 	 * Get settlingTime for a destination
 	 * \param dst - destination address
@@ -282,28 +429,127 @@ private:
 	 */
 	Time
 	GetSettlingTime(Ipv6Address dst);
+	/// Remove the routes whose lifetime expired and advertise them as broken
+	void
+	PurgeExpiredRoutes();
+	/// Arm m_routeExpiryTimer for the next route deadline of the routing table
+	void
+	ScheduleRouteExpiry();
 	/// Sends trigger update from a node
 	void
 	SendTriggeredUpdate();
 	/// Broadcasts the entire routing table for every PeriodicUpdateInterval
 	void
 	SendPeriodicUpdate();
-	/// Multicast DIO controlling messages in PeriodicUpdateInterval
+	/// Receive and dispatch RPL ICMPv6 control messages (DIS/DIO/DAO)
 	void
-	SendPeriodicDIOPacket(Ipv6Address src, Ipv6Address dst,
-			Address* hardwareAddress, uint8_t flags, rpl_instance_t *instance);
+	RecvRplControl(Ptr<Socket> socket);
+	/**
+	 * Start a new Trickle interval for the DIO timer of an instance (RFC 6206, 4.2 step 1/2).
+	 * \param instance the RPL instance whose DIO timer is restarted
+	 */
+	void
+	new_dio_interval(rpl_instance_t *instance);
+	/**
+	 * DIO Trickle timer handler: transmits at time t unless suppressed by the
+	 * redundancy counter, then doubles the interval when it expires.
+	 * \param instance the RPL instance owning the timer
+	 */
+	void
+	handle_dio_timer(rpl_instance_t *instance);
+	/// DIS timer handler: solicits DIOs while the node has not joined a DAG
+	void
+	handle_dis_timer();
+	/**
+	 * Send the unicast DIO of an instance that replies to a multicast DIS,
+	 * unless the instance left its DAG meanwhile.
+	 * \param instance_id the instance whose DIO is sent
+	 * \param to the node that sent the DIS
+	 */
+	void
+	dis_reply(uint8_t instance_id, Ipv6Address to);
+	/**
+	 * Cancel the pending replies of an instance to multicast DIS, as a
+	 * multicast DIO of its DAG already reached the soliciting nodes.
+	 * \param instance_id the instance whose replies are cancelled
+	 */
+	void
+	cancel_dis_replies(uint8_t instance_id);
+	/**
+	 * Rate limit the repairs of an instance to one per MinRepairInterval.
+	 * \param instance the RPL instance to repair
+	 * \return true if the repair is deferred to the end of the interval,
+	 * false if it may be advertised now
+	 */
+	bool
+	repair_held_off(rpl_instance_t *instance);
+	/**
+	 * Repair timer handler: advertises the repair deferred by
+	 * repair_held_off, a DODAG version increment at the root and the
+	 * poisoning of the detached node elsewhere.
+	 * \param instance the RPL instance owning the timer
+	 */
+	void
+	handle_repair_timer(rpl_instance_t *instance);
+	/**
+	 * DAO timer handler: advertises this node and the aggregated child
+	 * targets to its preferred parent, and schedules the refresh of the
+	 * advertisement before its lifetime ends.
+	 * \param instance the RPL instance owning the timer
+	 */
+	void
+	handle_dao_timer(rpl_instance_t *instance);
+	/**
+	 * Send the targets in as few DAOs of at most RPL_DAO_MAX_SIZE as possible.
+	 * \param instance the RPL instance of the DAO
+	 * \param dest the parent in storing mode, the DODAG root in non-storing mode
+	 * \param targets the targets and their Transit information
+	 */
+	void
+	SendDao(rpl_instance_t *instance, Ipv6Address dest,
+			std::vector<rpl_dao_target_t> const & targets);
+	/// Remove the downward routes and DAO parents whose lifetime expired
+	void
+	PurgeExpiredDaoRoutes();
+	/// Arm m_daoExpiryTimer for the next deadline of the downward routes and DAO parents
+	void
+	ScheduleDaoExpiry();
 	void
 	MergeTriggerPeriodicUpdates();
 	/// Notify that packet is dropped for some reason
 	void
 	Drop(Ptr<const Packet>, const Ipv6Header &, Socket::SocketErrno);
+	/// Raw ICMPv6 socket receiving RPL control messages
+	Ptr<Socket> m_rplSocket;
 	/// Timer to trigger periodic updates from a node
 	Timer m_periodicUpdateTimer;
 	/// Timer used by the trigger updates in case of Weighted Settling Time is used
 	Timer m_triggeredExpireTimer;
+	/// Timer sweeping expired routes out of the routing table
+	Timer m_routeExpiryTimer;
+	/// Timer sweeping expired downward routes out of the DAO tables
+	Timer m_daoExpiryTimer;
+	/// Timer sending DIS until the node joins a DAG
+	Timer m_disTimer;
+	/// Pending DIO replies to multicast DIS, by instance and soliciting node
+	typedef std::map<std::pair<uint8_t, Ipv6Address>, EventId> DisReplyMap;
+	DisReplyMap m_disReplies;
 
 	/// Provides uniform random variables.
 	Ptr<UniformRandomVariable> m_uniformRandomVariable;
+
+	/// Trace of the RPL control messages sent, starting with their ICMPv6 header
+	TracedCallback<Ptr<const Packet> > m_controlTxTrace;
+	/// Trace of the DAGs joined, by instance ID and DAG ID
+	TracedCallback<uint8_t, Ipv6Address> m_dagJoinTrace;
+	/// Trace of the local repairs ended, by instance ID and time the node was detached
+	TracedCallback<uint8_t, Time> m_reattachTrace;
+	/// Traces of the buffered packets dropped, one per drop reason
+	TracedCallback<Ptr<const Packet>, const Ipv6Header &> m_queueDropTailTrace;
+	TracedCallback<Ptr<const Packet>, const Ipv6Header &> m_queueDropHeadTrace;
+	TracedCallback<Ptr<const Packet>, const Ipv6Header &> m_queueDropPriorityTrace;
+	TracedCallback<Ptr<const Packet>, const Ipv6Header &> m_queueDropExpiredTrace;
+	TracedCallback<Ptr<const Packet>, const Ipv6Header &> m_queueDropFlushedTrace;
 };
 
 } /* namespace rpl */
@@ -30,6 +30,7 @@
  */
 #include "rpl-rtable.h"
 #include "ns3/simulator.h"
+#include <algorithm>
 #include <iomanip>
 #include "ns3/log.h"
 
@@ -38,6 +39,65 @@ NS_LOG_COMPONENT_DEFINE ("RplRoutingTable");
 namespace ns3 {
 namespace rpl {
 
+NextHopPool::NextHopPool ()
+  : m_purgeSize (16)
+{
+}
+
+Ptr<Ipv6Route>
+NextHopPool::Intern (Ipv6Address gateway, Ptr<NetDevice> dev, Ipv6Address source)
+{
+  Key key;
+  key.gateway = gateway;
+  key.dev = PeekPointer (dev);
+  key.source = source;
+  std::map<Key, Ptr<Ipv6Route> >::const_iterator i = m_routes.find (key);
+  if (i != m_routes.end ())
+    {
+      return i->second;
+    }
+  if (m_routes.size () >= m_purgeSize)
+    {
+      Purge ();
+      m_purgeSize = std::max<uint32_t> (16, 2 * m_routes.size ());
+    }
+  Ptr<Ipv6Route> route = Create<Ipv6Route> ();
+  route->SetDestination (gateway);
+  route->SetGateway (gateway);
+  route->SetSource (source);
+  route->SetOutputDevice (dev);
+  m_routes.insert (std::make_pair (key, route));
+  return route;
+}
+
+uint32_t
+NextHopPool::GetSize () const
+{
+  return m_routes.size ();
+}
+
+void
+NextHopPool::Purge ()
+{
+  for (std::map<Key, Ptr<Ipv6Route> >::iterator i = m_routes.begin (); i != m_routes.end (); )
+    {
+      if (i->second->GetReferenceCount () == 1)
+        {
+          m_routes.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+NextHopPool::Clear ()
+{
+  m_routes.clear ();
+}
+
 RoutingTableEntry::RoutingTableEntry (Ptr<NetDevice> dev,
                                       Ipv6Address dst,
                                       u_int32_t seqNo,
@@ -50,13 +110,16 @@ RoutingTableEntry::RoutingTableEntry (Ptr<NetDevice> dev,
   : m_seqNo (seqNo),
     m_hops (hops),
     m_lifeTime (lifetime),
+    m_dst (dst),
     m_iface (iface),
     m_flag (VALID),
     m_settlingTime (SettlingTime),
-    m_entriesChanged (areChanged)
+    m_entriesChanged (areChanged),
+    m_prefixLength (128)
 {
+  // the tables replace the route by a shared one
   m_ipv6Route = Create<Ipv6Route> ();
-  m_ipv6Route->SetDestination (dst);
+  m_ipv6Route->SetDestination (nextHop);
   m_ipv6Route->SetGateway (nextHop);
   m_ipv6Route->SetSource (m_iface.GetAddress());
   m_ipv6Route->SetOutputDevice (dev);
@@ -64,7 +127,262 @@ RoutingTableEntry::RoutingTableEntry (Ptr<NetDevice> dev,
 RoutingTableEntry::~RoutingTableEntry ()
 {
 }
+
+void
+RoutingTableEntry::SetNextHop (Ipv6Address nextHop)
+{
+  // the route may be shared, change a copy
+  m_ipv6Route = Create<Ipv6Route> (*m_ipv6Route);
+  m_ipv6Route->SetDestination (nextHop);
+  m_ipv6Route->SetGateway (nextHop);
+}
+
+void
+RoutingTableEntry::SetOutputDevice (Ptr<NetDevice> device)
+{
+  m_ipv6Route = Create<Ipv6Route> (*m_ipv6Route);
+  m_ipv6Route->SetOutputDevice (device);
+}
+
+const uint32_t RouteStore::NONE;
+
+RouteStore::RouteStore ()
+  : m_free (NONE),
+    m_size (0)
+{
+}
+
+uint32_t
+RouteStore::Find (Ipv6Address dst) const
+{
+  if (m_size == 0)
+    {
+      return NONE;
+    }
+  uint32_t mask = m_index.size () - 1;
+  for (uint32_t i = GetHome (dst); m_index[i] != NONE; i = (i + 1) & mask)
+    {
+      if (m_dsts[m_index[i]] == dst)
+        {
+          return m_index[i];
+        }
+    }
+  return NONE;
+}
+
+uint32_t
+RouteStore::Insert (Ipv6Address dst)
+{
+  NS_ASSERT (Find (dst) == NONE);
+  // keep the index at most half full
+  if (2 * (m_size + 1) > m_index.size ())
+    {
+      Rehash (std::max<uint32_t> (16, 2 * m_index.size ()));
+    }
+  uint32_t slot = m_free;
+  if (slot != NONE)
+    {
+      m_free = m_nextDependent[slot];
+      m_dsts[slot] = dst;
+    }
+  else
+    {
+      slot = m_dsts.size ();
+      m_dsts.push_back (dst);
+      m_routes.push_back (0);
+      m_seqNos.push_back (0);
+      m_lifeTimes.push_back (0);
+      m_settlingTimes.push_back (0);
+      m_hops.push_back (0);
+      m_ifaces.push_back (0);
+      m_flags.push_back (0);
+      m_nextDependent.push_back (NONE);
+      m_prevDependent.push_back (NONE);
+    }
+  m_flags[slot] = USED_BIT;
+  m_nextDependent[slot] = NONE;
+  m_prevDependent[slot] = NONE;
+  uint32_t mask = m_index.size () - 1;
+  uint32_t i = GetHome (dst);
+  while (m_index[i] != NONE)
+    {
+      i = (i + 1) & mask;
+    }
+  m_index[i] = slot;
+  ++m_size;
+  return slot;
+}
+
+void
+RouteStore::Erase (uint32_t slot)
+{
+  NS_ASSERT (IsUsed (slot));
+  UnlinkDependent (slot);
+  Unindex (slot);
+  m_routes[slot] = 0;
+  m_flags[slot] = 0;
+  m_nextDependent[slot] = m_free;
+  m_free = slot;
+  --m_size;
+}
+
+void
+RouteStore::Clear ()
+{
+  m_dsts.clear ();
+  m_routes.clear ();
+  m_seqNos.clear ();
+  m_lifeTimes.clear ();
+  m_settlingTimes.clear ();
+  m_hops.clear ();
+  m_ifaces.clear ();
+  m_flags.clear ();
+  m_nextDependent.clear ();
+  m_prevDependent.clear ();
+  m_ifaceAddresses.clear ();
+  m_index.clear ();
+  m_dependents.clear ();
+  m_free = NONE;
+  m_size = 0;
+}
+
+uint32_t
+RouteStore::Next (uint32_t slot) const
+{
+  while (slot < m_flags.size () && !IsUsed (slot))
+    {
+      ++slot;
+    }
+  return slot;
+}
+
+uint32_t
+RouteStore::GetFirstDependent (Ipv6Address nextHop) const
+{
+  std::map<Ipv6Address, uint32_t>::const_iterator i = m_dependents.find (nextHop);
+  return i == m_dependents.end () ? NONE : i->second;
+}
+
+void
+RouteStore::SetRoute (uint32_t slot, Ptr<Ipv6Route> route)
+{
+  if (m_routes[slot] != 0 && route != 0 && m_routes[slot]->GetGateway () == route->GetGateway ())
+    {
+      m_routes[slot] = route;
+      return;
+    }
+  UnlinkDependent (slot);
+  m_routes[slot] = route;
+  LinkDependent (slot);
+}
+
+void
+RouteStore::SetInterface (uint32_t slot, Ipv6InterfaceAddress iface)
+{
+  for (uint32_t i = 0; i < m_ifaceAddresses.size (); ++i)
+    {
+      if (m_ifaceAddresses[i] == iface)
+        {
+          m_ifaces[slot] = i;
+          return;
+        }
+    }
+  NS_ASSERT_MSG (m_ifaceAddresses.size () <= 0xff, "Too many interface addresses");
+  m_ifaces[slot] = m_ifaceAddresses.size ();
+  m_ifaceAddresses.push_back (iface);
+}
+
+void
+RouteStore::Rehash (uint32_t size)
+{
+  m_index.assign (size, NONE);
+  uint32_t mask = size - 1;
+  for (uint32_t slot = Next (0); slot < m_dsts.size (); slot = Next (slot + 1))
+    {
+      uint32_t i = GetHome (m_dsts[slot]);
+      while (m_index[i] != NONE)
+        {
+          i = (i + 1) & mask;
+        }
+      m_index[i] = slot;
+    }
+}
+
+void
+RouteStore::Unindex (uint32_t slot)
+{
+  uint32_t mask = m_index.size () - 1;
+  uint32_t i = GetHome (m_dsts[slot]);
+  while (m_index[i] != slot)
+    {
+      i = (i + 1) & mask;
+    }
+  // shift back the following slots of the probe sequence, no tombstone is left
+  m_index[i] = NONE;
+  for (uint32_t j = (i + 1) & mask; m_index[j] != NONE; j = (j + 1) & mask)
+    {
+      uint32_t home = GetHome (m_dsts[m_index[j]]);
+      bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+      if (!stays)
+        {
+          m_index[i] = m_index[j];
+          m_index[j] = NONE;
+          i = j;
+        }
+    }
+}
+
+void
+RouteStore::LinkDependent (uint32_t slot)
+{
+  if (m_routes[slot] == 0)
+    {
+      return;
+    }
+  std::pair<std::map<Ipv6Address, uint32_t>::iterator, bool> head =
+    m_dependents.insert (std::make_pair (m_routes[slot]->GetGateway (), slot));
+  m_prevDependent[slot] = NONE;
+  if (head.second)
+    {
+      m_nextDependent[slot] = NONE;
+      return;
+    }
+  m_nextDependent[slot] = head.first->second;
+  m_prevDependent[head.first->second] = slot;
+  head.first->second = slot;
+}
+
+void
+RouteStore::UnlinkDependent (uint32_t slot)
+{
+  if (m_routes[slot] == 0)
+    {
+      return;
+    }
+  uint32_t next = m_nextDependent[slot];
+  uint32_t prev = m_prevDependent[slot];
+  if (next != NONE)
+    {
+      m_prevDependent[next] = prev;
+    }
+  if (prev != NONE)
+    {
+      m_nextDependent[prev] = next;
+    }
+  else if (next != NONE)
+    {
+      m_dependents[m_routes[slot]->GetGateway ()] = next;
+    }
+  else
+    {
+      m_dependents.erase (m_routes[slot]->GetGateway ());
+    }
+  m_nextDependent[slot] = NONE;
+  m_prevDependent[slot] = NONE;
+}
+
 RoutingTable::RoutingTable ()
+  : m_nextHops (Create<NextHopPool> ())
 {
 }
 
@@ -72,16 +390,12 @@ bool
 RoutingTable::LookupRoute (Ipv6Address id,
                            RoutingTableEntry & rt)
 {
-  if (m_ipv6AddressEntry.empty ())
+  uint32_t slot = m_hostRoutes.Find (id);
+  if (slot == RouteStore::NONE)
     {
       return false;
     }
-  std::map<Ipv6Address, RoutingTableEntry>::const_iterator i = m_ipv6AddressEntry.find (id);
-  if (i == m_ipv6AddressEntry.end ())
-    {
-      return false;
-    }
-  rt = i->second;
+  Load (slot, rt);
   return true;
 }
 
@@ -90,28 +404,112 @@ RoutingTable::LookupRoute (Ipv6Address id,
                            RoutingTableEntry & rt,
                            bool forRouteInput)
 {
-  if (m_ipv6AddressEntry.empty ())
+  uint32_t slot = m_hostRoutes.Find (id);
+  if (slot == RouteStore::NONE)
     {
       return false;
     }
-  std::map<Ipv6Address, RoutingTableEntry>::const_iterator i = m_ipv6AddressEntry.find (id);
-  if (i == m_ipv6AddressEntry.end ())
+  if (forRouteInput == true && id == m_hostRoutes.GetInterface (slot).GetAddress ())
     {
       return false;
     }
-  if (forRouteInput == true && id == i->second.GetInterface ().GetAddress())
+  Load (slot, rt);
+  return true;
+}
+
+bool
+RoutingTable::LookupRoute (Ipv6Address prefix,
+                           uint8_t prefixLength,
+                           RoutingTableEntry & rt)
+{
+  RoutingTableEntry *entry = m_prefixEntry.Find (prefix, prefixLength);
+  if (entry == 0)
     {
       return false;
     }
-  rt = i->second;
+  rt = *entry;
   return true;
 }
 
+bool
+RoutingTable::LookupLongestMatch (Ipv6Address dst,
+                                  RoutingTableEntry & rt)
+{
+  if (LookupRoute (dst, rt))
+    {
+      return true;
+    }
+  RoutingTableEntry *entry = m_prefixEntry.LongestMatch (dst);
+  if (entry == 0)
+    {
+      return false;
+    }
+  rt = *entry;
+  return true;
+}
+
+Ptr<Ipv6Route>
+RoutingTable::LookupResolvedRoute (Ipv6Address dst)
+{
+  uint32_t slot = m_hostRoutes.Find (dst);
+  if (slot == RouteStore::NONE)
+    {
+      // prefix routes cover many destinations, they are resolved on each lookup
+      RoutingTableEntry *entry = m_prefixEntry.LongestMatch (dst);
+      if (entry == 0)
+        {
+          return 0;
+        }
+      return ResolveRoute (entry->GetHop (), entry->GetRoute ());
+    }
+  return ResolveRoute (m_hostRoutes.GetHop (slot), m_hostRoutes.GetRoute (slot));
+}
+
+Ptr<Ipv6Route>
+RoutingTable::ResolveRoute (uint32_t hops, Ptr<Ipv6Route> route) const
+{
+  if (hops == 1)
+    {
+      return route;
+    }
+  uint32_t n = m_hostRoutes.Find (route->GetGateway ());
+  if (n == RouteStore::NONE)
+    {
+      return 0;
+    }
+  return m_hostRoutes.GetRoute (n);
+}
+
+void
+RoutingTable::ShareRoute (RoutingTableEntry & rt)
+{
+  Ptr<Ipv6Route> route = rt.GetRoute ();
+  rt.SetRoute (m_nextHops->Intern (route->GetGateway (), route->GetOutputDevice (), route->GetSource ()));
+}
+
+void
+RoutingTable::SetNextHopPool (Ptr<NextHopPool> pool)
+{
+  NS_ASSERT (pool != 0);
+  m_nextHops = pool;
+  for (uint32_t slot = m_hostRoutes.Next (0); slot < m_hostRoutes.GetEnd (); slot = m_hostRoutes.Next (slot + 1))
+    {
+      Ptr<Ipv6Route> route = m_hostRoutes.GetRoute (slot);
+      m_hostRoutes.SetRoute (slot, pool->Intern (route->GetGateway (), route->GetOutputDevice (), route->GetSource ()));
+    }
+  for (RadixTrie<RoutingTableEntry>::Iterator p = m_prefixEntry.Begin (); p != m_prefixEntry.End (); ++p)
+    {
+      ShareRoute (*p);
+    }
+}
+
 bool
 RoutingTable::DeleteRoute (Ipv6Address dst)
 {
-  if (m_ipv6AddressEntry.erase (dst) != 0)
+  uint32_t slot = m_hostRoutes.Find (dst);
+  if (slot != RouteStore::NONE)
     {
+      EraseEntry (slot);
       // NS_LOG_DEBUG("Route erased");
       return true;
     }
@@ -121,47 +519,97 @@ RoutingTable::DeleteRoute (Ipv6Address dst)
 uint32_t
 RoutingTable::RoutingTableSize ()
 {
-  return m_ipv6AddressEntry.size ();
+  return m_hostRoutes.GetSize ();
+}
+
+bool
+RoutingTable::DeleteRoute (Ipv6Address prefix, uint8_t prefixLength)
+{
+  return m_prefixEntry.Remove (prefix, prefixLength);
 }
 
 bool
 RoutingTable::AddRoute (RoutingTableEntry & rt)
 {
-  std::pair<std::map<Ipv6Address, RoutingTableEntry>::iterator, bool> result = m_ipv6AddressEntry.insert (std::make_pair (
-                                                                                                            rt.GetDestination (),rt));
-  return result.second;
+  ShareRoute (rt);
+  if (rt.GetPrefixLength () < 128)
+    {
+      if (m_prefixEntry.Find (rt.GetDestination (), rt.GetPrefixLength ()) != 0)
+        {
+          return false;
+        }
+      m_prefixEntry.Insert (rt.GetDestination (), rt.GetPrefixLength (), rt);
+      return true;
+    }
+  if (m_hostRoutes.Find (rt.GetDestination ()) != RouteStore::NONE)
+    {
+      return false;
+    }
+  uint32_t slot = m_hostRoutes.Insert (rt.GetDestination ());
+  Store (slot, rt);
+  TrackChanged (slot);
+  PushExpiry (rt);
+  if (rt.GetFlag () == VALID)
+    {
+      NotifyArrival (slot);
+    }
+  return true;
 }
 
 bool
 RoutingTable::Update (RoutingTableEntry & rt)
 {
-  std::map<Ipv6Address, RoutingTableEntry>::iterator i = m_ipv6AddressEntry.find (rt.GetDestination ());
-  if (i == m_ipv6AddressEntry.end ())
+  ShareRoute (rt);
+  if (rt.GetPrefixLength () < 128)
+    {
+      RoutingTableEntry *entry = m_prefixEntry.Find (rt.GetDestination (), rt.GetPrefixLength ());
+      if (entry == 0)
+        {
+          return false;
+        }
+      *entry = rt;
+      return true;
+    }
+  uint32_t slot = m_hostRoutes.Find (rt.GetDestination ());
+  if (slot == RouteStore::NONE)
     {
       return false;
     }
-  i->second = rt;
+  bool refreshed = (m_hostRoutes.GetLifeTimeStart (slot) != rt.GetLifeTimeStart ()
+                    || m_hostRoutes.GetHop (slot) != rt.GetHop ());
+  bool revived = (m_hostRoutes.GetFlag (slot) == INVALID && rt.GetFlag () == VALID);
+  Store (slot, rt);
+  TrackChanged (slot);
+  if (refreshed)
+    {
+      PushExpiry (rt);
+    }
+  if (revived)
+    {
+      NotifyArrival (slot);
+    }
   return true;
 }
 
 void
 RoutingTable::DeleteAllRoutesFromInterface (Ipv6InterfaceAddress iface)
 {
-  if (m_ipv6AddressEntry.empty ())
-    {
-      return;
-    }
-  for (std::map<Ipv6Address, RoutingTableEntry>::iterator i = m_ipv6AddressEntry.begin (); i != m_ipv6AddressEntry.end (); )
+  for (RadixTrie<RoutingTableEntry>::Iterator p = m_prefixEntry.Begin (); p != m_prefixEntry.End (); )
     {
-      if (i->second.GetInterface () == iface)
+      if (p->GetInterface () == iface)
         {
-          std::map<Ipv6Address, RoutingTableEntry>::iterator tmp = i;
-          ++i;
-          m_ipv6AddressEntry.erase (tmp);
+          p = m_prefixEntry.Erase (p);
         }
       else
         {
-          ++i;
+          ++p;
+        }
+    }
+  for (uint32_t slot = m_hostRoutes.Next (0); slot < m_hostRoutes.GetEnd (); slot = m_hostRoutes.Next (slot + 1))
+    {
+      if (m_hostRoutes.GetInterface (slot) == iface)
+        {
+          EraseEntry (slot);
         }
     }
 }
@@ -169,13 +617,31 @@ RoutingTable::DeleteAllRoutesFromInterface (Ipv6InterfaceAddress iface)
 void
 RoutingTable::GetListOfAllRoutes (std::map<Ipv6Address, RoutingTableEntry> & allRoutes)
 {
-  for (std::map<Ipv6Address, RoutingTableEntry>::iterator i = m_ipv6AddressEntry.begin (); i != m_ipv6AddressEntry.end (); ++i)
+  for (ConstIterator i = Begin (VALID_ROUTES); i != End (); ++i)
     {
-      if (i->second.GetDestination () != Ipv6Address ("127.0.0.1") && i->second.GetFlag () == VALID)
-        {
-          allRoutes.insert (
-            std::make_pair (i->first,i->second));
-        }
+      RoutingTableEntry rt = *i;
+      allRoutes.insert (std::make_pair (i->GetDestination (), rt));
+    }
+}
+
+bool
+RoutingTable::IsInView (uint32_t slot, RouteFilter filter) const
+{
+  static const Ipv6Address loopback ("127.0.0.1");
+  if (!m_hostRoutes.IsUsed (slot))
+    {
+      return false;
+    }
+  return filter == ALL_ROUTES
+         || (m_hostRoutes.GetFlag (slot) == VALID && m_hostRoutes.GetDestination (slot) != loopback);
+}
+
+void
+RoutingTable::GetListOfPrefixRoutes (std::vector<RoutingTableEntry> & prefixRoutes) const
+{
+  for (RadixTrie<RoutingTableEntry>::Iterator p = m_prefixEntry.Begin (); p != m_prefixEntry.End (); ++p)
+    {
+      prefixRoutes.push_back (*p);
     }
 }
 
@@ -184,20 +650,24 @@ RoutingTable::GetListOfDestinationWithNextHop (Ipv6Address nextHop,
                                                std::map<Ipv6Address, RoutingTableEntry> & unreachable)
 {
   unreachable.clear ();
-  for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator i = m_ipv6AddressEntry.begin (); i
-       != m_ipv6AddressEntry.end (); ++i)
+  for (uint32_t slot = m_hostRoutes.GetFirstDependent (nextHop); slot != RouteStore::NONE;
+       slot = m_hostRoutes.GetNextDependent (slot))
     {
-      if (i->second.GetNextHop () == nextHop)
-        {
-          unreachable.insert (std::make_pair (i->first,i->second));
-        }
+      RoutingTableEntry rt;
+      Load (slot, rt);
+      unreachable.insert (std::make_pair (rt.GetDestination (), rt));
     }
 }
 
 void
 RoutingTableEntry::Print (Ptr<OutputStreamWrapper> stream) const
 {
-  *stream->GetStream () << std::setiosflags (std::ios::fixed) << m_ipv6Route->GetDestination () << "\t\t" << m_ipv6Route->GetGateway () << "\t\t"
+  *stream->GetStream () << std::setiosflags (std::ios::fixed) << m_dst;
+  if (m_prefixLength < 128)
+    {
+      *stream->GetStream () << "/" << (uint32_t) m_prefixLength;
+    }
+  *stream->GetStream () << "\t\t" << m_ipv6Route->GetGateway () << "\t\t"
                         << m_iface.GetAddress() << "\t\t" << std::setiosflags (std::ios::left)
                         << std::setw (10) << m_hops << "\t" << std::setw (10) << m_seqNo << "\t"
                         << std::setprecision (3) << (Simulator::Now () - m_lifeTime).GetSeconds ()
@@ -207,145 +677,173 @@ RoutingTableEntry::Print (Ptr<OutputStreamWrapper> stream) const
 void
 RoutingTable::Purge (std::map<Ipv6Address, RoutingTableEntry> & removedAddresses)
 {
-  if (m_ipv6AddressEntry.empty ())
-    {
-      return;
-    }
-  for (std::map<Ipv6Address, RoutingTableEntry>::iterator i = m_ipv6AddressEntry.begin (); i != m_ipv6AddressEntry.end (); )
+  std::vector<uint32_t> dependents;
+  Ipv6Address dst;
+  while (m_expiryIndex.PopExpired (*this, Simulator::Now (), dst))
     {
-      std::map<Ipv6Address, RoutingTableEntry>::iterator itmp = i;
-      if (i->second.GetLifeTime () > m_holddownTime && (i->second.GetHop () > 0))
+      uint32_t slot = m_hostRoutes.Find (dst);
+      RoutingTableEntry expired;
+      Load (slot, expired);
+      // collect first, erasing the dependents unlinks them
+      dependents.clear ();
+      for (uint32_t d = m_hostRoutes.GetFirstDependent (dst); d != RouteStore::NONE;
+           d = m_hostRoutes.GetNextDependent (d))
         {
-          for (std::map<Ipv6Address, RoutingTableEntry>::iterator j = m_ipv6AddressEntry.begin (); j != m_ipv6AddressEntry.end (); )
+          if (m_hostRoutes.GetHop (d) != expired.GetHop ())
             {
-              if ((j->second.GetNextHop () == i->second.GetDestination ()) && (i->second.GetHop () != j->second.GetHop ()))
-                {
-                  std::map<Ipv6Address, RoutingTableEntry>::iterator jtmp = j;
-                  removedAddresses.insert (std::make_pair (j->first,j->second));
-                  ++j;
-                  m_ipv6AddressEntry.erase (jtmp);
-                }
-              else
-                {
-                  ++j;
-                }
+              dependents.push_back (d);
             }
-          removedAddresses.insert (std::make_pair (i->first,i->second));
-          ++i;
-          m_ipv6AddressEntry.erase (itmp);
         }
-      // TODO: Need to decide when to invalidate a route
-      /*          else if (i->second.GetLifeTime() > m_holddownTime)
-       {
-       ++i;
-       itmp->second.SetFlag(INVALID);
-       }*/
-      else
+      for (std::vector<uint32_t>::const_iterator d = dependents.begin (); d != dependents.end (); ++d)
         {
-          ++i;
+          RoutingTableEntry rt;
+          Load (*d, rt);
+          removedAddresses.insert (std::make_pair (rt.GetDestination (), rt));
+          EraseEntry (*d);
+        }
+      removedAddresses.insert (std::make_pair (dst,expired));
+      slot = m_hostRoutes.Find (dst);
+      if (slot != RouteStore::NONE)
+        {
+          EraseEntry (slot);
         }
     }
-  return;
+  // TODO: Need to decide when to invalidate a route
+}
+
+bool
+RoutingTable::GetNextExpiry (Time & expiry)
+{
+  return m_expiryIndex.GetNextExpiry (*this, expiry);
 }
 
 void
-RoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
+RoutingTable::Clear ()
 {
-  *stream->GetStream () << "\nRPL Routing table\n" << "Destination\t\tGateway\t\tInterface\t\tHopCount\t\tSeqNum\t\tLifeTime\t\tSettlingTime\n";
-  for (std::map<Ipv6Address, RoutingTableEntry>::const_iterator i = m_ipv6AddressEntry.begin (); i
-       != m_ipv6AddressEntry.end (); ++i)
+  m_hostRoutes.Clear ();
+  m_changedEntries.clear ();
+  m_prefixEntry.Clear ();
+  m_expiryIndex.Clear ();
+}
+
+void
+RoutingTable::Setholddowntime (Time t)
+{
+  m_holddownTime = t;
+  // deadlines depend on the hold down time, rebuild the index
+  m_expiryIndex.Clear ();
+  for (uint32_t slot = m_hostRoutes.Next (0); slot < m_hostRoutes.GetEnd (); slot = m_hostRoutes.Next (slot + 1))
     {
-      i->second.Print (stream);
+      RoutingTableEntry rt;
+      Load (slot, rt);
+      PushExpiry (rt);
     }
-  *stream->GetStream () << "\n";
 }
 
-bool
-RoutingTable::AddIpv6Event (Ipv6Address address,
-                            EventId id)
+void
+RoutingTable::Load (uint32_t slot, RoutingTableEntry & rt) const
 {
-  std::pair<std::map<Ipv6Address, EventId>::iterator, bool> result = m_ipv6Events.insert (std::make_pair (address,id));
-  return result.second;
+  rt.m_seqNo = m_hostRoutes.GetSeqNo (slot);
+  rt.m_hops = m_hostRoutes.GetHop (slot);
+  rt.m_lifeTime = m_hostRoutes.GetLifeTimeStart (slot);
+  rt.m_dst = m_hostRoutes.GetDestination (slot);
+  rt.m_ipv6Route = m_hostRoutes.GetRoute (slot);
+  rt.m_iface = m_hostRoutes.GetInterface (slot);
+  rt.m_flag = m_hostRoutes.GetFlag (slot);
+  rt.m_settlingTime = m_hostRoutes.GetSettlingTime (slot);
+  rt.m_entriesChanged = m_hostRoutes.GetEntriesChanged (slot);
+  rt.m_prefixLength = 128;
 }
 
-bool
-RoutingTable::AnyRunningEvent (Ipv6Address address)
+void
+RoutingTable::Store (uint32_t slot, RoutingTableEntry const & rt)
+{
+  m_hostRoutes.SetRoute (slot, rt.GetRoute ());
+  m_hostRoutes.SetSeqNo (slot, rt.GetSeqNo ());
+  m_hostRoutes.SetHop (slot, rt.GetHop ());
+  m_hostRoutes.SetLifeTimeStart (slot, rt.GetLifeTimeStart ());
+  m_hostRoutes.SetSettlingTime (slot, rt.GetSettlingTime ());
+  m_hostRoutes.SetFlag (slot, rt.GetFlag ());
+  m_hostRoutes.SetEntriesChanged (slot, rt.GetEntriesChanged ());
+  m_hostRoutes.SetInterface (slot, rt.GetInterface ());
+}
+
+void
+RoutingTable::EraseEntry (uint32_t slot)
+{
+  m_changedEntries.erase (slot);
+  m_hostRoutes.Erase (slot);
+}
+
+void
+RoutingTable::NotifyArrival (uint32_t slot) const
 {
-  EventId event;
-  std::map<Ipv6Address, EventId>::const_iterator i = m_ipv6Events.find (address);
-  if (m_ipv6Events.empty ())
+  if (m_routeArrival.IsNull ())
     {
-      return false;
+      return;
     }
-  if (i == m_ipv6Events.end ())
+  Ipv6Address dst = m_hostRoutes.GetDestination (slot);
+  m_routeArrival (dst);
+  // the routes through dst resolve now
+  for (uint32_t d = m_hostRoutes.GetFirstDependent (dst); d != RouteStore::NONE; d = m_hostRoutes.GetNextDependent (d))
     {
-      return false;
+      if (d != slot && m_hostRoutes.GetFlag (d) == VALID)
+        {
+          m_routeArrival (m_hostRoutes.GetDestination (d));
+        }
     }
-  event = i->second;
-  if (event.IsRunning ())
+}
+
+void
+RoutingTable::TrackChanged (uint32_t slot)
+{
+  if (m_hostRoutes.GetEntriesChanged (slot) && IsInView (slot, VALID_ROUTES))
     {
-      return true;
+      m_changedEntries.insert (slot);
     }
   else
     {
-      return false;
+      m_changedEntries.erase (slot);
     }
 }
 
-bool
-RoutingTable::ForceDeleteIpv6Event (Ipv6Address address)
+void
+RoutingTable::PushExpiry (RoutingTableEntry const & rt)
 {
-  EventId event;
-  std::map<Ipv6Address, EventId>::const_iterator i = m_ipv6Events.find (address);
-  if (m_ipv6Events.empty () || i == m_ipv6Events.end ())
+  // local and interface routes (hop count 0) never expire
+  if (rt.GetHop () == 0)
     {
-      return false;
+      return;
     }
-  event = i->second;
-  Simulator::Cancel (event);
-  m_ipv6Events.erase (address);
-  return true;
+  m_expiryIndex.Push (rt.GetDestination (), rt.GetLifeTimeStart () + m_holddownTime);
 }
 
 bool
-RoutingTable::DeleteIpv6Event (Ipv6Address address)
+RoutingTable::IsCurrentDeadline (Ipv6Address dst, Time expire) const
 {
-  EventId event;
-  std::map<Ipv6Address, EventId>::const_iterator i = m_ipv6Events.find (address);
-  if (m_ipv6Events.empty () || i == m_ipv6Events.end ())
-    {
-      return false;
-    }
-  event = i->second;
-  if (event.IsRunning ())
+  uint32_t slot = m_hostRoutes.Find (dst);
+  if (slot == RouteStore::NONE || m_hostRoutes.GetHop (slot) == 0)
     {
       return false;
     }
-  if (event.IsExpired ())
-    {
-      event.Cancel ();
-      m_ipv6Events.erase (address);
-      return true;
-    }
-  else
-    {
-      m_ipv6Events.erase (address);
-      return true;
-    }
+  return (m_hostRoutes.GetLifeTimeStart (slot) + m_holddownTime == expire);
 }
 
-EventId
-RoutingTable::GetEventId (Ipv6Address address)
+void
+RoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
 {
-  std::map <Ipv6Address, EventId>::const_iterator i = m_ipv6Events.find (address);
-  if (m_ipv6Events.empty () || i == m_ipv6Events.end ())
+  *stream->GetStream () << "\nRPL Routing table\n" << "Destination\t\tGateway\t\tInterface\t\tHopCount\t\tSeqNum\t\tLifeTime\t\tSettlingTime\n";
+  for (ConstIterator i = Begin (ALL_ROUTES); i != End (); ++i)
     {
-      return EventId ();
+      RoutingTableEntry rt = *i;
+      rt.Print (stream);
     }
-  else
+  for (RadixTrie<RoutingTableEntry>::Iterator p = m_prefixEntry.Begin (); p != m_prefixEntry.End (); ++p)
     {
-      return i->second;
+      p->Print (stream);
     }
+  *stream->GetStream () << "\n";
 }
+
 }
 }
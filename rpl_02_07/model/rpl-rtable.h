@@ -34,12 +34,17 @@
 
 #include <cassert>
 #include <map>
+#include <set>
+#include <vector>
 #include <sys/types.h>
+#include "ns3/callback.h"
 #include "ns3/ipv6.h"
 #include "ns3/ipv6-route.h"
 #include "ns3/timer.h"
 #include "ns3/net-device.h"
 #include "ns3/output-stream-wrapper.h"
+#include "rpl-radix-trie.h"
+#include "rpl-deadline-index.h"
 
 namespace ns3 {
 namespace rpl {
@@ -49,6 +54,61 @@ enum RouteFlags
   INVALID = 1,     // !< INVALID
 };
 
+/**
+ * \ingroup dsdv
+ * \brief Next hop routes shared by the routing table entries of a node
+ *
+ * A shared route holds the gateway, the source address and the output device. Its
+ * destination is the gateway, as for the routes of the neighbors: the entries keep
+ * their destination inline. Shared routes are never modified, an entry changing its
+ * next hop or its device refers to another one.
+ */
+class NextHopPool : public SimpleRefCount<NextHopPool>
+{
+public:
+  /// c-tor
+  NextHopPool ();
+  /**
+   * \return the shared route to gateway through dev from source, created if
+   * no entry uses it yet
+   */
+  Ptr<Ipv6Route>
+  Intern (Ipv6Address gateway, Ptr<NetDevice> dev, Ipv6Address source);
+  /// \return the number of shared routes
+  uint32_t
+  GetSize () const;
+  /// Drop the routes that only the pool refers to
+  void
+  Purge ();
+  /// Drop all routes
+  void
+  Clear ();
+
+private:
+  /// Identity of a shared route
+  struct Key
+  {
+    Ipv6Address gateway;
+    NetDevice *dev;
+    Ipv6Address source;
+    bool operator< (Key const & o) const
+    {
+      if (gateway != o.gateway)
+        {
+          return gateway < o.gateway;
+        }
+      if (dev != o.dev)
+        {
+          return dev < o.dev;
+        }
+      return source < o.source;
+    }
+  };
+  std::map<Key, Ptr<Ipv6Route> > m_routes;
+  /// Size of the pool at which the unused routes are purged
+  uint32_t m_purgeSize;
+};
+
 /**
  * \ingroup dsdv
  * \brief Routing table entry
@@ -65,33 +125,29 @@ public:
   Ipv6Address
   GetDestination () const
   {
-    return m_ipv6Route->GetDestination ();
+    return m_dst;
   }
+  /// \return the route to the next hop of the entry
   Ptr<Ipv6Route>
   GetRoute () const
   {
     return m_ipv6Route;
   }
+  /// Refer to a shared next hop route, its gateway is the next hop of the entry
   void
   SetRoute (Ptr<Ipv6Route> route)
   {
     m_ipv6Route = route;
   }
   void
-  SetNextHop (Ipv6Address nextHop)
-  {
-    m_ipv6Route->SetGateway (nextHop);
-  }
+  SetNextHop (Ipv6Address nextHop);
   Ipv6Address
   GetNextHop () const
   {
     return m_ipv6Route->GetGateway ();
   }
   void
-  SetOutputDevice (Ptr<NetDevice> device)
-  {
-    m_ipv6Route->SetOutputDevice (device);
-  }
+  SetOutputDevice (Ptr<NetDevice> device);
   Ptr<NetDevice>
   GetOutputDevice () const
   {
@@ -137,6 +193,12 @@ public:
   {
     return (Simulator::Now () - m_lifeTime);
   }
+  /// \return the absolute time at which the lifetime was last refreshed
+  Time
+  GetLifeTimeStart () const
+  {
+    return m_lifeTime;
+  }
   void
   SetSettlingTime (Time settlingTime)
   {
@@ -147,6 +209,17 @@ public:
   {
     return (m_settlingTime);
   }
+  /// Set the length of the destination prefix, 128 for a host route
+  void
+  SetPrefixLength (uint8_t prefixLength)
+  {
+    m_prefixLength = prefixLength;
+  }
+  uint8_t
+  GetPrefixLength () const
+  {
+    return m_prefixLength;
+  }
   void
   SetFlag (RouteFlags flag)
   {
@@ -174,12 +247,13 @@ public:
   bool
   operator== (Ipv6Address const destination) const
   {
-    return (m_ipv6Route->GetDestination () == destination);
+    return (m_dst == destination);
   }
   void
   Print (Ptr<OutputStreamWrapper> stream) const;
 
 private:
+  friend class RoutingTable;
   ///\name Fields
   // \{
   /// Destination Sequence Number
@@ -193,10 +267,11 @@ private:
    *	it is the deletion time.
    */
   Time m_lifeTime;
-  /** Ip route, include
-   *   - destination address
+  /// Destination address
+  Ipv6Address m_dst;
+  /** Route to the next hop, shared once the entry is in a table. It includes
    *   - source address
-   *   - next hop address (gateway)
+   *   - next hop address (gateway), also its destination
    *   - output device
    */
   Ptr<Ipv6Route> m_ipv6Route;
@@ -208,21 +283,460 @@ private:
   /// A node does that in hope of receiving a better update.
   Time m_settlingTime;
   /// Flag to show if any of the routing table entries were changed with the routing update.
-  uint32_t m_entriesChanged;
+  bool m_entriesChanged;
+  /// Length of the destination prefix
+  uint8_t m_prefixLength;
   //\}
 };
 
+/**
+ * \ingroup dsdv
+ * \brief Compact storage of the host routes of a routing table
+ *
+ * The fields of the routes are kept in parallel arrays indexed by slot. A route keeps
+ * its slot while it is stored and the slots of the deleted routes are reused. The
+ * destinations are found through an open addressing hash index of the slots, and the
+ * routes using the same next hop are linked together through their slots.
+ */
+class RouteStore
+{
+public:
+  /// No slot
+  static const uint32_t NONE = 0xffffffff;
+  /// c-tor
+  RouteStore ();
+  /// \return the slot of the route to dst, or NONE
+  uint32_t
+  Find (Ipv6Address dst) const;
+  /**
+   * Store a route to dst, which must not be stored yet. The other fields of the route are unset.
+   * \return the slot of the route
+   */
+  uint32_t
+  Insert (Ipv6Address dst);
+  /// Delete the route in slot
+  void
+  Erase (uint32_t slot);
+  /// Delete all routes
+  void
+  Clear ();
+  /// \return the number of routes
+  uint32_t
+  GetSize () const
+  {
+    return m_size;
+  }
+  /// \return the bound of the slots
+  uint32_t
+  GetEnd () const
+  {
+    return m_dsts.size ();
+  }
+  /// \return true if a route is stored in slot
+  bool
+  IsUsed (uint32_t slot) const
+  {
+    return (m_flags[slot] & USED_BIT) != 0;
+  }
+  /// \return the first slot in use from slot on, or GetEnd ()
+  uint32_t
+  Next (uint32_t slot) const;
+  /// \return the slot of a route using nextHop, or NONE
+  uint32_t
+  GetFirstDependent (Ipv6Address nextHop) const;
+  /// \return the slot of the next route using the next hop of the route in slot, or NONE
+  uint32_t
+  GetNextDependent (uint32_t slot) const
+  {
+    return m_nextDependent[slot];
+  }
+  ///\name Fields of the route in a slot
+  // \{
+  Ipv6Address
+  GetDestination (uint32_t slot) const
+  {
+    return m_dsts[slot];
+  }
+  Ptr<Ipv6Route>
+  GetRoute (uint32_t slot) const
+  {
+    return m_routes[slot];
+  }
+  /// Set the route to the next hop, which is the gateway of route
+  void
+  SetRoute (uint32_t slot, Ptr<Ipv6Route> route);
+  uint32_t
+  GetSeqNo (uint32_t slot) const
+  {
+    return m_seqNos[slot];
+  }
+  void
+  SetSeqNo (uint32_t slot, uint32_t seqNo)
+  {
+    m_seqNos[slot] = seqNo;
+  }
+  uint32_t
+  GetHop (uint32_t slot) const
+  {
+    return m_hops[slot];
+  }
+  /// Set the hop count, saturated to 16 bits
+  void
+  SetHop (uint32_t slot, uint32_t hops)
+  {
+    m_hops[slot] = hops > 0xffff ? 0xffff : hops;
+  }
+  Time
+  GetLifeTimeStart (uint32_t slot) const
+  {
+    return Time (m_lifeTimes[slot]);
+  }
+  void
+  SetLifeTimeStart (uint32_t slot, Time lifeTime)
+  {
+    m_lifeTimes[slot] = lifeTime.GetTimeStep ();
+  }
+  Time
+  GetSettlingTime (uint32_t slot) const
+  {
+    return Time (m_settlingTimes[slot]);
+  }
+  void
+  SetSettlingTime (uint32_t slot, Time settlingTime)
+  {
+    m_settlingTimes[slot] = settlingTime.GetTimeStep ();
+  }
+  RouteFlags
+  GetFlag (uint32_t slot) const
+  {
+    return (m_flags[slot] & INVALID_BIT) ? INVALID : VALID;
+  }
+  void
+  SetFlag (uint32_t slot, RouteFlags flag)
+  {
+    SetBit (slot, INVALID_BIT, flag == INVALID);
+  }
+  bool
+  GetEntriesChanged (uint32_t slot) const
+  {
+    return (m_flags[slot] & CHANGED_BIT) != 0;
+  }
+  void
+  SetEntriesChanged (uint32_t slot, bool entriesChanged)
+  {
+    SetBit (slot, CHANGED_BIT, entriesChanged);
+  }
+  Ipv6InterfaceAddress
+  GetInterface (uint32_t slot) const
+  {
+    return m_ifaceAddresses[m_ifaces[slot]];
+  }
+  void
+  SetInterface (uint32_t slot, Ipv6InterfaceAddress iface);
+  // \}
+
+private:
+  /// Bits of the flags of a slot
+  enum
+  {
+    USED_BIT = 1,
+    INVALID_BIT = 2,
+    CHANGED_BIT = 4,
+  };
+  void
+  SetBit (uint32_t slot, uint8_t bit, bool value)
+  {
+    m_flags[slot] = value ? (m_flags[slot] | bit) : (m_flags[slot] & ~bit);
+  }
+  /// \return the home position of dst in the index
+  uint32_t
+  GetHome (Ipv6Address dst) const
+  {
+    return Ipv6AddressHash () (dst) & (m_index.size () - 1);
+  }
+  /// Rebuild the index with size positions
+  void
+  Rehash (uint32_t size);
+  /// Drop slot from the index
+  void
+  Unindex (uint32_t slot);
+  /// Link slot to the routes using the same next hop
+  void
+  LinkDependent (uint32_t slot);
+  /// Unlink slot from the routes using the same next hop
+  void
+  UnlinkDependent (uint32_t slot);
+
+  ///\name Fields of the routes, indexed by slot
+  // \{
+  std::vector<Ipv6Address> m_dsts;
+  std::vector<Ptr<Ipv6Route> > m_routes;
+  std::vector<uint32_t> m_seqNos;
+  std::vector<int64_t> m_lifeTimes;
+  std::vector<int64_t> m_settlingTimes;
+  std::vector<uint16_t> m_hops;
+  /// Index of the interface address in m_ifaceAddresses
+  std::vector<uint8_t> m_ifaces;
+  std::vector<uint8_t> m_flags;
+  /// Next slot using the same next hop, next free slot for the free slots
+  std::vector<uint32_t> m_nextDependent;
+  std::vector<uint32_t> m_prevDependent;
+  // \}
+  /// Interface addresses of the routes
+  std::vector<Ipv6InterfaceAddress> m_ifaceAddresses;
+  /// Open addressing hash index of the slots by destination, with linear probing
+  std::vector<uint32_t> m_index;
+  /// First slot using each next hop
+  std::map<Ipv6Address, uint32_t> m_dependents;
+  /// First free slot
+  uint32_t m_free;
+  /// Number of routes
+  uint32_t m_size;
+};
+
 /**
  * \ingroup dsdv
  * \brief The Routing table used by DSDV protocol
+ *
+ * The host routes are kept in a RouteStore. The RoutingTableEntry objects given and
+ * returned by the table are copies: change an entry and Update the table with it.
  */
 class RoutingTable
 {
+  friend class DeadlineIndex<RoutingTable>;
+  typedef std::set<uint32_t> ChangedSet;
+
+public:
+  /// Callback of the destinations a host route makes reachable
+  typedef Callback<void, Ipv6Address> RouteArrivalCallback;
+
+  /// Host routes visited by a ConstIterator
+  enum RouteFilter
+  {
+    ALL_ROUTES = 0,     // !< every host route
+    VALID_ROUTES = 1,     // !< the valid host routes, those GetListOfAllRoutes copies
+  };
+
+  class RouteView;
+  friend class RouteView;
+  class ConstIterator;
+  friend class ConstIterator;
+  class ChangedIterator;
+  friend class ChangedIterator;
+  /**
+   * \brief Read-only view of a host route, read in place in the table
+   *
+   * It converts to a RoutingTableEntry copying the route.
+   */
+  class RouteView
+  {
+public:
+    Ipv6Address
+    GetDestination () const
+    {
+      return m_table->m_hostRoutes.GetDestination (m_slot);
+    }
+    Ptr<Ipv6Route>
+    GetRoute () const
+    {
+      return m_table->m_hostRoutes.GetRoute (m_slot);
+    }
+    Ipv6Address
+    GetNextHop () const
+    {
+      return GetRoute ()->GetGateway ();
+    }
+    Ptr<NetDevice>
+    GetOutputDevice () const
+    {
+      return GetRoute ()->GetOutputDevice ();
+    }
+    Ipv6InterfaceAddress
+    GetInterface () const
+    {
+      return m_table->m_hostRoutes.GetInterface (m_slot);
+    }
+    uint32_t
+    GetSeqNo () const
+    {
+      return m_table->m_hostRoutes.GetSeqNo (m_slot);
+    }
+    uint32_t
+    GetHop () const
+    {
+      return m_table->m_hostRoutes.GetHop (m_slot);
+    }
+    Time
+    GetLifeTime () const
+    {
+      return Simulator::Now () - GetLifeTimeStart ();
+    }
+    Time
+    GetLifeTimeStart () const
+    {
+      return m_table->m_hostRoutes.GetLifeTimeStart (m_slot);
+    }
+    Time
+    GetSettlingTime () const
+    {
+      return m_table->m_hostRoutes.GetSettlingTime (m_slot);
+    }
+    RouteFlags
+    GetFlag () const
+    {
+      return m_table->m_hostRoutes.GetFlag (m_slot);
+    }
+    bool
+    GetEntriesChanged () const
+    {
+      return m_table->m_hostRoutes.GetEntriesChanged (m_slot);
+    }
+    operator RoutingTableEntry () const
+    {
+      RoutingTableEntry rt;
+      m_table->Load (m_slot, rt);
+      return rt;
+    }
+
+private:
+    friend class RoutingTable;
+    friend class RoutingTable::ConstIterator;
+    friend class RoutingTable::ChangedIterator;
+    RouteView ()
+      : m_table (0),
+        m_slot (RouteStore::NONE)
+    {
+    }
+    RouteView (RoutingTable const *table, uint32_t slot)
+      : m_table (table),
+        m_slot (slot)
+    {
+    }
+    RoutingTable const *m_table;
+    uint32_t m_slot;
+  };
+
+  /**
+   * \brief Read-only iterator over a filtered view of the host routes, in slot order
+   *
+   * Updating or deleting entries keeps the iterators valid. A route added during a walk
+   * may or may not be visited, provided the walk compares against a fresh End () at each
+   * step: the iterator stops at the current end of the table, not at its end when the walk
+   * began.
+   */
+  class ConstIterator
+  {
+public:
+    ConstIterator ()
+      : m_filter (ALL_ROUTES)
+    {
+    }
+    RouteView const &
+    operator* () const
+    {
+      return m_view;
+    }
+    RouteView const *
+    operator-> () const
+    {
+      return &m_view;
+    }
+    ConstIterator &
+    operator++ ()
+    {
+      ++m_view.m_slot;
+      Skip ();
+      return *this;
+    }
+    bool
+    operator== (ConstIterator const & o) const
+    {
+      return m_view.m_slot == o.m_view.m_slot;
+    }
+    bool
+    operator!= (ConstIterator const & o) const
+    {
+      return m_view.m_slot != o.m_view.m_slot;
+    }
+
+private:
+    friend class RoutingTable;
+    ConstIterator (RoutingTable const *table, uint32_t slot, RouteFilter filter)
+      : m_view (table, slot),
+        m_filter (filter)
+    {
+      Skip ();
+    }
+    void
+    Skip ()
+    {
+      while (m_view.m_slot < m_view.m_table->m_hostRoutes.GetEnd ()
+             && !m_view.m_table->IsInView (m_view.m_slot, m_filter))
+        {
+          ++m_view.m_slot;
+        }
+    }
+    RouteView m_view;
+    RouteFilter m_filter;
+  };
+
+  /**
+   * \brief Read-only iterator over the valid host routes whose entries changed flag is set
+   *
+   * It walks the list of changed entries the table keeps up to date, not the whole table.
+   * Updating or deleting the visited entry invalidates the iterator: move it past the entry first.
+   */
+  class ChangedIterator
+  {
 public:
+    ChangedIterator ()
+    {
+    }
+    RouteView const &
+    operator* () const
+    {
+      m_view.m_slot = *m_it;
+      return m_view;
+    }
+    RouteView const *
+    operator-> () const
+    {
+      m_view.m_slot = *m_it;
+      return &m_view;
+    }
+    ChangedIterator &
+    operator++ ()
+    {
+      ++m_it;
+      return *this;
+    }
+    bool
+    operator== (ChangedIterator const & o) const
+    {
+      return m_it == o.m_it;
+    }
+    bool
+    operator!= (ChangedIterator const & o) const
+    {
+      return m_it != o.m_it;
+    }
+
+private:
+    friend class RoutingTable;
+    ChangedIterator (RoutingTable const *table, ChangedSet::const_iterator it)
+      : m_view (table, RouteStore::NONE),
+        m_it (it)
+    {
+    }
+    mutable RouteView m_view;
+    ChangedSet::const_iterator m_it;
+  };
+
   /// c-tor
   RoutingTable ();
   /**
-   * Add routing table entry if it doesn't yet exist in routing table
+   * Add routing table entry if it doesn't yet exist in routing table.
+   * Entries with a prefix length below 128 are stored as prefix routes.
    * \param r routing table entry
    * \return true in success
    */
@@ -235,6 +749,12 @@ public:
    */
   bool
   DeleteRoute (Ipv6Address dst);
+  /**
+   * Delete the prefix route prefix/prefixLength, if it exists.
+   * \return true on success
+   */
+  bool
+  DeleteRoute (Ipv6Address prefix, uint8_t prefixLength);
   /**
    * Lookup routing table entry with destination address dst
    * \param dst destination address
@@ -245,6 +765,31 @@ public:
   LookupRoute (Ipv6Address dst, RoutingTableEntry & rt);
   bool
   LookupRoute (Ipv6Address id, RoutingTableEntry & rt, bool forRouteInput);
+  /**
+   * Lookup the prefix route with exactly prefix/prefixLength
+   * \param rt the prefix route, if exists
+   * \return true on success
+   */
+  bool
+  LookupRoute (Ipv6Address prefix, uint8_t prefixLength, RoutingTableEntry & rt);
+  /**
+   * Lookup the most specific entry covering dst: the host entry of dst if any,
+   * otherwise the prefix route with the longest matching prefix.
+   * \param dst destination address
+   * \param rt the matching entry, if exists
+   * \return true on success
+   */
+  bool
+  LookupLongestMatch (Ipv6Address dst, RoutingTableEntry & rt);
+  /**
+   * Lookup the route to forward a packet to destination address dst, i.e. the
+   * route of the entry itself for neighbors and the route of its next hop otherwise.
+   * Destinations without a host entry fall back to the longest matching prefix route.
+   * \param dst destination address
+   * \return the resolved route, or 0 if dst or its next hop is unknown
+   */
+  Ptr<Ipv6Route>
+  LookupResolvedRoute (Ipv6Address dst);
   /**
    * Updating the routing Table with routing table entry rt
    * \param rt routing table entry
@@ -265,81 +810,140 @@ public:
    */
   void
   GetListOfAllRoutes (std::map<Ipv6Address, RoutingTableEntry> & allRoutes);
+  /**
+   * Lookup list of all prefix routes, in address order
+   * \param prefixRoutes is the list that will hold the prefix routes
+   */
+  void
+  GetListOfPrefixRoutes (std::vector<RoutingTableEntry> & prefixRoutes) const;
+  /**
+   * Iterate over the host routes without copying them
+   * \param filter the routes to visit
+   * \return an iterator on the first route of the view
+   */
+  ConstIterator
+  Begin (RouteFilter filter = VALID_ROUTES) const
+  {
+    return ConstIterator (this, 0, filter);
+  }
+  /// \return the end iterator of the views of the host routes
+  ConstIterator
+  End () const
+  {
+    return ConstIterator (this, m_hostRoutes.GetEnd (), ALL_ROUTES);
+  }
+  /// \return an iterator on the first changed valid host route
+  ChangedIterator
+  BeginChanged () const
+  {
+    return ChangedIterator (this, m_changedEntries.begin ());
+  }
+  /// \return the end iterator of the changed valid host routes
+  ChangedIterator
+  EndChanged () const
+  {
+    return ChangedIterator (this, m_changedEntries.end ());
+  }
   /// Delete all route from interface with address iface
   void
   DeleteAllRoutesFromInterface (Ipv6InterfaceAddress iface);
   /// Delete all entries from routing table
   void
-  Clear ()
-  {
-    m_ipv6AddressEntry.clear ();
-  }
-  /// Delete all outdated entries if Lifetime is expired
+  Clear ();
+  /**
+   * Delete all outdated entries if Lifetime is expired, together with the routes
+   * that use an expired destination as their next hop. Only the entries due in
+   * the expiry index are visited.
+   * \param removedAddresses receives the deleted entries
+   */
   void
   Purge (std::map<Ipv6Address, RoutingTableEntry> & removedAddresses);
+  /**
+   * Get the time at which the next route expires.
+   * \param expiry the absolute expiry time of the first route to expire
+   * \return false if no route can expire
+   */
+  bool
+  GetNextExpiry (Time & expiry);
   /// Print routing table
   void
   Print (Ptr<OutputStreamWrapper> stream) const;
+  /**
+   * Set the callback of the destinations that become reachable: those of the valid host
+   * routes that are added or made valid, and those using them as next hop. The callback
+   * must not change the table.
+   */
+  void
+  SetRouteArrivalCallback (RouteArrivalCallback cb)
+  {
+    m_routeArrival = cb;
+  }
+  /// Share the next hop routes of the entries with the other tables using pool
+  void
+  SetNextHopPool (Ptr<NextHopPool> pool);
+  Ptr<NextHopPool>
+  GetNextHopPool () const
+  {
+    return m_nextHops;
+  }
   /// Provides the number of routes present in that nodes routing table.
   uint32_t
   RoutingTableSize ();
-  /**
-  * Add an event for a destination address so that the update to for that destination is sent
-  * after the event is completed.
-  * \param address destination address for which this event is running.
-  * \param id unique eventid that was generated.
-  */
-  bool
-  AddIpv6Event (Ipv6Address address, EventId id);
-  /**
-  * Clear up the entry from the map after the event is completed
-  * \param address destination address for which this event is running.
-  * \return true on success
-  */
-  bool
-  DeleteIpv6Event (Ipv6Address address);
-  /**
-  * Force delete an update waiting for settling time to complete as a better update to
-  * same destination was received.
-  * \param address destination address for which this event is running.
-  * \return true on success
-  */
-  bool
-  AnyRunningEvent (Ipv6Address address);
-  /**
-  * Force delete an update waiting for settling time to complete as a better update to
-  * same destination was received.
-  * \param address destination address for which this event is running.
-  * \return true on finding out that an event is already running for that destination address.
-  */
-  bool
-  ForceDeleteIpv6Event (Ipv6Address address);
-  /**
-    * Get the EcentId associated with that address.
-    * \param address destination address for which this event is running.
-    * \return EventId on finding out an event is associated else return NULL.
-    */
-  EventId
-  GetEventId (Ipv6Address address);
   ///\name Handle life time of invalid route
   // \{
   Time Getholddowntime () const
   {
     return m_holddownTime;
   }
-  void Setholddowntime (Time t)
-  {
-    m_holddownTime = t;
-  }
+  void Setholddowntime (Time t);
   // \}
 
 private:
+  /// \return true if the view of filter shows the route in slot
+  bool
+  IsInView (uint32_t slot, RouteFilter filter) const;
+  /// Copy the host route in slot to rt
+  void
+  Load (uint32_t slot, RoutingTableEntry & rt) const;
+  /// Copy rt to the host route in slot
+  void
+  Store (uint32_t slot, RoutingTableEntry const & rt);
+  /// Erase the host route in slot
+  void
+  EraseEntry (uint32_t slot);
+  /// Notify the arrival of the route in slot and of the routes using it as next hop
+  void
+  NotifyArrival (uint32_t slot) const;
+  /// Add the route in slot to the changed entries, or drop it, after its flags
+  void
+  TrackChanged (uint32_t slot);
+  /// Push the lifetime deadline of an entry in the expiry index
+  void
+  PushExpiry (RoutingTableEntry const & rt);
+  /// \return true if the host route to dst still expires at expire
+  bool
+  IsCurrentDeadline (Ipv6Address dst, Time expire) const;
+  /// Refer the entry to the shared route of its next hop
+  void
+  ShareRoute (RoutingTableEntry & rt);
+  /// Resolve the forwarding route of a route of hops hops through route
+  Ptr<Ipv6Route>
+  ResolveRoute (uint32_t hops, Ptr<Ipv6Route> route) const;
+
   ///\name Fields
   // \{
-  /// an entry in the routing table.
-  std::map<Ipv6Address, RoutingTableEntry> m_ipv6AddressEntry;
-  /// an entry in the event table.
-  std::map<Ipv6Address, EventId> m_ipv6Events;
+  /// Host routes
+  RouteStore m_hostRoutes;
+  /// Expiry index of the host routes
+  DeadlineIndex<RoutingTable> m_expiryIndex;
+  /// Slots of the valid host routes whose entries changed flag is set
+  ChangedSet m_changedEntries;
+  /// Prefix routes, matched by longest prefix. They do not expire with the hold down time.
+  RadixTrie<RoutingTableEntry> m_prefixEntry;
+  /// Next hop routes of the entries
+  Ptr<NextHopPool> m_nextHops;
+  /// Callback of the destinations that become reachable
+  RouteArrivalCallback m_routeArrival;
   ///
   Time m_holddownTime;
   // \}
@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "rpl-timer-wheel.h"
+#include "rpl-conf.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("RplTimerWheel");
+
+namespace ns3 {
+namespace rpl {
+
+TimerWheel::TimerWheel ()
+  : m_slots (RPL_SETTLING_WHEEL_SLOTS),
+    m_tick (MilliSeconds (500)),
+    m_armedTick (0),
+    m_timer (Timer::CANCEL_ON_DESTROY)
+{
+  m_timer.SetFunction (&TimerWheel::Expire, this);
+}
+
+void
+TimerWheel::SetTick (Time tick)
+{
+  NS_ASSERT (tick.IsStrictlyPositive ());
+  // the ticks of the pending destinations change with the tick duration
+  std::vector<std::pair<Ipv6Address, Time> > pending;
+  for (PendingMap::const_iterator i = m_pending.begin (); i != m_pending.end (); ++i)
+    {
+      pending.push_back (std::make_pair (i->first, Time (static_cast<int64_t> (i->second) * m_tick.GetTimeStep ())));
+    }
+  Clear ();
+  m_tick = tick;
+  for (std::vector<std::pair<Ipv6Address, Time> >::const_iterator i = pending.begin (); i != pending.end (); ++i)
+    {
+      Time delay = i->second - Simulator::Now ();
+      Schedule (i->first, delay < Seconds (0) ? Seconds (0) : delay);
+    }
+}
+
+uint64_t
+TimerWheel::GetTick (Time t) const
+{
+  int64_t step = m_tick.GetTimeStep ();
+  return (t.GetTimeStep () + step - 1) / step;
+}
+
+void
+TimerWheel::Schedule (Ipv6Address dst, Time delay)
+{
+  uint64_t tick = GetTick (Simulator::Now () + delay);
+  PendingMap::iterator i = m_pending.find (dst);
+  if (i != m_pending.end ())
+    {
+      if (i->second == tick)
+        {
+          return;
+        }
+      Unlink (dst, i->second);
+      i->second = tick;
+    }
+  else
+    {
+      m_pending.insert (std::make_pair (dst, tick));
+    }
+  Entry entry;
+  entry.dst = dst;
+  entry.tick = tick;
+  m_slots[tick % m_slots.size ()].push_back (entry);
+  NS_LOG_LOGIC ("Settling time of " << dst << " ends in tick " << tick);
+  if (!m_timer.IsRunning () || tick < m_armedTick)
+    {
+      Arm (tick);
+    }
+}
+
+bool
+TimerWheel::Cancel (Ipv6Address dst)
+{
+  PendingMap::iterator i = m_pending.find (dst);
+  if (i == m_pending.end ())
+    {
+      return false;
+    }
+  Unlink (dst, i->second);
+  m_pending.erase (i);
+  if (m_pending.empty ())
+    {
+      m_timer.Cancel ();
+    }
+  return true;
+}
+
+bool
+TimerWheel::IsPending (Ipv6Address dst) const
+{
+  return m_pending.find (dst) != m_pending.end ();
+}
+
+void
+TimerWheel::Clear ()
+{
+  m_timer.Cancel ();
+  m_pending.clear ();
+  for (std::vector<Slot>::iterator s = m_slots.begin (); s != m_slots.end (); ++s)
+    {
+      s->clear ();
+    }
+}
+
+void
+TimerWheel::Unlink (Ipv6Address dst, uint64_t tick)
+{
+  Slot & slot = m_slots[tick % m_slots.size ()];
+  for (Slot::iterator e = slot.begin (); e != slot.end (); ++e)
+    {
+      if (e->dst == dst)
+        {
+          *e = slot.back ();
+          slot.pop_back ();
+          return;
+        }
+    }
+}
+
+void
+TimerWheel::ArmNext (uint64_t tick)
+{
+  if (m_pending.empty ())
+    {
+      return;
+    }
+  for (uint64_t t = tick; t < tick + m_slots.size (); ++t)
+    {
+      Slot const & slot = m_slots[t % m_slots.size ()];
+      for (Slot::const_iterator e = slot.begin (); e != slot.end (); ++e)
+        {
+          if (e->tick == t)
+            {
+              Arm (t);
+              return;
+            }
+        }
+    }
+  // no destination is due in this turn of the wheel
+  uint64_t next = m_pending.begin ()->second;
+  for (PendingMap::const_iterator i = m_pending.begin (); i != m_pending.end (); ++i)
+    {
+      if (i->second < next)
+        {
+          next = i->second;
+        }
+    }
+  Arm (next);
+}
+
+void
+TimerWheel::Arm (uint64_t tick)
+{
+  Time end = Time (static_cast<int64_t> (tick) * m_tick.GetTimeStep ());
+  Time delay = end - Simulator::Now ();
+  m_timer.Cancel ();
+  m_armedTick = tick;
+  m_timer.Schedule (delay < Seconds (0) ? Seconds (0) : delay);
+}
+
+void
+TimerWheel::Expire ()
+{
+  uint64_t tick = m_armedTick;
+  Slot & slot = m_slots[tick % m_slots.size ()];
+  uint32_t expired = 0;
+  for (uint32_t i = 0; i < slot.size (); )
+    {
+      if (slot[i].tick == tick)
+        {
+          m_pending.erase (slot[i].dst);
+          slot[i] = slot.back ();
+          slot.pop_back ();
+          ++expired;
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  ArmNext (tick + 1);
+  NS_LOG_LOGIC (expired << " settling times ended in tick " << tick);
+  if (expired > 0 && !m_expireCallback.IsNull ())
+    {
+      m_expireCallback ();
+    }
+}
+
+} // namespace rpl
+} // namespace ns3
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RPL_TIMER_WHEEL_H
+#define RPL_TIMER_WHEEL_H
+
+#include <vector>
+#include "ns3/sgi-hashmap.h"
+#include "ns3/callback.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/nstime.h"
+#include "ns3/timer.h"
+
+namespace ns3 {
+namespace rpl {
+
+/**
+ * \ingroup rpl
+ * \brief Hashed timer wheel of the settling times of the advertised routes
+ *
+ * Time is cut in ticks. A destination waits in the slot of the tick its
+ * settling time ends in, rounded up; the slots are reused every turn of the
+ * wheel. A single timer is pending, for the next tick a destination is due
+ * in: the destinations due in the same tick expire together, and the expire
+ * callback runs once for all of them.
+ */
+class TimerWheel
+{
+public:
+  /// Called when destinations expired
+  typedef Callback<void> ExpireCallback;
+
+  /// c-tor
+  TimerWheel ();
+  void
+  SetExpireCallback (ExpireCallback cb)
+  {
+    m_expireCallback = cb;
+  }
+  /**
+   * Set the duration of a tick. The pending destinations are rescheduled on
+   * the new ticks.
+   * \param tick the duration of a tick, strictly positive
+   */
+  void
+  SetTick (Time tick);
+  Time
+  GetTick () const
+  {
+    return m_tick;
+  }
+  /**
+   * Schedule the expiry of a destination, replacing its pending one if any
+   * \param dst the destination
+   * \param delay the settling time of dst
+   */
+  void
+  Schedule (Ipv6Address dst, Time delay);
+  /**
+   * Cancel the expiry of a destination
+   * \param dst the destination
+   * \return true if dst was pending
+   */
+  bool
+  Cancel (Ipv6Address dst);
+  /// \return true if the expiry of dst is pending
+  bool
+  IsPending (Ipv6Address dst) const;
+  /// \return the number of pending destinations
+  uint32_t
+  GetNPending () const
+  {
+    return m_pending.size ();
+  }
+  /// Cancel all expiries
+  void
+  Clear ();
+
+private:
+  /// Destination waiting in a slot
+  struct Entry
+  {
+    Ipv6Address dst;
+    uint64_t tick;
+  };
+  typedef std::vector<Entry> Slot;
+  typedef sgi::hash_map<Ipv6Address, uint64_t, Ipv6AddressHash> PendingMap;
+
+  /// \return the tick t ends in
+  uint64_t
+  GetTick (Time t) const;
+  /// Remove dst, due in tick, from its slot
+  void
+  Unlink (Ipv6Address dst, uint64_t tick);
+  /// Arm the timer for the first tick from tick on a destination is due in
+  void
+  ArmNext (uint64_t tick);
+  /// Arm the timer for the end of tick
+  void
+  Arm (uint64_t tick);
+  /// Timer handler: expire the destinations due in the armed tick
+  void
+  Expire ();
+
+  /// The slots, by tick modulo their number
+  std::vector<Slot> m_slots;
+  /// Tick of each pending destination
+  PendingMap m_pending;
+  /// Duration of a tick
+  Time m_tick;
+  /// Tick the timer is armed for
+  uint64_t m_armedTick;
+  /// Timer of the next tick a destination is due in
+  Timer m_timer;
+  ExpireCallback m_expireCallback;
+};
+
+} // namespace rpl
+} // namespace ns3
+
+#endif /* RPL_TIMER_WHEEL_H */
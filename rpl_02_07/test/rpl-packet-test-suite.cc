@@ -0,0 +1,547 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/buffer.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/rpl-packet.h"
+
+namespace ns3 {
+namespace rpl {
+
+/// Serialize a header alone in a buffer
+static Buffer
+WriteHeader (Header const & header)
+{
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+  header.Serialize (buffer.Begin ());
+  return buffer;
+}
+
+/**
+ * \ingroup rpl
+ * \brief Varint and zigzag coding of the batched route updates
+ */
+class RplUpdateHeaderTestCase : public TestCase
+{
+public:
+  RplUpdateHeaderTestCase () : TestCase ("RplUpdateHeader round trip and truncated input")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+RplUpdateHeaderTestCase::DoRun ()
+{
+  // one octet hop count then two, sequence numbers going down and wrapping
+  std::vector<RplHeader> records;
+  records.push_back (RplHeader (Ipv6Address ("2001:1::200:ff:fe00:1"), 1, 10));
+  records.push_back (RplHeader (Ipv6Address ("2001:1::200:ff:fe00:2"), 300, 6));
+  records.push_back (RplHeader (Ipv6Address ("2001:1::200:ff:fe00:3"), 2, 0xfffffffe));
+
+  RplUpdateHeader update;
+  for (size_t n = 0; n < records.size (); ++n)
+    {
+      update.AddRecord (records[n]);
+    }
+  // count, prefix length, 15 shared octets, then suffix, hop count and delta
+  NS_TEST_ASSERT_MSG_EQ (update.GetSerializedSize (), 1 + 1 + 15 + 3 + 4 + 3, "Records are not compressed");
+
+  Buffer buffer = WriteHeader (update);
+  RplUpdateHeader copy;
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (buffer.Begin ()), buffer.GetSize (), "Update not read whole");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetNRecords (), records.size (), "Records lost");
+  for (size_t n = 0; n < records.size (); ++n)
+    {
+      RplHeader const & r = copy.GetRecords ()[n];
+      NS_TEST_ASSERT_MSG_EQ (r.GetDst (), records[n].GetDst (), "Destination of record " << n);
+      NS_TEST_ASSERT_MSG_EQ (r.GetHopCount (), records[n].GetHopCount (), "Hop count of record " << n);
+      NS_TEST_ASSERT_MSG_EQ (r.GetDstSeqno (), records[n].GetDstSeqno (), "Sequence number of record " << n);
+    }
+
+  for (uint32_t size = 0; size < buffer.GetSize (); ++size)
+    {
+      Buffer cut = buffer.CreateFragment (0, size);
+      RplUpdateHeader partial;
+      NS_TEST_ASSERT_MSG_EQ (partial.Deserialize (cut.Begin ()), 0, "Update truncated to " << size << " octets accepted");
+      NS_TEST_ASSERT_MSG_EQ (partial.GetNRecords (), 0, "Records read from an update truncated to " << size << " octets");
+    }
+
+  // destinations sharing 3 octets only
+  RplUpdateHeader spread;
+  spread.AddRecord (RplHeader (Ipv6Address ("2001:1::1"), 1, 2));
+  spread.AddRecord (RplHeader (Ipv6Address ("2001:2::1"), 3, 4));
+  buffer = WriteHeader (spread);
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (buffer.Begin ()), buffer.GetSize (), "Update not read whole");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetNRecords (), 2, "Records lost");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetRecords ()[0].GetDst (), Ipv6Address ("2001:1::1"), "Destination of record 0");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetRecords ()[1].GetDst (), Ipv6Address ("2001:2::1"), "Destination of record 1");
+
+  // an empty update
+  buffer = WriteHeader (RplUpdateHeader ());
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (buffer.Begin ()), 2, "Empty update not read");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetNRecords (), 0, "Records read from an empty update");
+}
+
+/**
+ * \ingroup rpl
+ * \brief Writers and readers of the RPL control message options
+ */
+class RplOptionTestCase : public TestCase
+{
+public:
+  RplOptionTestCase () : TestCase ("RplOption round trip and truncated input")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+RplOptionTestCase::DoRun ()
+{
+  rpl_metric_container_t mc = rpl_metric_container_t ();
+  mc.type = RPL_DAG_MC_ETX;
+  mc.flags = RPL_DAG_MC_FLAG_P | RPL_DAG_MC_FLAG_R;
+  mc.aggr = RPL_DAG_MC_AGGR_MINIMUM;
+  mc.prec = 5;
+  mc.obj.etx = 0x1234;
+
+  rpl_prefix_t route = rpl_prefix_t ();
+  route.prefix = Ipv6Address ("2001:1:2::");
+  route.length = 48;
+  route.flags = 0x18;
+  route.lifetime = 0x01020304;
+
+  rpl_dio_t conf = rpl_dio_t ();
+  conf.dag_intdoubl = 8;
+  conf.dag_intmin = 12;
+  conf.dag_redund = 10;
+  conf.dag_max_rankinc = 1792;
+  conf.dag_min_hoprankinc = 256;
+  conf.ocp = RPL_OCP_MRHOF;
+  conf.default_lifetime = 30;
+  conf.lifetime_unit = 60;
+
+  rpl_prefix_t info = rpl_prefix_t ();
+  info.prefix = Ipv6Address ("2001:1::");
+  info.length = 64;
+  info.flags = 0x40;
+  info.lifetime = 0xffffffff;
+
+  rpl_dao_target_t target = rpl_dao_target_t ();
+  target.prefix = Ipv6Address ("2001:1::200:ff:fe00:5");
+  target.prefix_len = 128;
+  target.parent = Ipv6Address ("2001:1::200:ff:fe00:1");
+  target.path_sequence = 7;
+  target.lifetime = 30;
+
+  uint32_t size = 1 + RplOption::GetMetricContainerSize (mc) + 4
+    + RplOption::GetRouteInfoSize (route) + RplOption::DAG_CONF_SIZE
+    + RplOption::PREFIX_INFO_SIZE + RplOption::GetTargetSize (target)
+    + RplOption::GetTransitSize (target);
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  Buffer::Iterator i = buffer.Begin ();
+  RplOption::WritePad (i, 1);
+  RplOption::WriteMetricContainer (i, mc);
+  RplOption::WritePad (i, 4);
+  RplOption::WriteRouteInfo (i, route);
+  RplOption::WriteDagConf (i, conf);
+  RplOption::WritePrefixInfo (i, info);
+  RplOption::WriteTarget (i, target);
+  RplOption::WriteTransit (i, target);
+  NS_TEST_ASSERT_MSG_EQ (i.GetDistanceFrom (buffer.Begin ()), size, "Options larger than their sizes");
+
+  // the pads are skipped, the other options come in order
+  static const uint8_t types[] = { RPL_OPTION_DAG_METRIC_CONTAINER,
+                                   RPL_OPTION_ROUTE_INFO,
+                                   RPL_OPTION_DAG_CONF,
+                                   RPL_OPTION_PREFIX_INFO,
+                                   RPL_OPTION_TARGET,
+                                   RPL_OPTION_TRANSIT };
+  static const uint32_t nOptions = sizeof (types) / sizeof (types[0]);
+  Buffer::Iterator bodies[nOptions];
+  uint8_t lens[nOptions];
+  uint32_t left = size;
+  uint8_t type;
+  i = buffer.Begin ();
+  for (uint32_t n = 0; n < nOptions; ++n)
+    {
+      NS_TEST_ASSERT_MSG_EQ (RplOption::Next (i, left, type, lens[n], bodies[n]), true, "Option " << n << " not found");
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) type, (uint32_t) types[n], "Type of option " << n);
+    }
+  NS_TEST_ASSERT_MSG_EQ (RplOption::Next (i, left, type, lens[0], bodies[0]), false, "Option found past the end");
+  NS_TEST_ASSERT_MSG_EQ (left, 0, "Options not read whole");
+
+  rpl_metric_container_t mcCopy = rpl_metric_container_t ();
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadMetricContainer (bodies[0], lens[0], mcCopy), true, "Metric container rejected");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) mcCopy.type, (uint32_t) mc.type, "Metric type");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) mcCopy.flags, (uint32_t) mc.flags, "Metric flags");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) mcCopy.aggr, (uint32_t) mc.aggr, "Metric aggregation");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) mcCopy.prec, (uint32_t) mc.prec, "Metric precedence");
+  NS_TEST_ASSERT_MSG_EQ (mcCopy.obj.etx, mc.obj.etx, "ETX");
+
+  rpl_prefix_t routeCopy = rpl_prefix_t ();
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadRouteInfo (bodies[1], lens[1], routeCopy), true, "Route information rejected");
+  NS_TEST_ASSERT_MSG_EQ (routeCopy.prefix, route.prefix, "Route prefix");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) routeCopy.length, (uint32_t) route.length, "Route prefix length");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) routeCopy.flags, (uint32_t) route.flags, "Route flags");
+  NS_TEST_ASSERT_MSG_EQ (routeCopy.lifetime, route.lifetime, "Route lifetime");
+
+  rpl_dio_t confCopy = rpl_dio_t ();
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadDagConf (bodies[2], lens[2], confCopy), true, "DAG configuration rejected");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) confCopy.dag_intdoubl, (uint32_t) conf.dag_intdoubl, "Interval doublings");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) confCopy.dag_intmin, (uint32_t) conf.dag_intmin, "Minimum interval");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) confCopy.dag_redund, (uint32_t) conf.dag_redund, "Redundancy constant");
+  NS_TEST_ASSERT_MSG_EQ (confCopy.dag_max_rankinc, conf.dag_max_rankinc, "MaxRankIncrease");
+  NS_TEST_ASSERT_MSG_EQ (confCopy.dag_min_hoprankinc, conf.dag_min_hoprankinc, "MinHopRankIncrease");
+  NS_TEST_ASSERT_MSG_EQ (confCopy.ocp, conf.ocp, "OCP");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) confCopy.default_lifetime, (uint32_t) conf.default_lifetime, "Default lifetime");
+  NS_TEST_ASSERT_MSG_EQ (confCopy.lifetime_unit, conf.lifetime_unit, "Lifetime unit");
+
+  rpl_prefix_t infoCopy = rpl_prefix_t ();
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadPrefixInfo (bodies[3], lens[3], infoCopy), true, "Prefix information rejected");
+  NS_TEST_ASSERT_MSG_EQ (infoCopy.prefix, info.prefix, "Prefix");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) infoCopy.length, (uint32_t) info.length, "Prefix length");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) infoCopy.flags, (uint32_t) info.flags, "Prefix flags");
+  NS_TEST_ASSERT_MSG_EQ (infoCopy.lifetime, info.lifetime, "Prefix lifetime");
+
+  rpl_dao_target_t targetCopy = rpl_dao_target_t ();
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadTarget (bodies[4], lens[4], targetCopy), true, "Target rejected");
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadTransit (bodies[5], lens[5], targetCopy), true, "Transit rejected");
+  NS_TEST_ASSERT_MSG_EQ (targetCopy.prefix, target.prefix, "Target prefix");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) targetCopy.prefix_len, (uint32_t) target.prefix_len, "Target prefix length");
+  NS_TEST_ASSERT_MSG_EQ (targetCopy.parent, target.parent, "Transit parent");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) targetCopy.path_sequence, (uint32_t) target.path_sequence, "Path sequence");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) targetCopy.lifetime, (uint32_t) target.lifetime, "Path lifetime");
+
+  // bodies one octet shorter than their option requires
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadMetricContainer (bodies[0], lens[0] - 1, mcCopy), false, "Short metric container accepted");
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadRouteInfo (bodies[1], lens[1] - 1, routeCopy), false, "Short route information accepted");
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadDagConf (bodies[2], lens[2] - 1, confCopy), false, "Short DAG configuration accepted");
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadPrefixInfo (bodies[3], lens[3] - 1, infoCopy), false, "Short prefix information accepted");
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadTarget (bodies[4], lens[4] - 1, targetCopy), false, "Short target accepted");
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadTransit (bodies[5], 3, targetCopy), false, "Short transit accepted");
+  // a Transit without its parent address is that of a storing DAG
+  NS_TEST_ASSERT_MSG_EQ (RplOption::ReadTransit (bodies[5], 4, targetCopy), true, "Storing mode transit rejected");
+  NS_TEST_ASSERT_MSG_EQ (targetCopy.parent, Ipv6Address::GetAny (), "Parent read past the option");
+
+  // an option running past the end of the message ends the walk
+  left = size - 1;
+  i = buffer.Begin ();
+  uint32_t found = 0;
+  while (RplOption::Next (i, left, type, lens[0], bodies[0]))
+    {
+      found++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (found, nOptions - 1, "Truncated option found");
+}
+
+/**
+ * \ingroup rpl
+ * \brief DIO base object and options
+ */
+class DioTestCase : public TestCase
+{
+public:
+  DioTestCase () : TestCase ("DIOPacket round trip and truncated input")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+DioTestCase::DoRun ()
+{
+  rpl_dio_t dio = rpl_dio_t ();
+  dio.instance_id = 30;
+  dio.version = 240;
+  dio.rank = 768;
+  dio.grounded = 1;
+  dio.mop = RPL_MOP_NON_STORING;
+  dio.preference = 3;
+  dio.dtsn = 17;
+  dio.dag_id = Ipv6Address ("2001:1::200:ff:fe00:1");
+  dio.dag_intdoubl = 6;
+  dio.dag_intmin = 10;
+  dio.dag_redund = 5;
+  dio.dag_max_rankinc = 1024;
+  dio.dag_min_hoprankinc = 128;
+  dio.ocp = RPL_OCP_OF0;
+  dio.default_lifetime = 20;
+  dio.lifetime_unit = 120;
+  dio.mc.type = RPL_DAG_MC_ETX;
+  dio.mc.obj.etx = 384;
+  dio.destination_prefix.prefix = Ipv6Address ("2001:2::");
+  dio.destination_prefix.length = 32;
+  dio.destination_prefix.lifetime = 600;
+  dio.prefix_info.prefix = Ipv6Address ("2001:1::");
+  dio.prefix_info.length = 64;
+  dio.prefix_info.lifetime = 3600;
+
+  DIOPacket packet;
+  packet.SetDio (dio);
+  Buffer buffer = WriteHeader (packet);
+  DIOPacket copy;
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (buffer.Begin ()), buffer.GetSize (), "DIO not read whole");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetType (), ICMP6_RPL, "ICMPv6 type");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetCode (), RPL_CODE_DIO, "ICMPv6 code");
+  rpl_dio_t got = copy.GetDio ();
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.instance_id, (uint32_t) dio.instance_id, "Instance");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.version, (uint32_t) dio.version, "Version");
+  NS_TEST_ASSERT_MSG_EQ (got.rank, dio.rank, "Rank");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.grounded, (uint32_t) dio.grounded, "Grounded");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.mop, (uint32_t) dio.mop, "MOP");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.preference, (uint32_t) dio.preference, "Preference");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.dtsn, (uint32_t) dio.dtsn, "DTSN");
+  NS_TEST_ASSERT_MSG_EQ (got.dag_id, dio.dag_id, "DODAG ID");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.dag_intmin, (uint32_t) dio.dag_intmin, "Minimum interval");
+  NS_TEST_ASSERT_MSG_EQ (got.dag_min_hoprankinc, dio.dag_min_hoprankinc, "MinHopRankIncrease");
+  NS_TEST_ASSERT_MSG_EQ (got.ocp, dio.ocp, "OCP");
+  NS_TEST_ASSERT_MSG_EQ (got.lifetime_unit, dio.lifetime_unit, "Lifetime unit");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.mc.type, (uint32_t) dio.mc.type, "Metric type");
+  NS_TEST_ASSERT_MSG_EQ (got.mc.obj.etx, dio.mc.obj.etx, "ETX");
+  NS_TEST_ASSERT_MSG_EQ (got.destination_prefix.prefix, dio.destination_prefix.prefix, "Route prefix");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) got.destination_prefix.length, (uint32_t) dio.destination_prefix.length, "Route prefix length");
+  NS_TEST_ASSERT_MSG_EQ (got.prefix_info.prefix, dio.prefix_info.prefix, "Prefix");
+  NS_TEST_ASSERT_MSG_EQ (got.prefix_info.lifetime, dio.prefix_info.lifetime, "Prefix lifetime");
+
+  // a DIO shorter than its base object is rejected
+  for (uint32_t size = 0; size < 4 + 24; ++size)
+    {
+      Buffer cut = buffer.CreateFragment (0, size);
+      NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (cut.Begin ()), 0, "DIO truncated to " << size << " octets accepted");
+    }
+
+  // a truncated option is ignored, the DIO keeps the defaults
+  DIOPacket plain;
+  rpl_dio_t base = rpl_dio_t ();
+  base.dag_id = dio.dag_id;
+  base.dag_intmin = dio.dag_intmin;
+  base.prefix_info = dio.prefix_info;
+  plain.SetDio (base);
+  buffer = WriteHeader (plain);
+  Buffer cut = buffer.CreateFragment (0, 4 + 24 + RplOption::DAG_CONF_SIZE / 2);
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (cut.Begin ()) > 0, true, "DIO with a truncated option rejected");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetDagID (), dio.dag_id, "DODAG ID");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetDio ().dag_intmin, RPL_DIO_INTERVAL_MIN, "Truncated DAG configuration read");
+  cut = buffer.CreateFragment (0, 4 + 24 + RplOption::DAG_CONF_SIZE + RplOption::PREFIX_INFO_SIZE - 1);
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (cut.Begin ()) > 0, true, "DIO with a truncated option rejected");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetDio ().dag_intmin, (uint32_t) dio.dag_intmin, "DAG configuration lost");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetDio ().prefix_info.length, 0, "Truncated prefix information read");
+}
+
+/**
+ * \ingroup rpl
+ * \brief DAO base object, Target and Transit options
+ */
+class DaoTestCase : public TestCase
+{
+public:
+  DaoTestCase () : TestCase ("DAOPacket round trip and truncated input")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+DaoTestCase::DoRun ()
+{
+  rpl_dao_target_t targets[2];
+  targets[0] = rpl_dao_target_t ();
+  targets[0].prefix = Ipv6Address ("2001:1::200:ff:fe00:5");
+  targets[0].prefix_len = 128;
+  targets[0].parent = Ipv6Address ("2001:1::200:ff:fe00:2");
+  targets[0].path_sequence = 3;
+  targets[0].lifetime = 30;
+  targets[1] = targets[0];
+  targets[1].prefix = Ipv6Address ("2001:3::");
+  targets[1].prefix_len = 48;
+  targets[1].path_sequence = 4;
+  targets[1].lifetime = RPL_ZERO_LIFETIME;
+
+  // non-storing mode: DODAG ID and parent addresses
+  DAOPacket dao;
+  dao.SetInstanceID (30);
+  dao.SetFlagK (true);
+  dao.SetSequence (251);
+  dao.SetDagID (Ipv6Address ("2001:1::200:ff:fe00:1"));
+  dao.AddTarget (targets[0]);
+  dao.AddTarget (targets[1]);
+  Buffer buffer = WriteHeader (dao);
+  DAOPacket copy;
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (buffer.Begin ()), buffer.GetSize (), "DAO not read whole");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetCode (), RPL_CODE_DAO, "ICMPv6 code");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetInstanceID (), 30, "Instance");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetFlagK (), true, "K flag");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetFlagD (), true, "D flag");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetSequence (), 251, "Sequence");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetDagID (), dao.GetDagID (), "DODAG ID");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTargets ().size (), 2, "Targets lost");
+  for (size_t n = 0; n < 2; ++n)
+    {
+      rpl_dao_target_t const & t = copy.GetTargets ()[n];
+      NS_TEST_ASSERT_MSG_EQ (t.prefix, targets[n].prefix, "Prefix of target " << n);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) t.prefix_len, (uint32_t) targets[n].prefix_len, "Prefix length of target " << n);
+      NS_TEST_ASSERT_MSG_EQ (t.parent, targets[n].parent, "Parent of target " << n);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) t.path_sequence, (uint32_t) targets[n].path_sequence, "Path sequence of target " << n);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) t.lifetime, (uint32_t) targets[n].lifetime, "Path lifetime of target " << n);
+    }
+
+  // shorter than the base object, then than the DODAG ID
+  for (uint32_t size = 0; size < 4 + 4 + 16; ++size)
+    {
+      Buffer cut = buffer.CreateFragment (0, size);
+      NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (cut.Begin ()), 0, "DAO truncated to " << size << " octets accepted");
+      NS_TEST_ASSERT_MSG_EQ (copy.GetTargets ().size (), 0, "Targets read from a DAO truncated to " << size << " octets");
+    }
+
+  // the second target loses its Transit option, and is dropped
+  Buffer cut = buffer.CreateFragment (0, buffer.GetSize () - 1);
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (cut.Begin ()) > 0, true, "DAO with a truncated option rejected");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTargets ().size (), 1, "Target without transit information kept");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTargets ()[0].prefix, targets[0].prefix, "First target lost");
+
+  // storing mode: no DODAG ID, no parent address
+  targets[0].parent = Ipv6Address::GetAny ();
+  DAOPacket storing;
+  storing.AddTarget (targets[0]);
+  buffer = WriteHeader (storing);
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (buffer.Begin ()), buffer.GetSize (), "DAO not read whole");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetFlagD (), false, "D flag");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTargets ().size (), 1, "Target lost");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTargets ()[0].parent, Ipv6Address::GetAny (), "Parent in storing mode");
+
+  // a malformed Target is skipped, the Transit applies to the next one
+  buffer = Buffer ();
+  buffer.AddAtStart (4 + 4 + 3 + RplOption::GetTargetSize (targets[0]) + RplOption::GetTransitSize (targets[0]));
+  Buffer::Iterator i = buffer.Begin ();
+  i.WriteU8 (ICMP6_RPL);
+  i.WriteU8 (RPL_CODE_DAO);
+  i.WriteU16 (0);
+  i.WriteU8 (30);
+  i.WriteU8 (0);
+  i.WriteU8 (0);
+  i.WriteU8 (1);
+  i.WriteU8 (RPL_OPTION_TARGET);
+  i.WriteU8 (1);
+  i.WriteU8 (0);
+  RplOption::WriteTarget (i, targets[0]);
+  RplOption::WriteTransit (i, targets[0]);
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (buffer.Begin ()), buffer.GetSize (), "DAO with a malformed target not read whole");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTargets ().size (), 1, "Malformed target kept or valid one lost");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTargets ()[0].prefix, targets[0].prefix, "Valid target lost");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetTargets ()[0].lifetime, (uint32_t) targets[0].lifetime, "Transit not applied");
+}
+
+/**
+ * \ingroup rpl
+ * \brief CmprI and CmprE compression of the source routing header
+ */
+class SourceRoutingHeaderTestCase : public TestCase
+{
+public:
+  SourceRoutingHeaderTestCase () : TestCase ("SourceRoutingHeader round trip and truncated input")
+  {
+  }
+  virtual void DoRun ();
+
+private:
+  /**
+   * Check that a route survives serialization
+   * \param dst the IPv6 destination address, i.e. the first hop
+   * \param hops the next hops
+   * \param size the expected serialized size
+   */
+  void CheckRoute (Ipv6Address dst, std::vector<Ipv6Address> const & hops, uint32_t size);
+};
+
+void
+SourceRoutingHeaderTestCase::CheckRoute (Ipv6Address dst, std::vector<Ipv6Address> const & hops, uint32_t size)
+{
+  SourceRoutingHeader srh;
+  srh.SetNextHeader (41);
+  srh.SetRoute (dst, hops);
+  NS_TEST_ASSERT_MSG_EQ (srh.GetSerializedSize (), size, "Addresses not compressed");
+
+  Buffer buffer = WriteHeader (srh);
+  SourceRoutingHeader copy;
+  NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (buffer.Begin ()), size, "Header not read whole");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetNextHeader (), 41, "Next header");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) copy.GetSegmentsLeft (), hops.size (), "Segments left");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetNAddresses (), hops.size (), "Addresses lost");
+  for (uint32_t k = 1; k <= hops.size (); ++k)
+    {
+      NS_TEST_ASSERT_MSG_EQ (copy.GetAddress (k, dst), hops[k - 1], "Address " << k);
+    }
+
+  for (uint32_t cutSize = 0; cutSize < size; ++cutSize)
+    {
+      Buffer cut = buffer.CreateFragment (0, cutSize);
+      NS_TEST_ASSERT_MSG_EQ (copy.Deserialize (cut.Begin ()), 0, "Header truncated to " << cutSize << " octets accepted");
+      NS_TEST_ASSERT_MSG_EQ (copy.GetNAddresses (), 0, "Addresses read from a header truncated to " << cutSize << " octets");
+    }
+}
+
+void
+SourceRoutingHeaderTestCase::DoRun ()
+{
+  Ipv6Address dst ("2001:1::200:ff:fe00:2");
+  std::vector<Ipv6Address> hops;
+
+  // one hop, sharing 15 octets with the destination: padded to 8
+  hops.push_back (Ipv6Address ("2001:1::200:ff:fe00:3"));
+  CheckRoute (dst, hops, 8 + 8);
+
+  // three hops of the same /64: CmprI = CmprE = 15
+  hops.push_back (Ipv6Address ("2001:1::200:ff:fe00:4"));
+  hops.push_back (Ipv6Address ("2001:1::200:ff:fe00:5"));
+  CheckRoute (dst, hops, 8 + 8);
+
+  // a final destination outside the DODAG prefix: CmprE = 3
+  hops.push_back (Ipv6Address ("2001:2::1"));
+  CheckRoute (dst, hops, 8 + 3 * 1 + 13);
+
+  // intermediate hops sharing their /64 only with the destination: CmprI = 8
+  hops.clear ();
+  hops.push_back (Ipv6Address ("2001:1::3"));
+  hops.push_back (Ipv6Address ("2001:1::4"));
+  hops.push_back (Ipv6Address ("2001:1::5"));
+  CheckRoute (dst, hops, 8 + 2 * 8 + 1 + 7);
+}
+
+/**
+ * \ingroup rpl
+ * \brief Serialization of the RPL headers and options
+ */
+class RplPacketTestSuite : public TestSuite
+{
+public:
+  RplPacketTestSuite () : TestSuite ("rpl-packet", UNIT)
+  {
+    AddTestCase (new RplUpdateHeaderTestCase);
+    AddTestCase (new RplOptionTestCase);
+    AddTestCase (new DioTestCase);
+    AddTestCase (new DaoTestCase);
+    AddTestCase (new SourceRoutingHeaderTestCase);
+  }
+} g_rplPacketTestSuite;
+
+} // namespace rpl
+} // namespace ns3